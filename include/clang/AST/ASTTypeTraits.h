@@ -53,6 +53,15 @@ public:
     return ASTNodeKind(KindToKindId<T>::Id);
   }
 
+  /// \brief Construct an identifier for the dynamic type of the node.
+  /// @{
+  static ASTNodeKind getFromNode(const Decl &D);
+  static ASTNodeKind getFromNode(const Stmt &S);
+  /// @}
+
+  /// \brief Returns \c true if this is the empty identifier.
+  bool isNone() const { return KindId == NKI_None; }
+
   /// \brief Returns \c true if \c this and \c Other represent the same kind.
   bool isSame(ASTNodeKind Other) const;
 
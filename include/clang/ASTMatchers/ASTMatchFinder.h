@@ -111,6 +111,30 @@ public:
     virtual void run() = 0;
   };
 
+  /// \brief Counters describing the work done while matching.
+  ///
+  /// Accumulated over all calls to \c match() and \c matchAST().
+  struct MatchStatistics {
+    MatchStatistics();
+
+    /// \brief Recursive matches (has, hasDescendant, hasAncestor, ...)
+    /// answered from the memoization cache.
+    unsigned MemoizationHits;
+
+    /// \brief Recursive matches that had to be computed.
+    unsigned MemoizationMisses;
+
+    /// \brief Memoized results dropped to bound the size of the cache.
+    unsigned MemoizationEvictions;
+
+    /// \brief Times a registered matcher was run on a visited node.
+    unsigned MatcherInvocations;
+
+    /// \brief Times a registered matcher was not run on a visited node
+    /// because the matcher is restricted to a different kind of node.
+    unsigned SkippedMatcherInvocations;
+  };
+
   MatchFinder();
   ~MatchFinder();
 
@@ -173,6 +197,13 @@ public:
   /// Each call to FindAll(...) will call the closure once.
   void registerTestCallbackAfterParsing(ParsingDoneTestCallback *ParsingDone);
 
+  /// \brief Returns the counters accumulated since construction or the last
+  /// \c resetStatistics().
+  const MatchStatistics &getStatistics() const { return Statistics; }
+
+  /// \brief Resets all counters to zero.
+  void resetStatistics() { Statistics = MatchStatistics(); }
+
 private:
   /// \brief For each \c DynTypedMatcher a \c MatchCallback that will be called
   /// when it matches.
@@ -181,6 +212,8 @@ private:
 
   /// \brief Called when parsing is done.
   ParsingDoneTestCallback *ParsingDone;
+
+  MatchStatistics Statistics;
 };
 
 /// \brief Returns the results of matching \p Matcher on \p Node.
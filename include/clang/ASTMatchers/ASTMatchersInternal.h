@@ -184,6 +184,15 @@ public:
   virtual bool matches(const T &Node,
                        ASTMatchFinder *Finder,
                        BoundNodesTreeBuilder *Builder) const = 0;
+
+  /// \brief Returns the kind of node this matcher is restricted to.
+  ///
+  /// The matcher never matches a node unless the node is of this kind or a
+  /// kind derived from it, so it need not be run on other nodes.  Matchers
+  /// that dyn_cast the node to a derived type return that type's kind.
+  virtual ast_type_traits::ASTNodeKind getRestrictKind() const {
+    return ast_type_traits::ASTNodeKind::getFromNodeKind<T>();
+  }
 };
 
 /// \brief Interface for matchers that only evaluate properties on a single
@@ -205,6 +214,19 @@ private:
   }
 };
 
+/// \brief Returns \p InnerKind if it is at least as specific as \c T, and
+/// the kind of \c T otherwise.
+///
+/// Used by matchers that forward to an inner matcher to report the kind they
+/// are restricted to.
+template <typename T>
+ast_type_traits::ASTNodeKind
+restrictKindOf(ast_type_traits::ASTNodeKind InnerKind) {
+  const ast_type_traits::ASTNodeKind Kind =
+      ast_type_traits::ASTNodeKind::getFromNodeKind<T>();
+  return Kind.isBaseOf(InnerKind) ? InnerKind : Kind;
+}
+
 /// \brief Wrapper of a MatcherInterface<T> *that allows copying.
 ///
 /// A Matcher<Base> can be used anywhere a Matcher<Derived> is
@@ -253,6 +275,11 @@ public:
     return false;
   }
 
+  /// \brief Returns the kind of node the underlying matcher is restricted to.
+  ast_type_traits::ASTNodeKind getRestrictKind() const {
+    return Implementation->getRestrictKind();
+  }
+
   /// \brief Returns an ID that uniquely identifies the matcher.
   uint64_t getID() const {
     /// FIXME: Document the requirements this imposes on matcher
@@ -298,6 +325,10 @@ private:
       return From.matches(Node, Finder, Builder);
     }
 
+    virtual ast_type_traits::ASTNodeKind getRestrictKind() const {
+      return restrictKindOf<T>(From.getRestrictKind());
+    }
+
   private:
     const Matcher<Base> From;
   };
@@ -355,6 +386,14 @@ public:
     return Storage->getSupportedKind();
   }
 
+  /// \brief Returns the kind of node this matcher is restricted to.
+  ///
+  /// This is the supported kind or a kind derived from it; \c matches()
+  /// always returns false for nodes that are not of this kind.
+  ast_type_traits::ASTNodeKind getRestrictKind() const {
+    return Storage->getRestrictKind();
+  }
+
   /// \brief Returns \c true if the passed \c DynTypedMatcher can be converted
   ///   to a \c Matcher<T>.
   ///
@@ -396,6 +435,8 @@ private:
 
     virtual llvm::Optional<DynTypedMatcher> tryBind(StringRef ID) const = 0;
 
+    virtual ast_type_traits::ASTNodeKind getRestrictKind() const = 0;
+
     ast_type_traits::ASTNodeKind getSupportedKind() const {
       return SupportedKind;
     }
@@ -439,6 +480,10 @@ public:
     return DynTypedMatcher(BindableMatcher<T>(InnerMatcher).bind(ID));
   }
 
+  ast_type_traits::ASTNodeKind getRestrictKind() const LLVM_OVERRIDE {
+    return InnerMatcher.getRestrictKind();
+  }
+
 private:
   const Matcher<T> InnerMatcher;
   const bool AllowBind;
@@ -464,6 +509,10 @@ public:
                          Builder);
   }
 
+  virtual ast_type_traits::ASTNodeKind getRestrictKind() const {
+    return restrictKindOf<T>(Inner.getRestrictKind());
+  }
+
 private:
   const DynTypedMatcher Inner;
 };
@@ -1043,6 +1092,10 @@ public:
     return Result;
   }
 
+  virtual ast_type_traits::ASTNodeKind getRestrictKind() const {
+    return InnerMatcher.getRestrictKind();
+  }
+
 private:
   const std::string ID;
   const Matcher<T> InnerMatcher;
@@ -174,6 +174,10 @@ class FileManager : public RefCountedBase<FileManager> {
   bool getStatValue(const char *Path, FileData &Data, bool isFile,
                     int *FileDescriptor);
 
+  /// \brief Returns a new buffer holding the contents of \p Filename in the
+  /// overlay, or null if it is not in the overlay.
+  llvm::MemoryBuffer *getOverlayBuffer(StringRef Filename) const;
+
   /// Add all ancestors of the given path (pointing to either a file
   /// or a directory) as virtual directories.
   void addAncestorsAsVirtualDirs(StringRef Path);
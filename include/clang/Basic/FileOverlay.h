@@ -0,0 +1,78 @@
+//===--- FileOverlay.h - Files held in memory -------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the clang::FileOverlay interface.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FILEOVERLAY_H
+#define LLVM_CLANG_FILEOVERLAY_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace clang {
+
+/// \brief A set of files whose contents are held in memory, laid over the
+/// file system.
+///
+/// A FileManager with an overlay (see FileSystemOptions::Overlay) treats the
+/// files of the overlay as existing with the given contents, whatever is on
+/// disk.  Unlike remapped files, an overlay can be shared by any number of
+/// translation units, including ones processed concurrently, as long as it is
+/// not modified once they have started.
+///
+/// Files are matched by their canonical paths (see getCanonicalPath()), so
+/// that relative paths and spellings with "." or ".." components find them.
+/// Symbolic links are not resolved.
+class FileOverlay : public llvm::ThreadSafeRefCountedBase<FileOverlay> {
+  /// \brief The contents of each file by canonical path, owned by the
+  /// overlay.
+  llvm::StringMap<llvm::MemoryBuffer *> Files;
+
+  /// \brief The current directory when the overlay was created, which
+  /// relative paths are resolved against unless a working directory is given.
+  SmallString<128> CurrentDir;
+
+  FileOverlay(const FileOverlay &) LLVM_DELETED_FUNCTION;
+  void operator=(const FileOverlay &) LLVM_DELETED_FUNCTION;
+
+public:
+  FileOverlay();
+  ~FileOverlay();
+
+  /// \brief Computes the path \p Path is matched by: the absolute path,
+  /// resolved against \p WorkingDir if it is relative and \p WorkingDir is
+  /// not empty, without "." and ".." components and in native form.
+  void getCanonicalPath(StringRef Path, StringRef WorkingDir,
+                        SmallVectorImpl<char> &Result) const;
+
+  /// \brief Adds the file \p Path with a copy of \p Contents, replacing any
+  /// file added before with the same canonical path.
+  void addFile(StringRef Path, StringRef Contents);
+
+  /// \brief Returns the contents of the file \p Path, resolved against
+  /// \p WorkingDir if it is relative, or null if it is not in the overlay.
+  /// The identifier of the buffer is the canonical path of the file.
+  const llvm::MemoryBuffer *getFile(StringRef Path,
+                                    StringRef WorkingDir = StringRef()) const;
+
+  bool empty() const { return Files.empty(); }
+};
+
+} // end namespace clang
+
+#endif
@@ -15,6 +15,8 @@
 #ifndef LLVM_CLANG_BASIC_FILESYSTEMOPTIONS_H
 #define LLVM_CLANG_BASIC_FILESYSTEMOPTIONS_H
 
+#include "clang/Basic/FileOverlay.h"
+#include "clang/Basic/FileSystemStatCache.h"
 #include <string>
 
 namespace clang {
@@ -25,6 +27,14 @@ public:
   /// \brief If set, paths are resolved as if the working directory was
   /// set to the value of WorkingDir.
   std::string WorkingDir;
+
+  /// \brief If set, files whose contents are held in memory, which take
+  /// precedence over the file system.
+  IntrusiveRefCntPtr<FileOverlay> Overlay;
+
+  /// \brief If set, a store of 'stat' results shared with the other file
+  /// managers using it.
+  IntrusiveRefCntPtr<SharedStatCache> SharedStats;
 };
 
 } // end namespace clang
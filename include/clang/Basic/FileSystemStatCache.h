@@ -16,9 +16,11 @@
 #define LLVM_CLANG_FILESYSTEMSTATCACHE_H
 
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Mutex.h"
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -110,6 +112,84 @@ public:
                                int *FileDescriptor);
 };
 
+/// \brief The results of 'stat' calls, shared by the FileManagers of any
+/// number of translation units, which may be processed concurrently.
+///
+/// FileManagers consult the store through a \c SharedStatCalls cache (see
+/// FileSystemOptions::SharedStats).  Only absolute paths are recorded, as
+/// relative ones depend on the working directory.  Failed lookups are the
+/// bulk of the 'stat' calls made by header search, and are repeated by every
+/// translation unit, but they are only recorded if asked for: a file created
+/// while the store is in use, such as a generated header, would stay missing
+/// until the next revalidate().  Use revalidate() to pick up changes to the
+/// file system.
+class SharedStatCache : public llvm::ThreadSafeRefCountedBase<SharedStatCache> {
+  enum {
+    NotAFile = 1 << 0,     ///< A lookup of the path as a file failed.
+    NotADirectory = 1 << 1 ///< A lookup of the path as a directory failed.
+  };
+
+  struct Entry {
+    /// \brief Whether the path exists, in which case Data is valid.
+    bool Exists;
+    /// \brief The kinds of lookups that failed, if the path does not exist.
+    unsigned Missing;
+    FileData Data;
+  };
+
+  /// \brief Guards everything below.
+  mutable llvm::sys::Mutex Lock;
+
+  llvm::StringMap<Entry> Entries;
+
+  /// \brief Whether failed lookups are recorded.
+  const bool CacheFailures;
+
+  unsigned NumHits, NumMisses;
+
+public:
+  explicit SharedStatCache(bool CacheFailures = false)
+    : CacheFailures(CacheFailures), NumHits(0), NumMisses(0) {}
+
+  /// \brief Looks up the result of a 'stat' call on \p Path.
+  ///
+  /// \returns true if the result is known, in which case it is stored in
+  /// \p Result, along with \p Data if the path exists.
+  bool lookup(StringRef Path, bool isFile, FileData &Data,
+              FileSystemStatCache::LookupResult &Result);
+
+  /// \brief Records the result of a 'stat' call on \p Path.  Failures are
+  /// ignored unless the store was created to record them.
+  void insert(StringRef Path, bool isFile, const FileData &Data,
+              FileSystemStatCache::LookupResult Result);
+
+  /// \brief Forgets everything known about \p Path.
+  void invalidate(StringRef Path);
+
+  /// \brief Drops the files that were modified, replaced or removed since they
+  /// were recorded, as told by their size and modification time, and all
+  /// failed lookups.
+  void revalidate();
+
+  /// \brief Returns the number of lookups that were answered by the store.
+  unsigned getNumHits() const;
+
+  /// \brief Returns the number of lookups that were not.
+  unsigned getNumMisses() const;
+};
+
+/// \brief A stat cache which consults a \c SharedStatCache before the rest of
+/// the chain, and records what the rest of the chain finds there.
+class SharedStatCalls : public FileSystemStatCache {
+  IntrusiveRefCntPtr<SharedStatCache> Shared;
+
+public:
+  explicit SharedStatCalls(SharedStatCache *Shared) : Shared(Shared) {}
+
+  virtual LookupResult getStat(const char *Path, FileData &Data, bool isFile,
+                               int *FileDescriptor);
+};
+
 } // end namespace clang
 
 #endif
@@ -0,0 +1,102 @@
+//===--- KeyedLineStore.h - Keyed entries kept in a file --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the clang::KeyedLineStore interface.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_KEYEDLINESTORE_H
+#define LLVM_CLANG_KEYEDLINESTORE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include <string>
+
+namespace clang {
+
+/// \brief A text file of keyed entries, updated by the compilations of any
+/// number of translation units, including ones running concurrently.
+///
+/// The file holds one section for every header it was updated with.  The
+/// header names the format of the entries and whatever they depend on, such
+/// as a configuration, so that compilations with different configurations
+/// share the file without dropping each other's entries.  A section starts
+/// with a line holding '#', a space and the header.  Each of the following
+/// lines holds one entry: a fixed number of fields, each followed by a space,
+/// and then the key, which runs to the end of the line and may itself contain
+/// spaces.  Fields may not start with '#'.
+class KeyedLineStore {
+public:
+  /// \brief Maps the key of every entry to its fields, separated by spaces.
+  typedef llvm::StringMap<std::string> EntryMap;
+
+  /// \brief Combines the fields \p New recorded for a key with the fields
+  /// \p Old the file already holds for it.
+  typedef void (*MergeFn)(std::string &Old, StringRef New);
+
+private:
+  /// \brief The path of the file.
+  std::string Path;
+
+  /// \brief The expected first line of the file.
+  std::string Header;
+
+  /// \brief The number of fields of every entry.
+  unsigned NumFields;
+
+  /// \brief The number of sections the file keeps.
+  unsigned MaxSections;
+
+  /// \brief Reads the entries of the section of \p Buffer with the expected
+  /// header into \p Entries, and appends the other sections, as they are, to
+  /// \p OtherSections if it is given.
+  void parse(StringRef Buffer, EntryMap &Entries,
+             SmallVectorImpl<StringRef> *OtherSections) const;
+
+  /// \brief Replaces the file with one holding the section of \p Entries,
+  /// followed by \p OtherSections.
+  ///
+  /// \returns true on error.
+  bool write(const EntryMap &Entries, ArrayRef<StringRef> OtherSections) const;
+
+public:
+  /// \brief Uses the file \p Path, which keeps at most \p MaxSections
+  /// sections.  The sections updated least recently are dropped first.
+  KeyedLineStore(StringRef Path, StringRef Header, unsigned NumFields,
+                 unsigned MaxSections = 8)
+    : Path(Path), Header(Header), NumFields(NumFields),
+      MaxSections(MaxSections) {}
+
+  StringRef getPath() const { return Path; }
+
+  /// \brief Changes the header of the section read and updated.
+  void setHeader(StringRef Header) { this->Header = Header; }
+
+  /// \brief Reads the entries of the section with the expected header into
+  /// \p Entries, unless the file or the section does not exist.  Malformed
+  /// lines, such as a line cut short, are skipped.
+  void read(EntryMap &Entries) const;
+
+  /// \brief Merges \p Entries into the section with the expected header,
+  /// creating the file and its directory if needed.
+  ///
+  /// The file is locked while it is updated, and the entries are merged into
+  /// its current contents, as other translation units may have written it
+  /// since it was read.  An entry replaces the one with the same key, unless
+  /// \p Merge is given, in which case it decides.  The other sections are
+  /// kept.
+  ///
+  /// \returns true if the file could not be written.
+  bool update(const EntryMap &Entries, MergeFn Merge = 0) const;
+};
+
+} // end namespace clang
+
+#endif
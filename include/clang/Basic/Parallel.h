@@ -0,0 +1,44 @@
+//===--- Parallel.h - Running independent tasks concurrently ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines a minimal facility for running a batch of independent tasks
+/// on a fixed number of threads.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_PARALLEL_H
+#define LLVM_CLANG_BASIC_PARALLEL_H
+
+namespace clang {
+
+/// \brief Returns the number of threads the host can run concurrently, or 1
+/// if that cannot be determined.
+unsigned getNumHardwareThreads();
+
+/// \brief Returns true if runInParallel() can actually use more than one
+/// thread in this build of clang.
+bool isParallelExecutionSupported();
+
+/// \brief Invokes \p Fn(UserData, I) for every I in [0, NumTasks) using at
+/// most \p NumThreads threads, and returns once all tasks have completed.
+///
+/// Tasks are handed out in increasing index order, but may complete in any
+/// order.  The calling thread takes part in executing tasks, so passing a
+/// \p NumThreads of 0 or 1 runs every task on the calling thread.  When
+/// threads are not supported the tasks are run serially.
+///
+/// \p Fn must be safe to call concurrently from several threads.
+void runInParallel(unsigned NumTasks, unsigned NumThreads,
+                   void (*Fn)(void *UserData, unsigned TaskIndex),
+                   void *UserData);
+
+} // end namespace clang
+
+#endif
@@ -589,6 +589,12 @@ class SourceManager : public RefCountedBase<SourceManager> {
   /// expansion.
   SmallVector<SrcMgr::SLocEntry, 0> LocalSLocEntryTable;
 
+  /// \brief The offsets of the entries of LocalSLocEntryTable.
+  ///
+  /// getFileIDLocal binary searches these rather than the entries, which are
+  /// several times larger, so that the search touches fewer cache lines.
+  SmallVector<unsigned, 0> LocalSLocOffsetTable;
+
   /// \brief The table of SLocEntries that are loaded from other modules.
   ///
   /// Negative FileIDs are indexes into this table. To get from ID to an index,
@@ -625,6 +631,18 @@ class SourceManager : public RefCountedBase<SourceManager> {
   /// is very common to look up many tokens from the same file.
   mutable FileID LastFileIDLookup;
 
+  enum { NumRecentFileIDLookups = 4 };
+
+  /// \brief A small cache of the files most recently found by getFileIDSlow,
+  /// checked before searching the SLocEntry tables.
+  ///
+  /// Lookups often alternate between a few files, such as a header and the
+  /// file including it, which the one-entry cache keeps missing.
+  mutable FileID RecentFileIDLookups[NumRecentFileIDLookups];
+
+  /// \brief The entry of RecentFileIDLookups to be replaced next.
+  mutable unsigned NextRecentFileIDLookup;
+
   /// \brief Holds information for \#line directives.
   ///
   /// This is referenced by indices from SLocEntryTable.
@@ -644,7 +662,7 @@ class SourceManager : public RefCountedBase<SourceManager> {
   FileID PreambleFileID;
 
   // Statistics for -print-stats.
-  mutable unsigned NumLinearScans, NumBinaryProbes;
+  mutable unsigned NumLinearScans, NumBinaryProbes, NumRecentFileIDHits;
 
   /// \brief Associates a FileID with its "included/expanded in" decomposed
   /// location.
@@ -1630,6 +1648,9 @@ private:
   FileID getFileIDLocal(unsigned SLocOffset) const;
   FileID getFileIDLoaded(unsigned SLocOffset) const;
 
+  /// \brief Remembers a file found by getFileIDSlow in the lookup caches.
+  void cacheFileIDLookup(FileID FID) const;
+
   SourceLocation getExpansionLocSlowCase(SourceLocation Loc) const;
   SourceLocation getSpellingLocSlowCase(SourceLocation Loc) const;
   SourceLocation getFileLocSlowCase(SourceLocation Loc) const;
@@ -69,6 +69,15 @@ class Compilation {
   /// Redirection for stdout, stderr, etc.
   const StringRef **Redirects;
 
+  /// The maximum number of commands to execute at the same time.
+  unsigned NumParallelJobs;
+
+  /// PrintCommandIfRequested - Print \p C if -v or CC_PRINT_OPTIONS asked us
+  /// to.
+  ///
+  /// \return false if the command could not be logged.
+  bool PrintCommandIfRequested(const Command &C) const;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
@@ -104,6 +113,9 @@ public:
   /// Returns the sysroot path.
   StringRef getSysRoot() const;
 
+  unsigned getNumParallelJobs() const { return NumParallelJobs; }
+  void setNumParallelJobs(unsigned N) { NumParallelJobs = N; }
+
   /// getArgsForToolChain - Return the derived argument list for the
   /// tool chain \p TC (or the default tool chain, if TC is not specified).
   ///
@@ -169,6 +181,18 @@ public:
   void ExecuteJob(const Job &J,
      SmallVectorImpl< std::pair<int, const Command *> > &FailingCommands) const;
 
+  /// ExecuteJobs - Execute all the commands in \p Jobs, running up to
+  /// getNumParallelJobs() commands at a time.
+  ///
+  /// A command is only started once every command producing one of its
+  /// inputs has finished, and, as with ExecuteJob, commands whose inputs
+  /// failed are skipped.  Failures are reported in job order.
+  ///
+  /// \param FailingCommands - For non-zero results, this will be a vector of
+  /// failing commands and their associated result code.
+  void ExecuteJobs(const JobList &Jobs,
+     SmallVectorImpl< std::pair<int, const Command *> > &FailingCommands) const;
+
   /// initCompilationForDiagnostics - Remove stale state and suppress output
   /// so compilation can be reexecuted to generate additional diagnostic
   /// information (e.g., preprocessed source(s)).
@@ -17,6 +17,8 @@
 
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Tooling/Refactoring.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/system_error.h"
 
 namespace clang {
@@ -55,6 +57,14 @@ struct FormatStyle {
   /// \brief The penalty for breaking a function call after "call(".
   unsigned PenaltyBreakBeforeFirstCallParameter;
 
+  /// \brief The maximum number of states analyzed when searching for the
+  /// best way to break an unwrapped line.
+  ///
+  /// Lines that exceed this budget, e.g. very long initializer lists or deeply
+  /// nested calls, are completed greedily from the best state found so far.
+  /// A value of \c 0 means no limit.
+  unsigned MaxAnalyzedStatesPerLine;
+
   /// \brief Set whether & and * bind to the type as opposed to the variable.
   bool PointerBindsToType;
 
@@ -278,6 +288,7 @@ struct FormatStyle {
            IndentFunctionDeclarationAfterType ==
                R.IndentFunctionDeclarationAfterType &&
            IndentWidth == R.IndentWidth &&
+           MaxAnalyzedStatesPerLine == R.MaxAnalyzedStatesPerLine &&
            MaxEmptyLinesToKeep == R.MaxEmptyLinesToKeep &&
            NamespaceIndentation == R.NamespaceIndentation &&
            ObjCSpaceBeforeProtocolList == R.ObjCSpaceBeforeProtocolList &&
@@ -386,6 +397,34 @@ extern const char *StyleOptionHelpDescription;
 /// determined, the default is LLVM Style (see getLLVMStyle()).
 FormatStyle getStyle(StringRef StyleName, StringRef FileName);
 
+/// \brief Remembers the style that applies to the files in each directory,
+/// as determined by the '.clang-format' files in it or its parents.
+///
+/// Passing the same cache to getStyle() for many files searches each
+/// directory for a configuration file and parses each configuration file only
+/// once. The configuration files are assumed not to change while the cache is
+/// in use.
+///
+/// The cache is safe to use from several threads at once.
+class StyleFileCache {
+public:
+  /// \brief Sets \p Style to the style for files in \p Directory and returns
+  /// \c true, or returns \c false if \p Directory has not been looked at yet.
+  bool lookup(StringRef Directory, FormatStyle *Style);
+
+  /// \brief Records \p Style as the style for files in \p Directory.
+  void insert(StringRef Directory, const FormatStyle &Style);
+
+private:
+  llvm::StringMap<FormatStyle> Styles;
+  llvm::sys::Mutex Lock;
+};
+
+/// \brief Like getStyle(StringRef, StringRef), but looks up and records the
+/// style of the directories searched for '.clang-format' in \p Cache.
+FormatStyle getStyle(StringRef StyleName, StringRef FileName,
+                     StyleFileCache *Cache);
+
 } // end namespace format
 } // end namespace clang
 
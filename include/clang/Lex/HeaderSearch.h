@@ -32,6 +32,9 @@ class FileEntry;
 class FileManager;
 class HeaderSearchOptions;
 class IdentifierInfo;
+class HeaderLookupCache;
+class IncludeGuardCache;
+class Preprocessor;
 
 /// \brief The preprocessor keeps track of this information for each
 /// file that is \#included.
@@ -226,10 +229,32 @@ class HeaderSearch {
 
   /// \brief Entity used to look up stored header file information.
   ExternalHeaderFileInfoSource *ExternalSource;
+
+  /// \brief The controlling macros of headers found by other translation
+  /// units, if enabled.
+  OwningPtr<IncludeGuardCache> GuardCache;
+
+  /// \brief The results of header lookups made by other translation units,
+  /// if enabled.
+  OwningPtr<HeaderLookupCache> LookupCache;
+
+  /// \brief Whether LookupCache has been loaded for the current search
+  /// directories.
+  bool LookupCacheLoaded;
+
+  /// \brief Whether LookupCache can be used with the current search
+  /// directories.
+  bool LookupCacheUsable;
+
+  /// \brief The modification times of the search directories, in seconds
+  /// since the epoch, read when LookupCache was loaded.
+  std::vector<uint64_t> SearchDirModTimes;
   
   // Various statistics we track for performance analysis.
   unsigned NumIncluded;
   unsigned NumMultiIncludeFileOptzn;
+  unsigned NumGuardCacheOptzn;
+  unsigned NumLookupCacheHits, NumLookupCacheMisses;
   unsigned NumFrameworkLookups, NumSubFrameworkLookups;
 
   // HeaderSearch doesn't support default or copy construction.
@@ -261,6 +286,7 @@ public:
     SystemDirIdx = systemDirIdx;
     NoCurDirSearch = noCurDirSearch;
     //LookupFileCache.clear();
+    LookupCacheLoaded = false;
   }
 
   /// \brief Add an additional search path.
@@ -270,6 +296,7 @@ public:
     if (!isAngled)
       AngledDirIdx++;
     SystemDirIdx++;
+    LookupCacheLoaded = false;
   }
 
   /// \brief Set the list of system header prefixes.
@@ -399,7 +426,8 @@ public:
   ///
   /// \return false if \#including the file will have no effect or true
   /// if we should include it.
-  bool ShouldEnterIncludeFile(const FileEntry *File, bool isImport);
+  bool ShouldEnterIncludeFile(Preprocessor &PP, const FileEntry *File,
+                              bool isImport);
 
 
   /// \brief Return whether the specified file is a normal header,
@@ -438,9 +466,15 @@ public:
   /// This is used by the multiple-include optimization to eliminate
   /// no-op \#includes.
   void SetFileControllingMacro(const FileEntry *File,
-                               const IdentifierInfo *ControllingMacro) {
-    getFileInfo(File).ControllingMacro = ControllingMacro;
-  }
+                               const IdentifierInfo *ControllingMacro);
+
+  /// \brief Writes the controlling macros found by this translation unit to
+  /// the include guard cache, if enabled.
+  void saveIncludeGuardCache();
+
+  /// \brief Writes the header lookups made by this translation unit to the
+  /// header lookup cache, if enabled.
+  void saveHeaderLookupCache();
 
   /// \brief Return true if this is the first time encountering this header.
   bool FirstTimeLexingFile(const FileEntry *File) {
@@ -625,6 +659,18 @@ private:
 
   /// \brief Return the HeaderFileInfo structure for the specified FileEntry.
   HeaderFileInfo &getFileInfo(const FileEntry *FE);
+
+  /// \brief Returns the header lookup cache, loaded for the current search
+  /// directories, or null if it is disabled.
+  HeaderLookupCache *getHeaderLookupCache();
+
+  /// \brief Returns true if \p Dir is one of the search directories.
+  bool isSearchDir(StringRef Dir) const;
+
+  /// \brief Hashes what the results of header lookups depend on, apart from
+  /// the contents of the search directories: the search directories
+  /// themselves.
+  uint64_t hashSearchDirs() const;
 };
 
 }  // end namespace clang
@@ -89,6 +89,14 @@ public:
   /// \brief The directory used for the module cache.
   std::string ModuleCachePath;
 
+  /// \brief The file which keeps the controlling macros of headers across
+  /// translation units, if any.
+  std::string IncludeGuardCachePath;
+
+  /// \brief The file which keeps the results of header lookups across
+  /// translation units, if any.
+  std::string HeaderLookupCachePath;
+
   /// \brief Whether we should disable the use of the hash string within the
   /// module cache.
   ///
@@ -98,6 +106,10 @@ public:
   /// \brief Interpret module maps.  This option is implied by full modules.
   unsigned ModuleMaps : 1;
 
+  /// \brief Only index the top-level module declarations of module map files,
+  /// and parse each of them when the module is first needed.
+  unsigned LazyModuleMaps : 1;
+
   /// \brief The interval (in seconds) between pruning operations.
   ///
   /// This operation is expensive, because it requires Clang to walk through
@@ -141,6 +153,7 @@ public:
 public:
   HeaderSearchOptions(StringRef _Sysroot = "/")
     : Sysroot(_Sysroot), DisableModuleHash(0), ModuleMaps(0),
+      LazyModuleMaps(0),
       ModuleCachePruneInterval(7*24*60*60),
       ModuleCachePruneAfter(31*24*60*60),
       UseBuiltinIncludes(true),
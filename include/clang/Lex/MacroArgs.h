@@ -16,6 +16,7 @@
 
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 #include <vector>
 
 namespace clang {
@@ -39,6 +40,11 @@ class MacroArgs {
   /// if in strict mode and the C99 varargs macro had only a ... argument, this
   /// is false.
   bool VarargsElided;
+
+  /// ArgStarts - The index of the first unexpanded token of each argument.
+  /// Like the token vectors below, this keeps its storage while the object
+  /// sits on the Preprocessor's free list.
+  SmallVector<unsigned, 8> ArgStarts;
   
   /// PreExpArgTokens - Pre-expanded tokens for arguments that need them.  Empty
   /// if not yet computed.  This includes the EOF marker at the end of the
@@ -19,12 +19,14 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/Module.h"
 #include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include <string>
+#include <vector>
 
 namespace clang {
   
@@ -144,6 +146,62 @@ private:
   /// map.
   llvm::DenseMap<const FileEntry *, bool> ParsedModuleMap;
 
+  /// \brief A top-level module declaration which has been indexed but not
+  /// necessarily parsed, when module maps are parsed lazily.
+  struct LazyModuleDecl {
+    /// \brief The module map file holding the declaration.
+    FileID ID;
+
+    /// \brief The directory of the module map file.
+    const DirectoryEntry *Dir;
+
+    /// \brief The offset of the declaration within the module map file.
+    unsigned Offset;
+
+    /// \brief Whether the module map file is in a system header directory.
+    bool IsSystem;
+
+    /// \brief Whether the declaration has been parsed.
+    bool Parsed;
+  };
+
+  /// \brief The indexed top-level module declarations.
+  std::vector<LazyModuleDecl> LazyDecls;
+
+  /// \brief Maps module names to the unparsed declarations of those modules.
+  llvm::StringMap<SmallVector<unsigned, 1> > LazyDeclsByName;
+
+  /// \brief Maps the file names of headers to the unparsed declarations
+  /// which mention them.
+  llvm::StringMap<SmallVector<unsigned, 1> > LazyDeclsByHeader;
+
+  /// \brief The unparsed declarations which have umbrella headers or
+  /// directories, and may therefore own headers they do not mention.
+  SmallVector<unsigned, 2> LazyUmbrellaDecls;
+
+  /// \brief Record a top-level module declaration which will be parsed
+  /// once it is needed.
+  ///
+  /// \param Name The name of the module.
+  ///
+  /// \param HeaderNames The file names of the headers that the declaration
+  /// mentions.
+  ///
+  /// \param HasUmbrella Whether the declaration has an umbrella header or
+  /// directory.
+  void addLazyModuleDecl(StringRef Name, FileID ID, const DirectoryEntry *Dir,
+                         unsigned Offset, bool IsSystem,
+                         ArrayRef<StringRef> HeaderNames, bool HasUmbrella);
+
+  /// \brief Parse the given indexed declaration, unless it has been parsed.
+  void parseLazyModuleDecl(unsigned Index);
+
+  /// \brief Parse the unparsed declarations of the module with the given name.
+  void parseLazyModules(StringRef Name);
+
+  /// \brief Parse the unparsed declarations which may own the given header.
+  void parseLazyModulesForHeader(const FileEntry *File);
+
   friend class ModuleMapParser;
   
   /// \brief Resolve the given export declaration into an actual export
@@ -364,6 +422,10 @@ public:
   ///
   /// \returns true if an error occurred, false otherwise.
   bool parseModuleMapFile(const FileEntry *File, bool IsSystem);
+
+  /// \brief Parse all of the module declarations which have only been indexed
+  /// so far, so that every known module is described completely.
+  void parseLazyModules();
     
   /// \brief Dump the contents of the module map, for debugging purposes.
   void dump();
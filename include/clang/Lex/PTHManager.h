@@ -74,6 +74,15 @@ class PTHManager : public IdentifierInfoLookup {
   ///  if the file (if any) that was to used to generate the PTH cache.
   const char* OriginalSourceFile;
 
+  /// NumCachedFiles - The number of files whose tokens were read from the
+  ///  PTH file.
+  unsigned NumCachedFiles;
+
+  /// NumStaleFiles - The number of files with cached tokens which were lexed
+  ///  from source because their contents changed since the PTH file was
+  ///  generated.
+  unsigned NumStaleFiles;
+
   /// This constructor is intended to only be called by the static 'Create'
   /// method.
   PTHManager(const llvm::MemoryBuffer* buf, void* fileLookup,
@@ -100,7 +109,7 @@ class PTHManager : public IdentifierInfoLookup {
 
 public:
   // The current PTH version.
-  enum { Version = 10 };
+  enum { Version = 11 };
 
   ~PTHManager();
 
@@ -130,8 +139,16 @@ public:
   /// createStatCache - Returns a FileSystemStatCache object for use with
   ///  FileManager objects.  These objects use the PTH data to speed up
   ///  calls to stat by memoizing their results from when the PTH file
-  ///  was generated.
+  ///  was generated.  Files with cached tokens are still stat'ed, as they
+  ///  may have changed since.
   FileSystemStatCache *createStatCache();
+
+  /// getContentHash - Returns the hash of the contents of a source file, which
+  ///  ties the tokens cached for the file to the contents they were lexed
+  ///  from.
+  static uint64_t getContentHash(StringRef Contents);
+
+  void PrintStats() const;
 };
 
 }  // end namespace clang
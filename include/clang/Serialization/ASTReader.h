@@ -810,6 +810,10 @@ private:
   /// Number of visible decl contexts read/total.
   unsigned NumVisibleDeclContextsRead, TotalVisibleDeclContexts;
 
+  /// \brief The number of module files which the global module index showed
+  /// to have no declarations with the names looked up in them.
+  unsigned NumDeclNameLookupFilesSkipped;
+
   /// Total size of modules, in bits, currently loaded
   uint64_t TotalModulesSizeInBits;
 
@@ -8,9 +8,10 @@
 //===----------------------------------------------------------------------===//
 //
 // This file defines the GlobalModuleIndex class, which manages a global index
-// containing all of the identifiers known to the various modules within a given
-// subdirectory of the module cache. It is used to improve the performance of
-// queries such as "do any modules know about this identifier?"
+// containing all of the identifiers, selectors and declaration names known to
+// the various modules within a given subdirectory of the module cache. It is
+// used to improve the performance of queries such as "do any modules know
+// about this identifier?"
 //
 //===----------------------------------------------------------------------===//
 #ifndef LLVM_CLANG_SERIALIZATION_GLOBAL_MODULE_INDEX_H
@@ -31,10 +32,12 @@ class MemoryBuffer;
 
 namespace clang {
 
+class DeclarationName;
 class DirectoryEntry;
 class FileEntry;
 class FileManager;
 class IdentifierIterator;
+class Selector;
 
 namespace serialization {
   class ModuleFile;
@@ -68,6 +71,17 @@ class GlobalModuleIndex {
   /// GlobalModuleIndex.
   void *IdentifierIndex;
 
+  /// \brief The hash table mapping selector hashes to module files.
+  ///
+  /// This pointer actually points to a HashIndexTable object.
+  void *SelectorIndex;
+
+  /// \brief The hash table mapping the hashes of the names in declaration
+  /// context lookup tables to module files.
+  ///
+  /// This pointer actually points to a HashIndexTable object.
+  void *DeclNameIndex;
+
   /// \brief Information about a given module file.
   struct ModuleInfo {
     ModuleInfo() : File(), Size(), ModTime() { }
@@ -113,7 +127,21 @@ class GlobalModuleIndex {
   /// \brief The number of identifier lookup hits, where we recognize the
   /// identifier.
   unsigned NumIdentifierLookupHits;
-  
+
+  /// \brief The number of selector lookups we performed.
+  unsigned NumSelectorLookups;
+
+  /// \brief The number of selector lookups that found at least one module
+  /// file.
+  unsigned NumSelectorLookupHits;
+
+  /// \brief The number of declaration name lookups we performed.
+  unsigned NumDeclNameLookups;
+
+  /// \brief The number of declaration name lookups that found at least one
+  /// module file.
+  unsigned NumDeclNameLookupHits;
+
   /// \brief Internal constructor. Use \c readIndex() to read an index.
   explicit GlobalModuleIndex(llvm::MemoryBuffer *Buffer,
                              llvm::BitstreamCursor Cursor);
@@ -177,6 +205,35 @@ public:
   /// \returns true if the identifier is known to the index, false otherwise.
   bool lookupIdentifier(StringRef Name, HitSet &Hits);
 
+  /// \brief Look for all of the module files whose global method pool may
+  /// have methods with the given selector.
+  ///
+  /// The index records selectors by their hash, so \p Hits may contain
+  /// module files that have no methods with this particular selector.
+  ///
+  /// \param Sel The selector to look for.
+  ///
+  /// \param Hits Will be populated with the set of module files that may
+  /// have methods with this selector.
+  ///
+  /// \returns true if the index covers selectors, false otherwise.
+  bool lookupSelector(Selector Sel, HitSet &Hits);
+
+  /// \brief Look for all of the module files that may have visible
+  /// declarations with the given name in some declaration context, such as
+  /// the translation unit or a namespace.
+  ///
+  /// The index records names by their hash, so \p Hits may contain module
+  /// files that have no declarations with this particular name.
+  ///
+  /// \param Name The declaration name to look for.
+  ///
+  /// \param Hits Will be populated with the set of module files that may
+  /// have declarations with this name.
+  ///
+  /// \returns true if the index covers declaration names, false otherwise.
+  bool lookupDeclName(DeclarationName Name, HitSet &Hits);
+
   /// \brief Note that the given module file has been loaded.
   ///
   /// \returns false if the global module index has information about this
@@ -193,6 +250,13 @@ public:
   /// \param Path The path to the directory containing module files, into
   /// which the global index will be written.
   static ErrorCode writeIndex(FileManager &FileMgr, StringRef Path);
+
+private:
+  /// \brief Look for the module files recorded under \p Hash in the given
+  /// hash index, which must be non-null.
+  ///
+  /// \returns true if any module file was recorded under \p Hash.
+  bool lookupHash(void *Index, unsigned Hash, HitSet &Hits);
 };
 
 }
@@ -145,6 +145,12 @@ public:
   /// \brief Number of modules loaded
   unsigned size() const { return Chain.size(); }
 
+  /// \brief Number of modules loaded that the global module index also
+  /// knows about.
+  unsigned getNumModulesInCommonWithGlobalIndex() const {
+    return ModulesInCommonWithGlobalIndex.size();
+  }
+
   /// \brief The result of attempting to add a new module.
   enum AddModuleResult {
     /// \brief The module file had already been loaded.
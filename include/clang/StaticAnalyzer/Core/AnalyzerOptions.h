@@ -116,6 +116,30 @@ enum IPAKind {
   IPAK_DynamicDispatchBifurcate = 5
 };
 
+/// \brief Describes the order in which the analyzer explores the paths through
+/// a function.
+enum ExplorationStrategyKind {
+  ESK_NotSet = 0,
+
+  /// Explore the most recently reached program point first.
+  ESK_DFS = 1,
+
+  /// Explore the least recently reached program point first.
+  ESK_BFS = 2,
+
+  /// Explore basic blocks breadth-first, and their contents depth-first.
+  ESK_BFSBlockDFSContents = 3,
+
+  /// Explore entrances to basic blocks that have not been entered before
+  /// (in the same stack frame) first, and everything else depth-first.
+  ESK_UnexploredFirst = 4,
+
+  /// Explore entrances to the basic blocks that have been entered least often
+  /// first, preferring paths that went through the block fewer times (for
+  /// example, that iterated a loop fewer times).
+  ESK_UnexploredFirstQueue = 5
+};
+
 class AnalyzerOptions : public RefCountedBase<AnalyzerOptions> {
 public:
   typedef llvm::StringMap<std::string> ConfigTable;
@@ -131,6 +155,14 @@ public:
   AnalysisPurgeMode AnalysisPurgeOpt;
   
   std::string AnalyzeSpecificFunction;
+
+  /// \brief The directory of the function summaries shared by the analyses of
+  /// different translation units, or empty if they are not shared.
+  std::string SummaryCacheDir;
+
+  /// \brief The directory of the cached results of analyses, or empty if
+  /// results are not cached.
+  std::string ResultCacheDir;
   
   /// \brief The maximum number of times the analyzer visits a block.
   unsigned maxBlockVisitOnPath;
@@ -188,6 +220,9 @@ private:
 
   /// Controls which C++ member functions will be considered for inlining.
   CXXInlineableMemberKind CXXMemberInliningMode;
+
+  /// Controls the order in which paths are explored.
+  ExplorationStrategyKind ExplorationStrategy;
   
   /// \sa includeTemporaryDtorsInCFG
   Optional<bool> IncludeTemporaryDtorsInCFG;
@@ -232,6 +267,12 @@ private:
   /// \sa getGraphTrimInterval
   Optional<unsigned> GraphTrimInterval;
 
+  /// \sa shouldTrimGraphAggressively
+  Optional<bool> TrimGraphAggressively;
+
+  /// \sa getGraphMemoryLimit
+  Optional<unsigned> GraphMemoryLimit;
+
   /// \sa getMaxTimesInlineLarge
   Optional<unsigned> MaxTimesInlineLarge;
 
@@ -259,6 +300,13 @@ public:
   /// \brief Returns the inter-procedural analysis mode.
   IPAKind getIPAMode();
 
+  /// \brief Returns the order in which paths are explored.
+  ///
+  /// This is controlled by the 'exploration-strategy' config option, which
+  /// accepts the values "dfs" (the default), "bfs", "bfs-block-dfs-contents",
+  /// "unexplored-first" and "unexplored-first-queue".
+  ExplorationStrategyKind getExplorationStrategy();
+
   /// Returns the option controlling which C++ member functions will be
   /// considered for inlining.
   ///
@@ -383,6 +431,21 @@ public:
   /// node reclamation, set the option to "0".
   unsigned getGraphTrimInterval();
 
+  /// Returns true if node reclamation should also recycle the nodes at
+  /// intermediate program points, such as PreStmt and PreLoad, that carry no
+  /// state change. Path diagnostics are unaffected.
+  ///
+  /// This is controlled by the 'graph-trim-aggressive' config option.
+  bool shouldTrimGraphAggressively();
+
+  /// Returns the number of megabytes the exploded graph of a top level
+  /// function, including its program states, may use before the analysis of
+  /// that function stops as if it had run out of steps. 0 (the default)
+  /// means no limit.
+  ///
+  /// This is controlled by the 'graph-memory-limit' config option.
+  unsigned getGraphMemoryLimit();
+
   /// Returns the maximum times a large function could be inlined.
   ///
   /// This is controlled by the 'max-times-inline-large' config option.
@@ -417,7 +480,8 @@ public:
     InliningMode(NoRedundancy),
     UserMode(UMK_NotSet),
     IPAMode(IPAK_NotSet),
-    CXXMemberInliningMode() {}
+    CXXMemberInliningMode(),
+    ExplorationStrategy(ESK_NotSet) {}
 
 };
   
@@ -23,6 +23,7 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
@@ -452,6 +453,10 @@ public:
     return true;
   }
 
+  /// \brief Releases what the generation of the paths of one equivalence
+  /// class kept for the other PathDiagnosticConsumers.
+  virtual void finishPathGeneration() {}
+
   bool RemoveUnneededCalls(PathPieces &pieces, BugReport *R);
 
   void Register(BugType *BT);
@@ -476,9 +481,19 @@ private:
   BugType *getBugTypeForName(StringRef name, StringRef category);
 };
 
+class TrimmedGraph;
+
 // FIXME: Get rid of GRBugReporter.  It's the wrong abstraction.
 class GRBugReporter : public BugReporter {
   ExprEngine& Eng;
+
+  /// \brief The graph trimmed to the error nodes of the reports being
+  /// flushed, which is the same for every PathDiagnosticConsumer.
+  OwningPtr<TrimmedGraph> TrimG;
+
+  /// \brief The reports whose error nodes TrimG was trimmed to.
+  ArrayRef<BugReport *> TrimmedReports;
+
 public:
   GRBugReporter(BugReporterData& d, ExprEngine& eng)
     : BugReporter(d, GRBugReporterKind), Eng(eng) {}
@@ -509,6 +524,8 @@ public:
                                       PathDiagnosticConsumer &PC,
                                       ArrayRef<BugReport*> &bugReports);
 
+  virtual void finishPathGeneration();
+
   /// classof - Used by isa<>, cast<>, and dyn_cast<>.
   static bool classof(const BugReporter* R) {
     return R->getKind() == GRBugReporterKind;
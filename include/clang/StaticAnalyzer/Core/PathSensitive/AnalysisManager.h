@@ -96,7 +96,10 @@ public:
     return PathConsumers;
   }
 
-  void FlushDiagnostics();
+  /// \brief Has the PathDiagnosticConsumers write their diagnostics.
+  ///
+  /// \param Files If non-null, records the files written for each diagnostic.
+  void FlushDiagnostics(PathDiagnosticConsumer::FilesMade *Files = 0);
 
   bool shouldVisualize() const {
     return options.visualizeExplodedGraphWithGraphViz ||
@@ -25,6 +25,7 @@
 
 namespace clang {
 
+class AnalyzerOptions;
 class ProgramPointTag;
   
 namespace ento {
@@ -84,6 +85,16 @@ private:
   /// (This data is owned by AnalysisConsumer.)
   FunctionSummariesTy *FunctionSummaries;
 
+  /// The number of work list items processed so far.
+  unsigned NumStepsTaken;
+
+  /// The number of bytes the graph may use before we stop exploring it, or
+  /// 0 if there is no limit.
+  uint64_t GraphMemoryLimit;
+
+  /// Returns true if the graph has outgrown GraphMemoryLimit.
+  bool exceedsGraphMemoryLimit();
+
   void generateNode(const ProgramPoint &Loc,
                     ProgramStateRef State,
                     ExplodedNode *Pred);
@@ -107,13 +118,11 @@ private:
   ExplodedNode *generateCallExitBeginNode(ExplodedNode *N);
 
 public:
-  /// Construct a CoreEngine object to analyze the provided CFG.
+  /// Construct a CoreEngine object to analyze the provided CFG, exploring
+  /// it in the order selected by \p Opts.
   CoreEngine(SubEngine& subengine,
-             FunctionSummariesTy *FS)
-    : SubEng(subengine), G(new ExplodedGraph()),
-      WList(WorkList::makeDFS()),
-      BCounterFactory(G->getAllocator()),
-      FunctionSummaries(FS){}
+             FunctionSummariesTy *FS,
+             AnalyzerOptions &Opts);
 
   /// getGraph - Returns the exploded graph.
   ExplodedGraph& getGraph() { return *G.get(); }
@@ -152,6 +161,9 @@ public:
   
   WorkList *getWorkList() const { return WList.get(); }
 
+  /// Returns the number of work list items processed so far.
+  unsigned getNumStepsTaken() const { return NumStepsTaken; }
+
   BlocksExhausted::const_iterator blocks_exhausted_begin() const {
     return blocksExhausted.begin();
   }
@@ -287,6 +287,10 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
 
+  /// Whether nodes at intermediate program points other than PostStmt, such
+  /// as PreStmt and PreLoad, are reclaimed as well.
+  bool AggressiveReclamation;
+
 public:
 
   /// \brief Retrieve the node associated with a (Location,State) pair,
@@ -358,6 +362,13 @@ public:
   const_eop_iterator eop_end() const { return EndNodes.end(); }
 
   llvm::BumpPtrAllocator & getAllocator() { return BVC.getAllocator(); }
+
+  /// Returns the number of bytes allocated for the graph, which includes the
+  /// program states of its nodes.
+  ///
+  /// This walks the slabs of the allocator, so it should not be called for
+  /// every node.
+  size_t getTotalMemory() { return getAllocator().getTotalMemory(); }
   BumpVectorContext &getNodeAllocator() { return BVC; }
 
   typedef llvm::DenseMap<const ExplodedNode*, ExplodedNode*> NodeMap;
@@ -378,8 +389,12 @@ public:
 
   /// Enable tracking of recently allocated nodes for potential reclamation
   /// when calling reclaimRecentlyAllocatedNodes().
-  void enableNodeReclamation(unsigned Interval) {
+  ///
+  /// \param Aggressive If true, also reclaim nodes at the intermediate program
+  /// points that path diagnostics never consult (see shouldCollect()).
+  void enableNodeReclamation(unsigned Interval, bool Aggressive = false) {
     ReclaimCounter = ReclaimNodeInterval = Interval;
+    AggressiveReclamation = Aggressive;
   }
 
   /// Reclaim "uninteresting" nodes created since the last time this method
@@ -44,12 +44,18 @@ class FunctionSummariesTy {
     /// True if this function may be inlined.
     unsigned MayInline : 1;
 
+    /// True if this function may not be inlined because of static properties
+    /// of its declaration and body, rather than because of how the analysis
+    /// of some call to it went.
+    unsigned NeverInline : 1;
+
     /// The number of times the function has been inlined.
     unsigned TimesInlined : 32;
 
     FunctionSummary() :
       TotalBasicBlocks(0),
       InlineChecked(0),
+      NeverInline(0),
       TimesInlined(0) {}
   };
 
@@ -80,6 +86,15 @@ public:
     I->second.MayInline = 0;
   }
 
+  /// Marks \p D as not inlinable into any caller, because of properties of
+  /// \p D itself.
+  void markShouldNeverInline(const Decl *D) {
+    MapTy::iterator I = findOrInsertSummary(D);
+    I->second.InlineChecked = 1;
+    I->second.MayInline = 0;
+    I->second.NeverInline = 1;
+  }
+
   void markReachedMaxBlockCount(const Decl *D) {
     markShouldNotInline(D);
   }
@@ -91,6 +106,12 @@ public:
     return None;
   }
 
+  /// Returns true if \p D was marked with markShouldNeverInline().
+  bool shouldNeverInline(const Decl *D) {
+    MapTy::const_iterator I = Map.find(D);
+    return I != Map.end() && I->second.NeverInline;
+  }
+
   void markVisitedBasicBlock(unsigned ID, const Decl* D, unsigned TotalIDs) {
     MapTy::iterator I = findOrInsertSummary(D);
     llvm::SmallBitVector &Blocks = I->second.VisitedBasicBlocks;
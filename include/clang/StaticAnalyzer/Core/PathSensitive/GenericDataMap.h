@@ -0,0 +1,115 @@
+//== GenericDataMap.h - Checker data stored in a ProgramState ----*- C++ -*--=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines GenericDataMap, the immutable map from ProgramState
+//  traits to their values.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_GR_GENERICDATAMAP_H
+#define LLVM_CLANG_GR_GENERICDATAMAP_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/FoldingSet.h"
+#include <utility>
+
+namespace llvm {
+class BumpPtrAllocator;
+}
+
+namespace clang {
+namespace ento {
+
+/// \brief An immutable map from the keys of ProgramState traits to their
+/// values.
+///
+/// A state seldom holds more than a dozen traits, and a lookup or an update
+/// happens for almost every transition, so rather than a balanced tree the
+/// map is a single sorted array of key/value pairs.  Maps are uniqued by the
+/// Factory that creates them: two maps with the same contents are the same
+/// object, so they can be compared and profiled by address.
+class GenericDataMap {
+public:
+  typedef std::pair<void *, void *> value_type;
+  typedef const value_type *iterator;
+
+  class Factory;
+
+private:
+  /// \brief The uniqued storage of a non-empty map, followed in memory by
+  /// its entries, sorted by key.
+  class Storage : public llvm::FoldingSetNode {
+    unsigned NumEntries;
+
+  public:
+    explicit Storage(unsigned NumEntries) : NumEntries(NumEntries) {}
+
+    unsigned size() const { return NumEntries; }
+    value_type *begin() { return reinterpret_cast<value_type *>(this + 1); }
+    const value_type *begin() const {
+      return reinterpret_cast<const value_type *>(this + 1);
+    }
+    const value_type *end() const { return begin() + NumEntries; }
+
+    static void Profile(llvm::FoldingSetNodeID &ID,
+                        ArrayRef<value_type> Entries);
+    void Profile(llvm::FoldingSetNodeID &ID) const {
+      Profile(ID, ArrayRef<value_type>(begin(), end()));
+    }
+  };
+
+  /// \brief The entries of the map, or null if the map is empty.
+  const Storage *Data;
+
+  explicit GenericDataMap(const Storage *Data) : Data(Data) {}
+
+public:
+  iterator begin() const { return Data ? Data->begin() : 0; }
+  iterator end() const { return Data ? Data->end() : 0; }
+
+  bool isEmpty() const { return !Data; }
+  unsigned size() const { return Data ? Data->size() : 0; }
+
+  /// \brief Returns a pointer to the value of \p Key, or null if the map
+  /// has no entry for it.
+  void *const *lookup(void *Key) const;
+
+  bool operator==(const GenericDataMap &RHS) const { return Data == RHS.Data; }
+  bool operator!=(const GenericDataMap &RHS) const { return Data != RHS.Data; }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Data); }
+
+  /// \brief Creates and uniques GenericDataMaps.
+  class Factory {
+    llvm::BumpPtrAllocator &Alloc;
+    llvm::FoldingSet<Storage> Maps;
+
+    /// \brief Returns the unique map with the given sorted entries.
+    GenericDataMap getMap(ArrayRef<value_type> Entries);
+
+    Factory(const Factory &) LLVM_DELETED_FUNCTION;
+    void operator=(const Factory &) LLVM_DELETED_FUNCTION;
+
+  public:
+    explicit Factory(llvm::BumpPtrAllocator &Alloc) : Alloc(Alloc) {}
+
+    GenericDataMap getEmptyMap() const { return GenericDataMap(0); }
+
+    /// \brief Returns \p Old with \p Key mapped to \p Value.
+    GenericDataMap add(GenericDataMap Old, void *Key, void *Value);
+
+    /// \brief Returns \p Old without an entry for \p Key.
+    GenericDataMap remove(GenericDataMap Old, void *Key);
+  };
+};
+
+} // end namespace ento
+} // end namespace clang
+
+#endif
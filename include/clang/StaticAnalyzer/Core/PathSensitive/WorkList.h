@@ -91,6 +91,15 @@ public:
   static WorkList *makeDFS();
   static WorkList *makeBFS();
   static WorkList *makeBFSBlockDFSContents();
+
+  /// \brief Creates a work list that prefers entering basic blocks the
+  /// analysis has not entered before, and is depth-first otherwise.
+  static WorkList *makeUnexploredFirst();
+
+  /// \brief Creates a work list that prefers entering the basic blocks
+  /// entered least often, and then the paths that went through the block
+  /// fewer times.
+  static WorkList *makeUnexploredFirstPriorityQueue();
 };
 
 } // end GR namespace
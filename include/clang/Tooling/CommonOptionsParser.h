@@ -76,11 +76,18 @@ public:
     return SourcePathList;
   }
 
+  /// Returns the number of translation units to process concurrently, as
+  /// requested with -j.  Pass it to ClangTool::setNumThreads.
+  unsigned getNumThreads() const {
+    return NumThreads;
+  }
+
   static const char *const HelpMessage;
 
 private:
   OwningPtr<CompilationDatabase> Compilations;
   std::vector<std::string> SourcePathList;
+  unsigned NumThreads;
 };
 
 }  // namespace tooling
@@ -22,8 +22,6 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/MemoryBuffer.h"
-#include "llvm/Support/SourceMgr.h"
-#include "llvm/Support/YAMLParser.h"
 #include <string>
 #include <vector>
 
@@ -47,14 +45,29 @@ namespace tooling {
 ///
 /// JSON compilation databases can for example be generated in CMake projects
 /// by setting the flag -DCMAKE_EXPORT_COMPILE_COMMANDS.
+///
+/// Loading a database only scans it for the 'file' of each entry and records
+/// where the entry starts; the other attributes are decoded when the entry's
+/// compile commands are requested.  Large databases are memory mapped rather
+/// than read.
 class JSONCompilationDatabase : public CompilationDatabase {
 public:
   /// \brief Loads a JSON compilation database from the specified file.
   ///
+  /// If \p UseIndexFile is true, the file-to-entry index is read from
+  /// getIndexFilePath(FilePath) when that is up to date with the database,
+  /// which avoids scanning the database altogether; otherwise the index is
+  /// rebuilt and written there for the next load.
+  ///
   /// Returns NULL and sets ErrorMessage if the database could not be
   /// loaded from the given file.
   static JSONCompilationDatabase *loadFromFile(StringRef FilePath,
-                                               std::string &ErrorMessage);
+                                               std::string &ErrorMessage,
+                                               bool UseIndexFile = false);
+
+  /// \brief Returns the path of the index file cached next to the database
+  /// at \p FilePath.
+  static std::string getIndexFilePath(StringRef FilePath);
 
   /// \brief Loads a JSON compilation database from a data buffer.
   ///
@@ -82,31 +95,38 @@ public:
 private:
   /// \brief Constructs a JSON compilation database on a memory buffer.
   JSONCompilationDatabase(llvm::MemoryBuffer *Database)
-    : Database(Database), YAMLStream(Database->getBuffer(), SM) {}
+    : Database(Database) {}
 
-  /// \brief Parses the database file and creates the index.
+  /// \brief Scans the database file and creates the index.
   ///
   /// Returns whether parsing succeeded. Sets ErrorMessage if parsing
   /// failed.
   bool parse(std::string &ErrorMessage);
 
-  // Tuple (directory, commandline) where 'commandline' pointing to the
-  // corresponding nodes in the YAML stream.
-  typedef std::pair<llvm::yaml::ScalarNode*,
-                    llvm::yaml::ScalarNode*> CompileCommandRef;
+  /// \brief Reads the index from \p IndexPath if it describes a database
+  /// of \p DatabaseSize bytes last modified at \p DatabaseModTime.
+  bool readIndex(StringRef IndexPath, uint64_t DatabaseSize,
+                 uint64_t DatabaseModTime);
+
+  /// \brief Writes the index to \p IndexPath.
+  void writeIndex(StringRef IndexPath, uint64_t DatabaseSize,
+                  uint64_t DatabaseModTime) const;
+
+  /// \brief Adds the entry starting at \p Offset for \p NativeFilePath to
+  /// the index.
+  void addEntry(StringRef NativeFilePath, unsigned Offset);
 
-  /// \brief Converts the given array of CompileCommandRefs to CompileCommands.
-  void getCommands(ArrayRef<CompileCommandRef> CommandsRef,
+  /// \brief Converts the entries starting at the given offsets in the
+  /// database to CompileCommands.
+  void getCommands(ArrayRef<unsigned> EntryOffsets,
                    std::vector<CompileCommand> &Commands) const;
 
-  // Maps file paths to the compile command lines for that file.
-  llvm::StringMap< std::vector<CompileCommandRef> > IndexByFile;
+  // Maps file paths to the offsets of the entries for that file.
+  llvm::StringMap< std::vector<unsigned> > IndexByFile;
 
   FileMatchTrie MatchTrie;
 
   OwningPtr<llvm::MemoryBuffer> Database;
-  llvm::SourceMgr SM;
-  llvm::yaml::Stream YAMLStream;
 };
 
 } // end namespace tooling
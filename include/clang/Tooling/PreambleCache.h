@@ -0,0 +1,98 @@
+//===--- PreambleCache.h - Preambles shared between tool runs ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines a cache of precompiled preambles that lets the
+//  translation units processed by a ClangTool share the work of parsing the
+//  headers they all include.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLING_PREAMBLE_CACHE_H
+#define LLVM_CLANG_TOOLING_PREAMBLE_CACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Option/Option.h"
+#include "llvm/Support/Mutex.h"
+
+namespace clang {
+
+class CompilerInvocation;
+class FileManager;
+
+namespace tooling {
+
+/// \brief A cache of precompiled preambles shared between translation units.
+///
+/// The preamble of a source file is the run of preprocessor directives and
+/// comments at its start (see \c Lexer::ComputePreamble), typically the
+/// block of #includes.  Source files in the same directory that start with
+/// the same preamble and are compiled with the same flags parse exactly the
+/// same headers, so the first of them precompiles its preamble, and the
+/// others load that precompiled header and skip straight past their
+/// preamble.
+///
+/// Warnings in the headers of a shared preamble are not reported, and the
+/// include stacks of declarations in those headers name the main file of the
+/// translation unit that precompiled the preamble.  If the preamble has
+/// errors it is not shared, and translation units are parsed as usual.  The
+/// source files are assumed not to change while the cache is alive.
+///
+/// The cache is safe to use from several threads at once.
+class PreambleCache {
+public:
+  PreambleCache();
+
+  /// \brief Removes the precompiled preambles from disk.
+  ~PreambleCache();
+
+  /// \brief Makes \p Invocation use a shared precompiled preamble, building
+  /// it first if no earlier translation unit did.
+  ///
+  /// \param CC1Args The arguments \p Invocation was created from.
+  /// \param Files The file manager used to read the main file.
+  ///
+  /// \returns true if \p Invocation now uses a precompiled preamble; false if
+  /// it was left unchanged, for example because the main file has no preamble
+  /// or it could not be precompiled.
+  bool attachPreamble(CompilerInvocation &Invocation,
+                      const llvm::opt::ArgStringList &CC1Args,
+                      FileManager &Files);
+
+  /// \brief Returns the number of translation units that reused a preamble
+  /// precompiled by an earlier one.
+  unsigned getNumHits() const { return NumHits; }
+
+  /// \brief Returns the number of preambles that had to be precompiled.
+  unsigned getNumMisses() const { return NumMisses; }
+
+private:
+  struct Entry;
+
+  /// \brief Precompiles the first \p PreambleSize bytes of \p MainBuffer,
+  /// which is the main file of \p Invocation, into \p E.
+  bool buildPreamble(Entry &E, const CompilerInvocation &Invocation,
+                     const llvm::MemoryBuffer &MainBuffer,
+                     unsigned PreambleSize, FileManager &Files);
+
+  /// \brief Maps the preamble text, the main file's directory and the
+  /// compiler arguments to the corresponding precompiled preamble.
+  llvm::StringMap<Entry *> Entries;
+
+  /// \brief Guards Entries and the statistics.
+  llvm::sys::Mutex Lock;
+
+  unsigned NumHits;
+  unsigned NumMisses;
+};
+
+} // end namespace tooling
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLING_PREAMBLE_CACHE_H
@@ -22,6 +22,7 @@
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Mutex.h"
 #include <set>
 #include <string>
 
@@ -207,6 +208,17 @@ public:
   /// be added during the run of the tool.
   Replacements &getReplacements();
 
+  /// \brief Adds \p Replace to the replacements of the tool.
+  ///
+  /// Unlike inserting into getReplacements() directly, this is safe to call
+  /// from actions running on several threads (see ClangTool::setNumThreads).
+  void addReplacement(const Replacement &Replace);
+
+  /// \brief Adds all of \p Replaces to the replacements of the tool.
+  ///
+  /// This is safe to call from actions running on several threads.
+  void addReplacements(const Replacements &Replaces);
+
   /// \brief Call run(), apply all generated replacements, and immediately save
   /// the results to disk.
   ///
@@ -227,6 +239,7 @@ private:
 
 private:
   Replacements Replace;
+  llvm::sys::Mutex ReplaceLock;
 };
 
 template <typename Node>
@@ -37,6 +37,7 @@
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Tooling/ArgumentsAdjusters.h"
 #include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/PreambleCache.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Twine.h"
 #include <string>
@@ -208,6 +209,10 @@ class ToolInvocation {
   /// \param Content A null terminated buffer of the file's content.
   void mapVirtualFile(StringRef FilePath, StringRef Content);
 
+  /// \brief Share precompiled preambles with other invocations through
+  /// \p Preambles.  Requires a \c FileManager.
+  void setPreambleCache(PreambleCache *Preambles);
+
   /// \brief Run the clang invocation.
   ///
   /// \returns True if there were no errors during execution.
@@ -227,6 +232,7 @@ class ToolInvocation {
   // Maps <file name> -> <file content>.
   llvm::StringMap<StringRef> MappedFileContents;
   DiagnosticConsumer *DiagConsumer;
+  PreambleCache *Preambles;
 };
 
 /// \brief Utility to run a FrontendAction over a set of files.
@@ -254,8 +260,11 @@ class ClangTool {
 
   /// \brief Map a virtual file to be used while running the tool.
   ///
+  /// The file is added to a \c FileOverlay shared by all translation units,
+  /// so it must be mapped before the first call to run().
+  ///
   /// \param FilePath The path at which the content will be mapped.
-  /// \param Content A null terminated buffer of the file's content.
+  /// \param Content The file's content, which is copied.
   void mapVirtualFile(StringRef FilePath, StringRef Content);
 
   /// \brief Install command line arguments adjuster.
@@ -275,6 +284,24 @@ class ClangTool {
   /// \brief Clear the command line arguments adjuster chain.
   void clearArgumentsAdjusters();
 
+  /// \brief Lets translation units that start with the same #includes and
+  /// are compiled with the same flags share one precompiled preamble.
+  ///
+  /// See \c PreambleCache for the caveats.  Off by default.
+  void setSharePreambles(bool Share);
+
+  /// \brief Sets the number of translation units to process concurrently.
+  ///
+  /// With more than one thread, run() processes independent compile commands
+  /// on a pool of worker threads.  Each command then gets its own
+  /// \c FileManager rooted at the command's directory instead of changing
+  /// the process' working directory; these share the mapped files and the
+  /// results of 'stat' calls on absolute paths.  Diagnostics are buffered per
+  /// translation unit, and the \c ToolAction passed to run() must be safe to
+  /// call concurrently.  The default is 1, which processes commands one at a
+  /// time.
+  void setNumThreads(unsigned NumThreads);
+
   /// Runs an action over all files specified in the command line.
   ///
   /// \param Action Tool action.
@@ -286,20 +313,40 @@ class ClangTool {
 
   /// \brief Returns the file manager used in the tool.
   ///
-  /// The file manager is shared between all translation units.
+  /// The file manager is shared between all translation units, unless they
+  /// are processed in parallel (see setNumThreads()).
   FileManager &getFiles() { return *Files; }
 
  private:
+  struct ParallelRun;
+
+  /// \brief Returns the command line for CompileCommands[I] after running the
+  /// arguments adjusters.
+  std::vector<std::string> getAdjustedCommandLine(
+      unsigned I, const std::string &MainExecutable) const;
+
+  /// \brief Runs \p Action over one compile command on a worker thread.
+  static void runCommandInParallel(void *Run, unsigned I);
+
+  int runInParallel(ToolAction *Action, const std::string &MainExecutable);
+
   // We store compile commands as pair (file name, compile command).
   std::vector< std::pair<std::string, CompileCommand> > CompileCommands;
 
+  /// \brief The options of all file managers: the mapped files and a stat
+  /// cache shared by all translation units.
+  FileSystemOptions FileSystemOpts;
+
   llvm::IntrusiveRefCntPtr<FileManager> Files;
-  // Contains a list of pairs (<file name>, <file content>).
-  std::vector< std::pair<StringRef, StringRef> > MappedFileContents;
 
   SmallVector<ArgumentsAdjuster *, 2> ArgsAdjusters;
 
   DiagnosticConsumer *DiagConsumer;
+
+  unsigned NumThreads;
+
+  /// \brief The preambles shared between translation units, if enabled.
+  OwningPtr<PreambleCache> Preambles;
 };
 
 template <typename T>
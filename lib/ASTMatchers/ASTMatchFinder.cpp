@@ -20,6 +20,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/RecursiveASTVisitor.h"
+#include "llvm/ADT/DenseMap.h"
 #include <deque>
 #include <set>
 
@@ -34,6 +35,8 @@ typedef MatchFinder::MatchCallback MatchCallback;
 // 10k has been experimentally found to give a good trade-off
 // of performance vs. memory consumption by running matcher
 // that match on every statement over a very large codebase.
+// The entries are split between the two generations of the
+// MemoizationCache.
 //
 // FIXME: Do some performance optimization in general and
 // revisit this number; also, put up micro-benchmarks that we can
@@ -72,6 +75,61 @@ struct MemoizedMatchResult {
   BoundNodesTreeBuilder Nodes;
 };
 
+// Maps (matcher, node) -> the match result for memoization.
+//
+// Throwing away all results once the cache is full also throws away the ones
+// that are still being reused, like those for the ancestors of the node that
+// is currently visited.  Instead, the results are kept in two generations:
+// new results go into the current generation, and results found in the
+// previous generation are moved into the current one.  Once the current
+// generation is full it replaces the previous one, so only the results that
+// were not used since then are dropped.
+class MemoizationCache {
+public:
+  explicit MemoizationCache(MatchFinder::MatchStatistics *Stats)
+      : Stats(Stats) {}
+
+  // Returns the memoized result for \p Key, or NULL if there is none.
+  //
+  // The result is only valid until the next call to insert() or
+  // rotateIfFull().
+  const MemoizedMatchResult *find(const MatchKey &Key) {
+    MemoizationMap::iterator I = Current.find(Key);
+    if (I == Current.end()) {
+      MemoizationMap::iterator Old = Previous.find(Key);
+      if (Old == Previous.end()) {
+        ++Stats->MemoizationMisses;
+        return NULL;
+      }
+      I = Current.insert(*Old).first;
+      Previous.erase(Old);
+    }
+    ++Stats->MemoizationHits;
+    return &I->second;
+  }
+
+  void insert(const MatchKey &Key, const MemoizedMatchResult &Result) {
+    Current[Key] = Result;
+  }
+
+  // Starts a new generation if the current one is full.
+  //
+  // Must not be called while a result returned by find() is in use.
+  void rotateIfFull() {
+    if (Current.size() < MaxMemoizationEntries / 2)
+      return;
+    Stats->MemoizationEvictions += Previous.size();
+    Previous.swap(Current);
+    Current.clear();
+  }
+
+private:
+  typedef std::map<MatchKey, MemoizedMatchResult> MemoizationMap;
+  MemoizationMap Current;
+  MemoizationMap Previous;
+  MatchFinder::MatchStatistics *const Stats;
+};
+
 // A RecursiveASTVisitor that traverses all children or all descendants of
 // a node.
 class MatchChildASTVisitor
@@ -297,8 +355,10 @@ class MatchASTVisitor : public RecursiveASTVisitor<MatchASTVisitor>,
 public:
   MatchASTVisitor(
       std::vector<std::pair<internal::DynTypedMatcher, MatchCallback *> > *
-          MatcherCallbackPairs)
-      : MatcherCallbackPairs(MatcherCallbackPairs), ActiveASTContext(NULL) {}
+          MatcherCallbackPairs,
+      MatchFinder::MatchStatistics *Stats)
+      : MatcherCallbackPairs(MatcherCallbackPairs), ActiveASTContext(NULL),
+        Stats(Stats), ResultCache(Stats) {}
 
   void onStartOfTranslationUnit() {
     for (std::vector<std::pair<internal::DynTypedMatcher,
@@ -385,17 +445,16 @@ public:
     // Note that we key on the bindings *before* the match.
     Key.BoundNodes = *Builder;
 
-    MemoizationMap::iterator I = ResultCache.find(Key);
-    if (I != ResultCache.end()) {
-      *Builder = I->second.Nodes;
-      return I->second.ResultOfMatch;
+    if (const MemoizedMatchResult *Cached = ResultCache.find(Key)) {
+      *Builder = Cached->Nodes;
+      return Cached->ResultOfMatch;
     }
 
     MemoizedMatchResult Result;
     Result.Nodes = *Builder;
     Result.ResultOfMatch = matchesRecursively(Node, Matcher, &Result.Nodes,
                                               MaxDepth, Traversal, Bind);
-    ResultCache[Key] = Result;
+    ResultCache.insert(Key, Result);
     *Builder = Result.Nodes;
     return Result.ResultOfMatch;
   }
@@ -420,8 +479,7 @@ public:
                               BoundNodesTreeBuilder *Builder,
                               TraversalKind Traversal,
                               BindKind Bind) {
-    if (ResultCache.size() > MaxMemoizationEntries)
-      ResultCache.clear();
+    ResultCache.rotateIfFull();
     return memoizedMatchesRecursively(Node, Matcher, Builder, 1, Traversal,
                                       Bind);
   }
@@ -430,8 +488,7 @@ public:
                                    const DynTypedMatcher &Matcher,
                                    BoundNodesTreeBuilder *Builder,
                                    BindKind Bind) {
-    if (ResultCache.size() > MaxMemoizationEntries)
-      ResultCache.clear();
+    ResultCache.rotateIfFull();
     return memoizedMatchesRecursively(Node, Matcher, Builder, INT_MAX,
                                       TK_AsIs, Bind);
   }
@@ -442,8 +499,7 @@ public:
                                  AncestorMatchMode MatchMode) {
     // Reset the cache outside of the recursive call to make sure we
     // don't invalidate any iterators.
-    if (ResultCache.size() > MaxMemoizationEntries)
-      ResultCache.clear();
+    ResultCache.rotateIfFull();
     return memoizedMatchesAncestorOfRecursively(Node, Matcher, Builder,
                                                 MatchMode);
   }
@@ -451,19 +507,30 @@ public:
   // Matches all registered matchers on the given node and calls the
   // result callback for every node that matches.
   void match(const ast_type_traits::DynTypedNode& Node) {
+    Stats->MatcherInvocations += MatcherCallbackPairs->size();
     for (std::vector<std::pair<internal::DynTypedMatcher,
                                MatchCallback *> >::const_iterator
              I = MatcherCallbackPairs->begin(),
              E = MatcherCallbackPairs->end();
          I != E; ++I) {
-      BoundNodesTreeBuilder Builder;
-      if (I->first.matches(Node, this, &Builder)) {
-        MatchVisitor Visitor(ActiveASTContext, I->second);
-        Builder.visitMatches(&Visitor);
-      }
+      matchWith(Node, *I);
     }
   }
 
+  // Declarations and statements are the bulk of the AST, and most matchers
+  // only match a few kinds of them, so only run the matchers that can match
+  // the kind of node at hand.
+  void match(const Decl &Node) {
+    matchWithFilter(ast_type_traits::DynTypedNode::create(Node),
+                    getFilter(DeclFilters, Node.getKind(),
+                              ast_type_traits::ASTNodeKind::getFromNode(Node)));
+  }
+  void match(const Stmt &Node) {
+    matchWithFilter(ast_type_traits::DynTypedNode::create(Node),
+                    getFilter(StmtFilters, Node.getStmtClass(),
+                              ast_type_traits::ASTNodeKind::getFromNode(Node)));
+  }
+
   template <typename T> void match(const T &Node) {
     match(ast_type_traits::DynTypedNode::create(Node));
   }
@@ -478,6 +545,56 @@ public:
   bool shouldUseDataRecursionFor(clang::Stmt *S) const { return false; }
 
 private:
+  typedef std::pair<internal::DynTypedMatcher, MatchCallback *>
+      MatcherCallbackPair;
+
+  // Maps a Decl::Kind or Stmt::StmtClass to the indices of the matchers in
+  // MatcherCallbackPairs that can match nodes of that kind.
+  typedef llvm::DenseMap<unsigned, std::vector<unsigned> > MatcherFilterMap;
+
+  // Runs \p Pair's matcher on \p Node and calls its callback on a match.
+  void matchWith(const ast_type_traits::DynTypedNode &Node,
+                 const MatcherCallbackPair &Pair) {
+    BoundNodesTreeBuilder Builder;
+    if (Pair.first.matches(Node, this, &Builder)) {
+      MatchVisitor Visitor(ActiveASTContext, Pair.second);
+      Builder.visitMatches(&Visitor);
+    }
+  }
+
+  void matchWithFilter(const ast_type_traits::DynTypedNode &Node,
+                       const std::vector<unsigned> &Filter) {
+    Stats->MatcherInvocations += Filter.size();
+    Stats->SkippedMatcherInvocations +=
+        MatcherCallbackPairs->size() - Filter.size();
+    for (std::vector<unsigned>::const_iterator I = Filter.begin(),
+                                               E = Filter.end();
+         I != E; ++I)
+      matchWith(Node, (*MatcherCallbackPairs)[*I]);
+  }
+
+  // Returns the matchers that can match nodes of kind \p Kind, which is
+  // identified by \p Key in \p Filters.
+  //
+  // The filter is computed the first time a node of that kind is visited.
+  // Matchers keep their registration order, so callbacks for the same node
+  // are called in the same order as without filtering.
+  const std::vector<unsigned> &getFilter(MatcherFilterMap &Filters,
+                                         unsigned Key,
+                                         ast_type_traits::ASTNodeKind Kind) {
+    MatcherFilterMap::iterator It = Filters.find(Key);
+    if (It != Filters.end())
+      return It->second;
+    std::vector<unsigned> &Filter = Filters[Key];
+    for (unsigned I = 0, E = MatcherCallbackPairs->size(); I != E; ++I) {
+      ast_type_traits::ASTNodeKind RestrictKind =
+          (*MatcherCallbackPairs)[I].first.getRestrictKind();
+      if (RestrictKind.isNone() || RestrictKind.isBaseOf(Kind))
+        Filter.push_back(I);
+    }
+    return Filter;
+  }
+
   // Returns whether an ancestor of \p Node matches \p Matcher.
   //
   // The order of matching ((which can lead to different nodes being bound in
@@ -510,12 +627,11 @@ private:
     Key.Node = Node;
     Key.BoundNodes = *Builder;
 
-    // Note that we cannot use insert and reuse the iterator, as recursive
-    // calls to match might invalidate the result cache iterators.
-    MemoizationMap::iterator I = ResultCache.find(Key);
-    if (I != ResultCache.end()) {
-      *Builder = I->second.Nodes;
-      return I->second.ResultOfMatch;
+    // Note that we cannot insert a placeholder and fill it in later, as
+    // recursive calls to match might rotate the result cache.
+    if (const MemoizedMatchResult *Cached = ResultCache.find(Key)) {
+      *Builder = Cached->Nodes;
+      return Cached->ResultOfMatch;
     }
     MemoizedMatchResult Result;
     Result.ResultOfMatch = false;
@@ -561,7 +677,7 @@ private:
         Queue.pop_front();
       }
     }
-    ResultCache[Key] = Result;
+    ResultCache.insert(Key, Result);
 
     *Builder = Result.Nodes;
     return Result.ResultOfMatch;
@@ -612,9 +728,12 @@ private:
   // Maps a canonical type to its TypedefDecls.
   llvm::DenseMap<const Type*, std::set<const TypedefNameDecl*> > TypeAliases;
 
-  // Maps (matcher, node) -> the match result for memoization.
-  typedef std::map<MatchKey, MemoizedMatchResult> MemoizationMap;
-  MemoizationMap ResultCache;
+  MatchFinder::MatchStatistics *const Stats;
+
+  MemoizationCache ResultCache;
+
+  MatcherFilterMap DeclFilters;
+  MatcherFilterMap StmtFilters;
 };
 
 static CXXRecordDecl *getAsCXXRecordDecl(const Type *TypeNode) {
@@ -771,6 +890,10 @@ MatchFinder::MatchResult::MatchResult(const BoundNodes &Nodes,
 MatchFinder::MatchCallback::~MatchCallback() {}
 MatchFinder::ParsingDoneTestCallback::~ParsingDoneTestCallback() {}
 
+MatchFinder::MatchStatistics::MatchStatistics()
+    : MemoizationHits(0), MemoizationMisses(0), MemoizationEvictions(0),
+      MatcherInvocations(0), SkippedMatcherInvocations(0) {}
+
 MatchFinder::MatchFinder() : ParsingDone(NULL) {}
 
 MatchFinder::~MatchFinder() {}
@@ -835,13 +958,13 @@ ASTConsumer *MatchFinder::newASTConsumer() {
 
 void MatchFinder::match(const clang::ast_type_traits::DynTypedNode &Node,
                         ASTContext &Context) {
-  internal::MatchASTVisitor Visitor(&MatcherCallbackPairs);
+  internal::MatchASTVisitor Visitor(&MatcherCallbackPairs, &Statistics);
   Visitor.set_active_ast_context(&Context);
   Visitor.match(Node);
 }
 
 void MatchFinder::matchAST(ASTContext &Context) {
-  internal::MatchASTVisitor Visitor(&MatcherCallbackPairs);
+  internal::MatchASTVisitor Visitor(&MatcherCallbackPairs, &Statistics);
   Visitor.set_active_ast_context(&Context);
   Visitor.onStartOfTranslationUnit();
   Visitor.TraverseDecl(Context.getTranslationUnitDecl());
@@ -108,6 +108,9 @@ FileManager::FileManager(const FileSystemOptions &FSO)
     SeenDirEntries(64), SeenFileEntries(64), NextFileUID(0) {
   NumDirLookups = NumFileLookups = 0;
   NumDirCacheMisses = NumFileCacheMisses = 0;
+
+  if (FileSystemOpts.SharedStats)
+    addStatCache(new SharedStatCalls(FileSystemOpts.SharedStats.getPtr()));
 }
 
 FileManager::~FileManager() {
@@ -156,6 +159,11 @@ void FileManager::removeStatCache(FileSystemStatCache *statCache) {
 
 void FileManager::clearStatCaches() {
   StatCache.reset(0);
+
+  // The shared stat cache comes with the file system options rather than
+  // with whatever the client is doing, so keep it.
+  if (FileSystemOpts.SharedStats)
+    addStatCache(new SharedStatCalls(FileSystemOpts.SharedStats.getPtr()));
 }
 
 /// \brief Retrieve the directory that the given file name resides in.
@@ -282,6 +290,18 @@ const FileEntry *FileManager::getFile(StringRef Filename, bool openFile,
     return NamedFileEnt.getValue() == NON_EXISTENT_FILE
                  ? 0 : NamedFileEnt.getValue();
 
+  // Files in the overlay exist whatever is on disk. Every spelling of their
+  // paths gets the entry named by the canonical path.
+  if (FileSystemOpts.Overlay)
+    if (const llvm::MemoryBuffer *Contents =
+            FileSystemOpts.Overlay->getFile(Filename,
+                                            FileSystemOpts.WorkingDir)) {
+      const FileEntry *Entry = getVirtualFile(
+          Contents->getBufferIdentifier(), Contents->getBufferSize(), 0);
+      NamedFileEnt.setValue(const_cast<FileEntry *>(Entry));
+      return Entry;
+    }
+
   ++NumFileCacheMisses;
 
   // By default, initialize it to invalid.
@@ -433,6 +453,9 @@ void FileManager::FixupRelativePath(SmallVectorImpl<char> &path) const {
 llvm::MemoryBuffer *FileManager::
 getBufferForFile(const FileEntry *Entry, std::string *ErrorStr,
                  bool isVolatile) {
+  if (llvm::MemoryBuffer *Buffer = getOverlayBuffer(Entry->getName()))
+    return Buffer;
+
   OwningPtr<llvm::MemoryBuffer> Result;
   llvm::error_code ec;
 
@@ -473,6 +496,9 @@ getBufferForFile(const FileEntry *Entry, std::string *ErrorStr,
 
 llvm::MemoryBuffer *FileManager::
 getBufferForFile(StringRef Filename, std::string *ErrorStr) {
+  if (llvm::MemoryBuffer *Buffer = getOverlayBuffer(Filename))
+    return Buffer;
+
   OwningPtr<llvm::MemoryBuffer> Result;
   llvm::error_code ec;
   if (FileSystemOpts.WorkingDir.empty()) {
@@ -490,6 +516,18 @@ getBufferForFile(StringRef Filename, std::string *ErrorStr) {
   return Result.take();
 }
 
+llvm::MemoryBuffer *FileManager::getOverlayBuffer(StringRef Filename) const {
+  if (!FileSystemOpts.Overlay)
+    return 0;
+  const llvm::MemoryBuffer *Contents =
+      FileSystemOpts.Overlay->getFile(Filename, FileSystemOpts.WorkingDir);
+  if (!Contents)
+    return 0;
+  // The overlay keeps the contents; hand out a buffer which refers to them.
+  return llvm::MemoryBuffer::getMemBuffer(Contents->getBuffer(),
+                                          Contents->getBufferIdentifier());
+}
+
 /// getStatValue - Get the 'stat' information for the specified path,
 /// using the cache to accelerate it if possible.  This returns true
 /// if the path points to a virtual file or does not exist, or returns
@@ -522,6 +560,8 @@ void FileManager::invalidateCache(const FileEntry *Entry) {
   assert(Entry && "Cannot invalidate a NULL FileEntry");
 
   SeenFileEntries.erase(Entry->getName());
+  if (FileSystemOpts.SharedStats)
+    FileSystemOpts.SharedStats->invalidate(Entry->getName());
 
   // FileEntry invalidation should not block future optimizations in the file
   // caches. Possible alternatives are cache truncation (invalidate last N) or
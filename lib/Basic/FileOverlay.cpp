@@ -0,0 +1,78 @@
+//===--- FileOverlay.cpp - Files held in memory ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the FileOverlay interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/FileOverlay.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+
+using namespace clang;
+
+FileOverlay::FileOverlay() {
+  if (llvm::sys::fs::current_path(CurrentDir))
+    CurrentDir.clear();
+}
+
+FileOverlay::~FileOverlay() {
+  for (llvm::StringMap<llvm::MemoryBuffer *>::iterator I = Files.begin(),
+                                                       E = Files.end();
+       I != E; ++I)
+    delete I->getValue();
+}
+
+void FileOverlay::getCanonicalPath(StringRef Path, StringRef WorkingDir,
+                                   SmallVectorImpl<char> &Result) const {
+  SmallString<128> Absolute;
+  if (!llvm::sys::path::is_absolute(Path))
+    Absolute = WorkingDir.empty() ? StringRef(CurrentDir) : WorkingDir;
+  llvm::sys::path::append(Absolute, Path);
+
+  // Drop the "." components, and the ".." ones along with their parents.
+  StringRef Relative = llvm::sys::path::relative_path(Absolute);
+  SmallVector<StringRef, 16> Components;
+  for (llvm::sys::path::const_iterator I = llvm::sys::path::begin(Relative),
+                                       E = llvm::sys::path::end(Relative);
+       I != E; ++I) {
+    if (*I == "..") {
+      if (!Components.empty())
+        Components.pop_back();
+    } else if (*I != ".") {
+      Components.push_back(*I);
+    }
+  }
+
+  SmallString<128> Canonical(llvm::sys::path::root_path(Absolute));
+  for (unsigned I = 0, E = Components.size(); I != E; ++I)
+    llvm::sys::path::append(Canonical, Components[I]);
+  Result.clear();
+  llvm::sys::path::native(Canonical.str(), Result);
+}
+
+void FileOverlay::addFile(StringRef Path, StringRef Contents) {
+  SmallString<128> CanonicalPath;
+  getCanonicalPath(Path, StringRef(), CanonicalPath);
+
+  llvm::MemoryBuffer *&Buffer = Files[CanonicalPath];
+  delete Buffer;
+  Buffer = llvm::MemoryBuffer::getMemBufferCopy(Contents, CanonicalPath.str());
+}
+
+const llvm::MemoryBuffer *FileOverlay::getFile(StringRef Path,
+                                               StringRef WorkingDir) const {
+  SmallString<128> CanonicalPath;
+  getCanonicalPath(Path, WorkingDir, CanonicalPath);
+
+  llvm::StringMap<llvm::MemoryBuffer *>::const_iterator I =
+      Files.find(CanonicalPath);
+  return I == Files.end() ? 0 : I->getValue();
+}
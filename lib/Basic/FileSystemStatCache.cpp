@@ -134,3 +134,101 @@ MemorizeStatCalls::getStat(const char *Path, FileData &Data, bool isFile,
 
   return Result;
 }
+
+bool SharedStatCache::lookup(StringRef Path, bool isFile, FileData &Data,
+                             FileSystemStatCache::LookupResult &Result) {
+  llvm::sys::ScopedLock L(Lock);
+  llvm::StringMap<Entry>::const_iterator I = Entries.find(Path);
+  if (I == Entries.end() ||
+      (!I->getValue().Exists &&
+       !(I->getValue().Missing & (isFile ? NotAFile : NotADirectory)))) {
+    ++NumMisses;
+    return false;
+  }
+
+  ++NumHits;
+  if (I->getValue().Exists) {
+    Data = I->getValue().Data;
+    Result = FileSystemStatCache::CacheExists;
+  } else {
+    Result = FileSystemStatCache::CacheMissing;
+  }
+  return true;
+}
+
+void SharedStatCache::insert(StringRef Path, bool isFile, const FileData &Data,
+                             FileSystemStatCache::LookupResult Result) {
+  if (Result != FileSystemStatCache::CacheExists && !CacheFailures)
+    return;
+
+  llvm::sys::ScopedLock L(Lock);
+  Entry &E = Entries[Path];
+  if (Result == FileSystemStatCache::CacheExists) {
+    E.Exists = true;
+    E.Data = Data;
+  } else if (!E.Exists) {
+    E.Missing |= isFile ? NotAFile : NotADirectory;
+  }
+}
+
+void SharedStatCache::invalidate(StringRef Path) {
+  llvm::sys::ScopedLock L(Lock);
+  Entries.erase(Path);
+}
+
+void SharedStatCache::revalidate() {
+  llvm::sys::ScopedLock L(Lock);
+  SmallVector<std::string, 16> Stale;
+  for (llvm::StringMap<Entry>::const_iterator I = Entries.begin(),
+                                              E = Entries.end();
+       I != E; ++I) {
+    const Entry &Cached = I->getValue();
+    llvm::sys::fs::file_status Status;
+    if (!Cached.Exists || llvm::sys::fs::status(I->getKey(), Status)) {
+      Stale.push_back(I->getKey());
+      continue;
+    }
+
+    FileData Data;
+    copyStatusToFileData(Status, Data);
+    if (Data.Size != Cached.Data.Size || Data.ModTime != Cached.Data.ModTime ||
+        Data.UniqueID != Cached.Data.UniqueID ||
+        Data.IsDirectory != Cached.Data.IsDirectory)
+      Stale.push_back(I->getKey());
+  }
+
+  for (unsigned I = 0, E = Stale.size(); I != E; ++I)
+    Entries.erase(Stale[I]);
+}
+
+unsigned SharedStatCache::getNumHits() const {
+  llvm::sys::ScopedLock L(Lock);
+  return NumHits;
+}
+
+unsigned SharedStatCache::getNumMisses() const {
+  llvm::sys::ScopedLock L(Lock);
+  return NumMisses;
+}
+
+SharedStatCalls::LookupResult
+SharedStatCalls::getStat(const char *Path, FileData &Data, bool isFile,
+                         int *FileDescriptor) {
+  // Relative paths depend on the working directory of each translation unit.
+  if (!llvm::sys::path::is_absolute(Path))
+    return statChained(Path, Data, isFile, FileDescriptor);
+
+  // A cached result comes without a file descriptor; the FileManager opens
+  // the file by name when it needs its contents.
+  LookupResult Result;
+  if (Shared->lookup(Path, isFile, Data, Result))
+    return Result;
+
+  Result = statChained(Path, Data, isFile, FileDescriptor);
+
+  // Entries of precompiled files only make sense to the translation unit
+  // which loaded them.
+  if (Result == CacheMissing || !Data.InPCH)
+    Shared->insert(Path, isFile, Data, Result);
+  return Result;
+}
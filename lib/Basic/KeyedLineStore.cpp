@@ -0,0 +1,154 @@
+//===--- KeyedLineStore.cpp - Keyed entries kept in a file ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the KeyedLineStore interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/KeyedLineStore.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+
+/// \brief Returns the header of the section starting at \p Line, or an empty
+/// string if \p Line is an entry.
+static StringRef getSectionHeader(StringRef Line) {
+  if (!Line.startswith("# "))
+    return StringRef();
+  return Line.substr(2);
+}
+
+void KeyedLineStore::parse(StringRef Buffer, EntryMap &Entries,
+                           SmallVectorImpl<StringRef> *OtherSections) const {
+  // Anything before the first section is ignored.
+  bool InSection = false;
+  const char *OtherStart = 0;
+  StringRef Line, Rest = Buffer;
+  while (!Rest.empty()) {
+    const char *LineStart = Rest.data();
+    llvm::tie(Line, Rest) = Rest.split('\n');
+
+    if (!getSectionHeader(Line).empty()) {
+      if (OtherStart && OtherSections)
+        OtherSections->push_back(StringRef(OtherStart, LineStart - OtherStart));
+      InSection = getSectionHeader(Line) == Header;
+      OtherStart = InSection ? 0 : LineStart;
+      continue;
+    }
+    if (!InSection)
+      continue;
+
+    // Find the end of the fields.
+    size_t KeyStart = 0;
+    unsigned I = 0;
+    for (; I != NumFields; ++I) {
+      size_t Space = Line.find(' ', KeyStart);
+      if (Space == StringRef::npos || Space == KeyStart)
+        break;
+      KeyStart = Space + 1;
+    }
+
+    StringRef Key = Line.substr(KeyStart);
+    if (I != NumFields || Key.empty())
+      continue;
+    Entries[Key] = KeyStart ? Line.substr(0, KeyStart - 1) : StringRef();
+  }
+  if (OtherStart && OtherSections)
+    OtherSections->push_back(StringRef(OtherStart, Buffer.end() - OtherStart));
+}
+
+void KeyedLineStore::read(EntryMap &Entries) const {
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (!llvm::MemoryBuffer::getFile(Path, Buffer))
+    parse(Buffer->getBuffer(), Entries, 0);
+}
+
+bool KeyedLineStore::write(const EntryMap &Entries,
+                           ArrayRef<StringRef> OtherSections) const {
+  SmallString<128> TmpPath;
+  int TmpFD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", TmpFD, TmpPath))
+    return true;
+
+  // Write a temporary file and rename it over the store, so that readers
+  // never see it partly written.
+  llvm::raw_fd_ostream Out(TmpFD, true);
+  Out << "# " << Header << '\n';
+  for (EntryMap::const_iterator I = Entries.begin(), E = Entries.end();
+       I != E; ++I) {
+    if (NumFields)
+      Out << I->getValue() << ' ';
+    Out << I->getKey() << '\n';
+  }
+
+  // Put the section just updated first, so that the sections left unused the
+  // longest are the ones dropped.
+  for (unsigned I = 0, E = std::min<size_t>(OtherSections.size(),
+                                            MaxSections - 1);
+       I != E; ++I) {
+    Out << OtherSections[I];
+    if (!OtherSections[I].endswith("\n"))
+      Out << '\n';
+  }
+  Out.close();
+
+  bool Existed;
+  if (Out.has_error() || llvm::sys::fs::rename(TmpPath.str(), Path)) {
+    llvm::sys::fs::remove(TmpPath.str(), Existed);
+    return true;
+  }
+  return false;
+}
+
+bool KeyedLineStore::update(const EntryMap &Entries, MergeFn Merge) const {
+  if (Entries.empty())
+    return false;
+
+  StringRef Dir = llvm::sys::path::parent_path(Path);
+  if (!Dir.empty() && llvm::sys::fs::create_directories(Dir))
+    return true;
+
+  for (;;) {
+    llvm::LockFileManager Locked(Path);
+    switch (Locked) {
+    case llvm::LockFileManager::LFS_Error:
+      return true;
+
+    case llvm::LockFileManager::LFS_Shared:
+      Locked.waitForUnlock();
+      continue;
+
+    case llvm::LockFileManager::LFS_Owned:
+      break;
+    }
+
+    // The other sections point into Buffer, which must outlive write().
+    OwningPtr<llvm::MemoryBuffer> Buffer;
+    EntryMap Merged;
+    SmallVector<StringRef, 4> OtherSections;
+    if (!llvm::MemoryBuffer::getFile(Path, Buffer))
+      parse(Buffer->getBuffer(), Merged, &OtherSections);
+    for (EntryMap::const_iterator I = Entries.begin(), E = Entries.end();
+         I != E; ++I) {
+      EntryMap::iterator Old = Merged.find(I->getKey());
+      if (Merge && Old != Merged.end())
+        Merge(Old->getValue(), I->getValue());
+      else
+        Merged[I->getKey()] = I->getValue();
+    }
+    return write(Merged, OtherSections);
+  }
+}
@@ -0,0 +1,118 @@
+//===--- Parallel.cpp - Running independent tasks concurrently ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements runInParallel() on top of pthreads.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Parallel.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Atomic.h"
+#include "llvm/Support/Threading.h"
+
+#if LLVM_ENABLE_THREADS != 0 && defined(LLVM_ON_UNIX)
+#include <pthread.h>
+#include <unistd.h>
+#define CLANG_PARALLEL_USE_PTHREADS 1
+#endif
+
+using namespace clang;
+
+unsigned clang::getNumHardwareThreads() {
+#if defined(CLANG_PARALLEL_USE_PTHREADS) && defined(_SC_NPROCESSORS_ONLN)
+  long N = sysconf(_SC_NPROCESSORS_ONLN);
+  if (N > 0)
+    return static_cast<unsigned>(N);
+#endif
+  return 1;
+}
+
+bool clang::isParallelExecutionSupported() {
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+  return true;
+#else
+  return false;
+#endif
+}
+
+namespace {
+
+/// \brief The state shared by all threads taking part in one runInParallel().
+struct ParallelTasks {
+  void (*Fn)(void *UserData, unsigned TaskIndex);
+  void *UserData;
+  unsigned NumTasks;
+  /// \brief The number of tasks handed out so far.
+  volatile llvm::sys::cas_flag NextTask;
+};
+
+} // end anonymous namespace
+
+static void runTasks(ParallelTasks &Tasks) {
+  while (true) {
+    unsigned I = llvm::sys::AtomicIncrement(&Tasks.NextTask) - 1;
+    if (I >= Tasks.NumTasks)
+      return;
+    Tasks.Fn(Tasks.UserData, I);
+  }
+}
+
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+static void *runTasksOnThread(void *Arg) {
+  runTasks(*static_cast<ParallelTasks *>(Arg));
+  return 0;
+}
+#endif
+
+void clang::runInParallel(unsigned NumTasks, unsigned NumThreads,
+                          void (*Fn)(void *UserData, unsigned TaskIndex),
+                          void *UserData) {
+  ParallelTasks Tasks;
+  Tasks.Fn = Fn;
+  Tasks.UserData = UserData;
+  Tasks.NumTasks = NumTasks;
+  Tasks.NextTask = 0;
+
+  if (NumThreads > NumTasks)
+    NumThreads = NumTasks;
+
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+  SmallVector<pthread_t, 16> Threads;
+  // LLVM's lazily-initialized globals are only guarded once multithreaded
+  // mode has been entered; starting it twice is an error.
+  if (NumThreads > 1 && !llvm::llvm_is_multithreaded())
+    llvm::llvm_start_multithreaded();
+  if (NumThreads > 1 && llvm::llvm_is_multithreaded()) {
+    // Parsing and analysis recurse deeply, so give each worker the same
+    // generous stack that libclang uses for its parsing threads.
+    pthread_attr_t Attr;
+    pthread_attr_init(&Attr);
+    pthread_attr_setstacksize(&Attr, 8 << 20);
+    for (unsigned I = 1; I != NumThreads; ++I) {
+      pthread_t Thread;
+      // If we fail to create a thread, the threads we already have (or the
+      // calling thread alone) will pick up the remaining tasks.
+      if (pthread_create(&Thread, &Attr, runTasksOnThread, &Tasks) != 0)
+        break;
+      Threads.push_back(Thread);
+    }
+    pthread_attr_destroy(&Attr);
+  }
+#endif
+
+  // The calling thread does its share of the work as well.
+  runTasks(Tasks);
+
+#ifdef CLANG_PARALLEL_USE_PTHREADS
+  for (unsigned I = 0, E = Threads.size(); I != E; ++I)
+    pthread_join(Threads[I], 0);
+#endif
+}
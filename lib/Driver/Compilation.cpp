@@ -8,12 +8,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Driver/Compilation.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Driver/Action.h"
 #include "clang/Driver/Driver.h"
 #include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Driver/Options.h"
 #include "clang/Driver/ToolChain.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
@@ -27,7 +29,7 @@ using namespace llvm::opt;
 Compilation::Compilation(const Driver &D, const ToolChain &_DefaultToolChain,
                          InputArgList *_Args, DerivedArgList *_TranslatedArgs)
   : TheDriver(D), DefaultToolChain(_DefaultToolChain), Args(_Args),
-    TranslatedArgs(_TranslatedArgs), Redirects(0) {
+    TranslatedArgs(_TranslatedArgs), Redirects(0), NumParallelJobs(1) {
 }
 
 Compilation::~Compilation() {
@@ -126,8 +128,7 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
+bool Compilation::PrintCommandIfRequested(const Command &C) const {
   if ((getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
     raw_ostream *OS = &llvm::errs();
@@ -141,9 +142,8 @@ int Compilation::ExecuteCommand(const Command &C,
       if (!Error.empty()) {
         getDriver().Diag(clang::diag::err_drv_cc_print_options_failure)
           << Error;
-        FailingCommand = &C;
         delete OS;
-        return 1;
+        return false;
       }
     }
 
@@ -155,6 +155,15 @@ int Compilation::ExecuteCommand(const Command &C,
     if (OS != &llvm::errs())
       delete OS;
   }
+  return true;
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!PrintCommandIfRequested(C)) {
+    FailingCommand = &C;
+    return 1;
+  }
 
   std::string Error;
   bool ExecutionFailed;
@@ -211,6 +220,131 @@ void Compilation::ExecuteJob(const Job &J,
   }
 }
 
+/// Append all the commands in \p J to \p Commands, in execution order.
+static void collectCommands(const Job &J,
+                            SmallVectorImpl<const Command *> &Commands) {
+  if (const Command *C = dyn_cast<Command>(&J)) {
+    Commands.push_back(C);
+    return;
+  }
+  const JobList *Jobs = cast<JobList>(&J);
+  for (JobList::const_iterator it = Jobs->begin(), ie = Jobs->end();
+       it != ie; ++it)
+    collectCommands(**it, Commands);
+}
+
+/// Add \p A and all the actions it (transitively) depends on to \p Actions.
+static void collectActions(const Action *A,
+                           llvm::SmallPtrSet<const Action *, 16> &Actions) {
+  if (!Actions.insert(A))
+    return;
+  for (Action::const_iterator it = A->begin(), ie = A->end(); it != ie; ++it)
+    collectActions(*it, Actions);
+}
+
+namespace {
+/// The commands of one round of parallel execution and their results.
+struct CommandBatch {
+  const StringRef **Redirects;
+  SmallVector<const Command *, 16> Commands;
+  SmallVector<int, 16> Results;
+  SmallVector<std::string, 16> Errors;
+  SmallVector<bool, 16> ExecutionFailed;
+};
+}
+
+static void executeBatchCommand(void *UserData, unsigned I) {
+  CommandBatch &Batch = *static_cast<CommandBatch *>(UserData);
+  bool ExecutionFailed = false;
+  Batch.Results[I] = Batch.Commands[I]->Execute(Batch.Redirects,
+                                                &Batch.Errors[I],
+                                                &ExecutionFailed);
+  Batch.ExecutionFailed[I] = ExecutionFailed;
+}
+
+void Compilation::ExecuteJobs(const JobList &Jobs,
+                              FailingCommandList &FailingCommands) const {
+  if (NumParallelJobs <= 1 || !isParallelExecutionSupported()) {
+    ExecuteJob(Jobs, FailingCommands);
+    return;
+  }
+
+  SmallVector<const Command *, 16> Commands;
+  collectCommands(Jobs, Commands);
+
+  // A command has to wait for every earlier command whose action produces
+  // one of its (transitive) inputs.
+  std::vector<SmallVector<unsigned, 4> > Dependencies(Commands.size());
+  for (unsigned i = 0, e = Commands.size(); i != e; ++i) {
+    llvm::SmallPtrSet<const Action *, 16> Inputs;
+    const Action &Source = Commands[i]->getSource();
+    for (Action::const_iterator it = Source.begin(), ie = Source.end();
+         it != ie; ++it)
+      collectActions(*it, Inputs);
+    for (unsigned j = 0; j != i; ++j)
+      if (Inputs.count(&Commands[j]->getSource()))
+        Dependencies[i].push_back(j);
+  }
+
+  // Run the commands in rounds: each round starts every command whose
+  // dependencies have all finished, and waits for all of them to complete.
+  std::vector<bool> Finished(Commands.size(), false);
+  unsigned NumFinished = 0;
+  while (NumFinished != Commands.size()) {
+    CommandBatch Batch;
+    Batch.Redirects = Redirects;
+    SmallVector<unsigned, 16> BatchIndices;
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i) {
+      if (Finished[i])
+        continue;
+      bool Ready = true;
+      for (unsigned j = 0, je = Dependencies[i].size(); j != je; ++j)
+        if (!Finished[Dependencies[i][j]]) {
+          Ready = false;
+          break;
+        }
+      if (Ready)
+        BatchIndices.push_back(i);
+    }
+    assert(!BatchIndices.empty() && "Cyclic command dependencies!");
+
+    // Skip the commands whose inputs failed, and log the ones we are about
+    // to start, serially and in job order.
+    for (unsigned i = 0, e = BatchIndices.size(); i != e; ++i) {
+      const Command *C = Commands[BatchIndices[i]];
+      Finished[BatchIndices[i]] = true;
+      ++NumFinished;
+      if (!InputsOk(*C, FailingCommands))
+        continue;
+      if (!PrintCommandIfRequested(*C)) {
+        FailingCommands.push_back(std::make_pair(1, C));
+        continue;
+      }
+      Batch.Commands.push_back(C);
+    }
+    Batch.Results.resize(Batch.Commands.size());
+    Batch.Errors.resize(Batch.Commands.size());
+    Batch.ExecutionFailed.resize(Batch.Commands.size());
+
+    runInParallel(Batch.Commands.size(), NumParallelJobs, executeBatchCommand,
+                  &Batch);
+
+    // Diagnose the results on this thread, in job order.
+    for (unsigned i = 0, e = Batch.Commands.size(); i != e; ++i) {
+      int Res = Batch.Results[i];
+      if (!Batch.Errors[i].empty()) {
+        assert(Res && "Error string set with 0 result code!");
+        getDriver().Diag(clang::diag::err_drv_command_failure)
+          << Batch.Errors[i];
+      }
+      if (Batch.ExecutionFailed[i])
+        Res = 1;
+      if (Res)
+        FailingCommands.push_back(std::make_pair(Res, Batch.Commands[i]));
+    }
+  }
+}
+
 void Compilation::initCompilationForDiagnostics() {
   // Free actions and jobs.
   DeleteContainerPointers(Actions);
@@ -10,6 +10,7 @@
 #include "clang/Driver/Driver.h"
 #include "InputInfo.h"
 #include "ToolChains.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Basic/Version.h"
 #include "clang/Driver/Action.h"
 #include "clang/Driver/Compilation.h"
@@ -370,6 +371,15 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
   // The compilation takes ownership of Args.
   Compilation *C = new Compilation(*this, TC, Args, TranslatedArgs);
 
+  if (const Arg *A = Args->getLastArg(options::OPT_parallel_jobs_EQ)) {
+    unsigned NumJobs;
+    if (StringRef(A->getValue()).getAsInteger(10, NumJobs))
+      Diag(clang::diag::err_drv_invalid_int_value)
+        << A->getAsString(*Args) << A->getValue();
+    else
+      C->setNumParallelJobs(NumJobs ? NumJobs : getNumHardwareThreads());
+  }
+
   if (!HandleImmediateArgs(*C))
     return C;
 
@@ -570,7 +580,7 @@ int Driver::ExecuteCompilation(const Compilation &C,
   if (Diags.hasErrorOccurred())
     return 1;
 
-  C.ExecuteJob(C.getJobs(), FailingCommands);
+  C.ExecuteJobs(C.getJobs(), FailingCommands);
 
   // Remove temp files.
   C.CleanupFileList(C.getTempFiles());
@@ -28,6 +28,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/Path.h"
+#include <map>
 #include <queue>
 #include <string>
 
@@ -135,6 +136,8 @@ template <> struct MappingTraits<clang::format::FormatStyle> {
     IO.mapOptional("ExperimentalAutoDetectBinPacking",
                    Style.ExperimentalAutoDetectBinPacking);
     IO.mapOptional("IndentCaseLabels", Style.IndentCaseLabels);
+    IO.mapOptional("MaxAnalyzedStatesPerLine",
+                   Style.MaxAnalyzedStatesPerLine);
     IO.mapOptional("MaxEmptyLinesToKeep", Style.MaxEmptyLinesToKeep);
     IO.mapOptional("NamespaceIndentation", Style.NamespaceIndentation);
     IO.mapOptional("ObjCSpaceBeforeProtocolList",
@@ -209,6 +212,7 @@ FormatStyle getLLVMStyle() {
   LLVMStyle.IndentFunctionDeclarationAfterType = false;
   LLVMStyle.IndentWidth = 2;
   LLVMStyle.TabWidth = 8;
+  LLVMStyle.MaxAnalyzedStatesPerLine = 100000;
   LLVMStyle.MaxEmptyLinesToKeep = 1;
   LLVMStyle.NamespaceIndentation = FormatStyle::NI_None;
   LLVMStyle.ObjCSpaceBeforeProtocolList = true;
@@ -256,6 +260,7 @@ FormatStyle getGoogleStyle() {
   GoogleStyle.IndentFunctionDeclarationAfterType = true;
   GoogleStyle.IndentWidth = 2;
   GoogleStyle.TabWidth = 8;
+  GoogleStyle.MaxAnalyzedStatesPerLine = 100000;
   GoogleStyle.MaxEmptyLinesToKeep = 1;
   GoogleStyle.NamespaceIndentation = FormatStyle::NI_None;
   GoogleStyle.ObjCSpaceBeforeProtocolList = false;
@@ -374,6 +379,20 @@ private:
   ContinuationIndenter *Indenter;
 };
 
+/// \brief Returns \c true if \p Range overlaps one of \p Ranges.
+static bool rangesOverlap(SourceManager &SourceMgr,
+                          ArrayRef<CharSourceRange> Ranges,
+                          const CharSourceRange &Range) {
+  for (ArrayRef<CharSourceRange>::const_iterator I = Ranges.begin(),
+                                                 E = Ranges.end();
+       I != E; ++I) {
+    if (!SourceMgr.isBeforeInTranslationUnit(Range.getEnd(), I->getBegin()) &&
+        !SourceMgr.isBeforeInTranslationUnit(I->getEnd(), Range.getBegin()))
+      return true;
+  }
+  return false;
+}
+
 class LineJoiner {
 public:
   LineJoiner(const FormatStyle &Style) : Style(Style) {}
@@ -383,6 +402,12 @@ public:
   tryFitMultipleLinesInOne(unsigned Indent,
                            SmallVectorImpl<AnnotatedLine *>::const_iterator &I,
                            SmallVectorImpl<AnnotatedLine *>::const_iterator E) {
+    // Lines that are not affected by the formatted ranges have no formatting
+    // information, and are never reformatted anyway.
+    for (unsigned i = 0; i != 3 && I + i != E; ++i)
+      if (!I[i]->Affected)
+        return 0;
+
     // We can never merge stuff if there are trailing line comments.
     AnnotatedLine *TheLine = *I;
     if (TheLine->Last->Type == TT_LineComment)
@@ -698,6 +723,10 @@ private:
   typedef std::priority_queue<QueueItem, std::vector<QueueItem>,
                               std::greater<QueueItem> > QueueType;
 
+  /// \brief Maps each state added to the BFS queue to the lowest penalty it
+  /// was added with.
+  typedef std::map<LineState, unsigned> PenaltyMap;
+
   /// \brief Get the offset of the line relatively to the level.
   ///
   /// For example, 'public:' labels in classes are offset by 1 or 2
@@ -769,14 +798,7 @@ private:
   }
 
   bool touchesRanges(const CharSourceRange &Range) {
-    for (SmallVectorImpl<CharSourceRange>::const_iterator I = Ranges.begin(),
-                                                          E = Ranges.end();
-         I != E; ++I) {
-      if (!SourceMgr.isBeforeInTranslationUnit(Range.getEnd(), I->getBegin()) &&
-          !SourceMgr.isBeforeInTranslationUnit(I->getEnd(), Range.getBegin()))
-        return true;
-    }
-    return false;
+    return rangesOverlap(SourceMgr, Ranges, Range);
   }
 
   bool touchesLine(const AnnotatedLine &TheLine) {
@@ -818,8 +840,12 @@ private:
   /// to a state where all tokens are placed. Returns the penalty.
   ///
   /// If \p DryRun is \c false, directly applies the changes.
+  ///
+  /// If more than \c Style.MaxAnalyzedStatesPerLine states are created, the
+  /// cheapest state found so far is completed greedily instead.
   unsigned analyzeSolutionSpace(LineState &InitialState, bool DryRun = false) {
     std::set<LineState> Seen;
+    PenaltyMap Queued;
 
     // Increasing count of \c StateNode items we have created. This is used to
     // create a deterministic order independent of the container.
@@ -833,6 +859,7 @@ private:
     ++Count;
 
     unsigned Penalty = 0;
+    StateNode *Solution = NULL;
 
     // While not empty, take first element and follow edges.
     while (!Queue.empty()) {
@@ -840,10 +867,26 @@ private:
       StateNode *Node = Queue.top().second;
       if (Node->State.NextToken == NULL) {
         DEBUG(llvm::dbgs() << "\n---\nPenalty for line: " << Penalty << "\n");
+        Solution = Node;
         break;
       }
       Queue.pop();
 
+      // Stop searching if the line is too complex, and settle for the best
+      // completion of the most promising state.
+      if (Style.MaxAnalyzedStatesPerLine != 0 &&
+          Count > Style.MaxAnalyzedStatesPerLine) {
+        unsigned GreedyPenalty = Penalty;
+        Solution = completeGreedily(Node, GreedyPenalty);
+        if (Solution) {
+          Penalty = GreedyPenalty;
+          DEBUG(llvm::dbgs() << "\n---\nState budget exhausted, greedy "
+                             << "penalty for line: " << Penalty << "\n");
+          break;
+        }
+        continue;
+      }
+
       // Cut off the analysis of certain solutions if the analysis gets too
       // complex. See description of IgnoreStackForComparison.
       if (Count > 10000)
@@ -855,12 +898,14 @@ private:
 
       FormatDecision LastFormat = Node->State.NextToken->Decision;
       if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
-        addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue);
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue,
+                            &Queued);
       if (LastFormat == FD_Unformatted || LastFormat == FD_Break)
-        addNextStateToQueue(Penalty, Node, /*NewLine=*/true, &Count, &Queue);
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/true, &Count, &Queue,
+                            &Queued);
     }
 
-    if (Queue.empty()) {
+    if (!Solution) {
       // We were unable to find a solution, do nothing.
       // FIXME: Add diagnostic?
       DEBUG(llvm::dbgs() << "Could not find a solution.\n");
@@ -869,7 +914,7 @@ private:
 
     // Reconstruct the solution.
     if (!DryRun)
-      reconstructPath(InitialState, Queue.top().second);
+      reconstructPath(InitialState, Solution);
 
     DEBUG(llvm::dbgs() << "Total number of analyzed states: " << Count << "\n");
     DEBUG(llvm::dbgs() << "---\n");
@@ -900,28 +945,84 @@ private:
     }
   }
 
-  /// \brief Add the following state to the analysis queue \c Queue.
+  /// \brief Creates the state following \p PreviousNode, inserting a line
+  /// break if \p NewLine is \c true.
   ///
-  /// Assume the current state is \p PreviousNode and has been reached with a
-  /// penalty of \p Penalty. Insert a line break if \p NewLine is \c true.
-  void addNextStateToQueue(unsigned Penalty, StateNode *PreviousNode,
-                           bool NewLine, unsigned *Count, QueueType *Queue) {
+  /// Returns \c NULL if the next token cannot be placed that way. Otherwise
+  /// adds the penalty for placing it to \p Penalty.
+  StateNode *createNextState(StateNode *PreviousNode, bool NewLine,
+                             unsigned &Penalty) {
     if (NewLine && !Indenter->canBreak(PreviousNode->State))
-      return;
+      return NULL;
     if (!NewLine && Indenter->mustBreak(PreviousNode->State))
-      return;
+      return NULL;
 
     StateNode *Node = new (Allocator.Allocate())
         StateNode(PreviousNode->State, NewLine, PreviousNode);
     if (!formatChildren(Node->State, NewLine, /*DryRun=*/true, Penalty))
-      return;
+      return NULL;
 
     Penalty += Indenter->addTokenToState(Node->State, NewLine, true);
+    return Node;
+  }
+
+  /// \brief Add the following state to the analysis queue \c Queue.
+  ///
+  /// Assume the current state is \p PreviousNode and has been reached with a
+  /// penalty of \p Penalty. Insert a line break if \p NewLine is \c true.
+  ///
+  /// States already in \p Queued with a penalty that is not higher are not
+  /// added again: the earlier copy is taken from the queue first, which makes
+  /// this one redundant.
+  void addNextStateToQueue(unsigned Penalty, StateNode *PreviousNode,
+                           bool NewLine, unsigned *Count, QueueType *Queue,
+                           PenaltyMap *Queued) {
+    StateNode *Node = createNextState(PreviousNode, NewLine, Penalty);
+    if (!Node)
+      return;
+
+    std::pair<PenaltyMap::iterator, bool> Inserted =
+        Queued->insert(std::make_pair(Node->State, Penalty));
+    if (!Inserted.second) {
+      if (Inserted.first->second <= Penalty)
+        return;
+      Inserted.first->second = Penalty;
+    }
 
     Queue->push(QueueItem(OrderedPenalty(Penalty, *Count), Node));
     ++(*Count);
   }
 
+  /// \brief Places the remaining tokens after \p Node one at a time, taking
+  /// the cheaper of breaking and not breaking before each of them.
+  ///
+  /// Returns the node for the completed line and adds the penalty of the
+  /// added tokens to \p Penalty, or returns \c NULL if the line cannot be
+  /// completed this way.
+  StateNode *completeGreedily(StateNode *Node, unsigned &Penalty) {
+    while (Node->State.NextToken != NULL) {
+      FormatDecision LastFormat = Node->State.NextToken->Decision;
+      unsigned ContinuePenalty = 0;
+      unsigned BreakPenalty = 0;
+      StateNode *Continue = NULL;
+      StateNode *Break = NULL;
+      if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
+        Continue = createNextState(Node, /*NewLine=*/false, ContinuePenalty);
+      if (LastFormat == FD_Unformatted || LastFormat == FD_Break)
+        Break = createNextState(Node, /*NewLine=*/true, BreakPenalty);
+      if (Break && (!Continue || BreakPenalty < ContinuePenalty)) {
+        Node = Break;
+        Penalty += BreakPenalty;
+      } else if (Continue) {
+        Node = Continue;
+        Penalty += ContinuePenalty;
+      } else {
+        return NULL;
+      }
+    }
+    return Node;
+  }
+
   /// \brief If the \p State's next token is an r_brace closing a nested block,
   /// format the nested block before it.
   ///
@@ -1258,8 +1359,10 @@ public:
       Annotator.annotate(*AnnotatedLines[i]);
     }
     deriveLocalStyle(AnnotatedLines);
+    markAffectedLines(AnnotatedLines);
     for (unsigned i = 0, e = AnnotatedLines.size(); i != e; ++i) {
-      Annotator.calculateFormattingInformation(*AnnotatedLines[i]);
+      if (AnnotatedLines[i]->Affected)
+        Annotator.calculateFormattingInformation(*AnnotatedLines[i]);
     }
 
     Annotator.setCommentLineLevels(AnnotatedLines);
@@ -1276,6 +1379,54 @@ private:
     return Text.count('\r') * 2 > Text.count('\n');
   }
 
+  /// \brief Marks the lines that might be reformatted as affected.
+  ///
+  /// These are the lines touching one of the ranges (including the
+  /// whitespace before them), the lines they might move or be joined with,
+  /// and the rest of the preprocessor directives they are part of.  Only
+  /// affected lines get formatting information, which keeps formatting a
+  /// small range of a large file cheap.
+  void markAffectedLines(SmallVectorImpl<AnnotatedLine *> &Lines) {
+    // The LineJoiner merges at most three lines.
+    const unsigned JoinDistance = 3;
+    unsigned MarkedEnd = 0;
+    for (unsigned i = 0, e = Lines.size(); i != e; ++i) {
+      const FormatToken *First = Lines[i]->First;
+      const FormatToken *Last = Lines[i]->Last;
+      CharSourceRange LineRange = CharSourceRange::getCharRange(
+          First->WhitespaceRange.getBegin(),
+          Last->getStartOfNonWhitespace().getLocWithOffset(
+              Last->TokenText.size() - 1));
+      if (!rangesOverlap(SourceMgr, Ranges, LineRange))
+        continue;
+
+      unsigned Begin = i >= JoinDistance ? i - JoinDistance : 0;
+      while (Begin > 0 && Lines[Begin]->InPPDirective &&
+             !Lines[Begin]->First->HasUnescapedNewline)
+        --Begin;
+      Begin = std::max(Begin, MarkedEnd);
+
+      // Lines that start on the same line as a reformatted line are moved
+      // with it.
+      unsigned End = i + 1;
+      while (End != e && (Lines[End]->First->NewlinesBefore == 0 ||
+                          (Lines[End]->InPPDirective &&
+                           !Lines[End]->First->HasUnescapedNewline)))
+        ++End;
+      End = std::min(e, End + JoinDistance);
+
+      for (unsigned j = Begin; j < End; ++j)
+        markAffected(*Lines[j]);
+      MarkedEnd = std::max(MarkedEnd, End);
+    }
+  }
+
+  static void markAffected(AnnotatedLine &Line) {
+    Line.Affected = true;
+    for (unsigned i = 0, e = Line.Children.size(); i != e; ++i)
+      markAffected(*Line.Children[i]);
+  }
+
   void
   deriveLocalStyle(const SmallVectorImpl<AnnotatedLine *> &AnnotatedLines) {
     unsigned CountBoundToVariable = 0;
@@ -1408,6 +1559,25 @@ const char *StyleOptionHelpDescription =
     "  -style=\"{BasedOnStyle: llvm, IndentWidth: 8}\"";
 
 FormatStyle getStyle(StringRef StyleName, StringRef FileName) {
+  return getStyle(StyleName, FileName, NULL);
+}
+
+bool StyleFileCache::lookup(StringRef Directory, FormatStyle *Style) {
+  llvm::sys::ScopedLock L(Lock);
+  llvm::StringMap<FormatStyle>::iterator I = Styles.find(Directory);
+  if (I == Styles.end())
+    return false;
+  *Style = I->getValue();
+  return true;
+}
+
+void StyleFileCache::insert(StringRef Directory, const FormatStyle &Style) {
+  llvm::sys::ScopedLock L(Lock);
+  Styles[Directory] = Style;
+}
+
+FormatStyle getStyle(StringRef StyleName, StringRef FileName,
+                     StyleFileCache *Cache) {
   // Fallback style in case the rest of this function can't determine a style.
   StringRef FallbackStyle = "LLVM";
   FormatStyle Style;
@@ -1431,10 +1601,19 @@ FormatStyle getStyle(StringRef StyleName, StringRef FileName) {
 
   SmallString<128> Path(FileName);
   llvm::sys::fs::make_absolute(Path);
+  // The directories searched so far, which share the style found.
+  SmallVector<StringRef, 8> Searched;
   for (StringRef Directory = Path; !Directory.empty();
        Directory = llvm::sys::path::parent_path(Directory)) {
     if (!llvm::sys::fs::is_directory(Directory))
       continue;
+    if (Cache && Cache->lookup(Directory, &Style)) {
+      DEBUG(llvm::dbgs() << "Using cached style for " << Directory << "\n");
+      for (unsigned i = 0, e = Searched.size(); i != e; ++i)
+        Cache->insert(Searched[i], Style);
+      return Style;
+    }
+    Searched.push_back(Directory);
     SmallString<128> ConfigFile(Directory);
 
     llvm::sys::path::append(ConfigFile, ".clang-format");
@@ -1465,11 +1644,17 @@ FormatStyle getStyle(StringRef StyleName, StringRef FileName) {
         continue;
       }
       DEBUG(llvm::dbgs() << "Using configuration file " << ConfigFile << "\n");
+      if (Cache)
+        for (unsigned i = 0, e = Searched.size(); i != e; ++i)
+          Cache->insert(Searched[i], Style);
       return Style;
     }
   }
   llvm::errs() << "Can't find usable .clang-format, using " << FallbackStyle
                << " style\n";
+  if (Cache)
+    for (unsigned i = 0, e = Searched.size(); i != e; ++i)
+      Cache->insert(Searched[i], Style);
   return Style;
 }
 
@@ -41,7 +41,7 @@ public:
       : First(Line.Tokens.front().Tok), Level(Line.Level),
         InPPDirective(Line.InPPDirective),
         MustBeDeclaration(Line.MustBeDeclaration), MightBeFunctionDecl(false),
-        StartsDefinition(false) {
+        StartsDefinition(false), Affected(false) {
     assert(!Line.Tokens.empty());
 
     // Calculate Next and Previous for all tokens. Note that we must overwrite
@@ -87,6 +87,11 @@ public:
   bool MightBeFunctionDecl;
   bool StartsDefinition;
 
+  /// \brief \c true if this line might be reformatted.
+  ///
+  /// Formatting information is only calculated for affected lines.
+  bool Affected;
+
 private:
   // Disallow copying.
   AnnotatedLine(const AnnotatedLine &) LLVM_DELETED_FUNCTION;
@@ -122,6 +122,10 @@ private:
   FormatToken *FormatTok;
   bool MustBreakBeforeNextToken;
 
+  // The eof token returned at the end of a preprocessor directive. Each parser
+  // has its own, as several files may be formatted concurrently.
+  FormatToken FakeEOF;
+
   // The parsed lines. Only added to through \c CurrentLines.
   SmallVector<UnwrappedLine, 8> Lines;
 
@@ -43,15 +43,19 @@ using namespace clang::io;
 namespace {
 class PTHEntry {
   Offset TokenData, PPCondData;
+  uint64_t ContentHash;
 
 public:
   PTHEntry() {}
 
   PTHEntry(Offset td, Offset ppcd)
-    : TokenData(td), PPCondData(ppcd) {}
+    : TokenData(td), PPCondData(ppcd), ContentHash(0) {}
 
   Offset getTokenOffset() const { return TokenData; }
   Offset getPPCondTableOffset() const { return PPCondData; }
+
+  uint64_t getContentHash() const { return ContentHash; }
+  void setContentHash(uint64_t Hash) { ContentHash = Hash; }
 };
 
 
@@ -101,7 +105,7 @@ public:
   }
 
   unsigned getRepresentationLength() const {
-    return Kind == IsNoExist ? 0 : 4 + 4 + 2 + 8 + 8;
+    return Kind == IsNoExist ? 0 : 8 + 8 + 8 + 8;
   }
 };
 
@@ -124,7 +128,7 @@ public:
     unsigned n = V.getString().size() + 1 + 1;
     ::Emit16(Out, n);
 
-    unsigned m = V.getRepresentationLength() + (V.isFile() ? 4 + 4 : 0);
+    unsigned m = V.getRepresentationLength() + (V.isFile() ? 4 + 4 + 8 : 0);
     ::Emit8(Out, m);
 
     return std::make_pair(n, m);
@@ -142,10 +146,12 @@ public:
 
 
     // For file entries emit the offsets into the PTH file for token data
-    // and the preprocessor blocks table.
+    // and the preprocessor blocks table, and the hash of the contents the
+    // tokens were lexed from.
     if (V.isFile()) {
       ::Emit32(Out, E.getTokenOffset());
       ::Emit32(Out, E.getPPCondTableOffset());
+      ::Emit64(Out, E.getContentHash());
     }
 
     // Emit any other data associated with the key (i.e., stat information).
@@ -483,7 +489,9 @@ void PTHWriter::GeneratePTH(const std::string &MainFile) {
     FileID FID = SM.createFileID(FE, SourceLocation(), SrcMgr::C_User);
     const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
     Lexer L(FID, FromFile, SM, LOpts);
-    PM.insert(FE, LexTokens(L));
+    PTHEntry Entry = LexTokens(L);
+    Entry.setContentHash(PTHManager::getContentHash(FromFile->getBuffer()));
+    PM.insert(FE, Entry);
   }
 
   // Write out the identifier table.
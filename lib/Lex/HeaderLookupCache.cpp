@@ -0,0 +1,97 @@
+//===--- HeaderLookupCache.cpp - Header lookups kept across TUs -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements HeaderLookupCache.
+//
+// The store is a KeyedLineStore with one section for each set of search
+// directories, whose header holds a signature and the hash of the search
+// directories (in hexadecimal).  Each entry holds the index of the result,
+// the time, the index of the start and the name of the header of one lookup.
+//
+//===----------------------------------------------------------------------===//
+
+#include "HeaderLookupCache.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+/// \brief The signature of the store, which changes with its format.
+static const char * const LookupSignature = "CLANG-HEADER-LOOKUPS 3";
+
+/// \brief Returns the key of the lookup of \p Filename from \p StartIdx.
+static void getLookupKey(StringRef Filename, unsigned StartIdx,
+                         SmallVectorImpl<char> &Key) {
+  llvm::raw_svector_ostream(Key) << StartIdx << ' ' << Filename;
+}
+
+/// \brief The number of sets of search directories the store keeps lookups
+/// for.  Every target, configuration and directory of a project may well
+/// have its own.
+static const unsigned MaxSearchDirSets = 64;
+
+HeaderLookupCache::HeaderLookupCache(StringRef Path)
+  : Store(Path, LookupSignature, 2, MaxSearchDirSets),
+    StartTime(llvm::sys::TimeValue::now().toEpochTime()) {}
+
+void HeaderLookupCache::load(uint64_t SearchDirsHash) {
+  SmallString<64> Header;
+  llvm::raw_svector_ostream HeaderOS(Header);
+  HeaderOS << LookupSignature << ' ';
+  HeaderOS.write_hex(SearchDirsHash);
+  Store.setHeader(HeaderOS.str());
+
+  Loaded.clear();
+  Recorded.clear();
+
+  KeyedLineStore::EntryMap Entries;
+  Store.read(Entries);
+  for (KeyedLineStore::EntryMap::iterator I = Entries.begin(),
+                                          E = Entries.end();
+       I != E; ++I) {
+    StringRef Result, Time;
+    llvm::tie(Result, Time) = StringRef(I->getValue()).split(' ');
+    unsigned ResultIdx;
+    uint64_t LookupTime;
+    if (!Result.getAsInteger(10, ResultIdx) &&
+        !Time.getAsInteger(10, LookupTime))
+      Loaded[I->getKey()] = std::make_pair(ResultIdx, LookupTime);
+  }
+}
+
+bool HeaderLookupCache::lookup(StringRef Filename, unsigned StartIdx,
+                               unsigned &ResultIdx,
+                               uint64_t &LookupTime) const {
+  SmallString<128> Key;
+  getLookupKey(Filename, StartIdx, Key);
+  LookupMap::const_iterator I = Loaded.find(Key);
+  if (I == Loaded.end())
+    return false;
+  ResultIdx = I->getValue().first;
+  LookupTime = I->getValue().second;
+  return true;
+}
+
+void HeaderLookupCache::record(StringRef Filename, unsigned StartIdx,
+                               unsigned ResultIdx) {
+  SmallString<128> Key;
+  getLookupKey(Filename, StartIdx, Key);
+  SmallString<32> Result;
+  llvm::raw_svector_ostream(Result) << ResultIdx << ' ' << StartTime;
+  Recorded[Key] = Result.str();
+}
+
+bool HeaderLookupCache::save() {
+  // Lookups made with other search directories are kept in their sections.
+  bool Failed = Store.update(Recorded);
+  Recorded.clear();
+  return Failed;
+}
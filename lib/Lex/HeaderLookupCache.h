@@ -0,0 +1,87 @@
+//===--- HeaderLookupCache.h - Header lookups kept across TUs ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines HeaderLookupCache, which keeps the results of header
+// lookups in a file so that other translation units searching the same
+// directories can skip the directories which do not hold the header.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_HEADERLOOKUPCACHE_H
+#define LLVM_CLANG_LEX_HEADERLOOKUPCACHE_H
+
+#include "clang/Basic/KeyedLineStore.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/DataTypes.h"
+
+namespace clang {
+
+/// \brief A store of the results of header lookups, which persists across
+/// translation units.
+///
+/// A lookup is identified by the name of the header and the index of the
+/// search directory it starts from, and its result is the index of the
+/// search directory which holds the header, along with the time it was made.
+/// The store keeps the lookups of each set of search directories apart, so
+/// translation units searching different directories do not evict each
+/// other's lookups.
+class HeaderLookupCache {
+  /// \brief Maps "<start index> <header name>" to the index of the result
+  /// and the time of the lookup.
+  typedef llvm::StringMap<std::pair<unsigned, uint64_t> > LookupMap;
+
+  /// \brief The file holding the store.
+  KeyedLineStore Store;
+
+  /// \brief The time this translation unit started looking up headers.
+  uint64_t StartTime;
+
+  /// \brief The lookups read from the file.
+  LookupMap Loaded;
+
+  /// \brief The lookups made by this translation unit which the file does not
+  /// hold yet.
+  KeyedLineStore::EntryMap Recorded;
+
+public:
+  /// \brief Uses the store in the file \p Path.
+  explicit HeaderLookupCache(StringRef Path);
+
+  StringRef getPath() const { return Store.getPath(); }
+
+  /// \brief Reads the lookups made with the search directories hashed to
+  /// \p SearchDirsHash, dropping any lookups loaded or recorded before.
+  void load(uint64_t SearchDirsHash);
+
+  /// \brief Looks up the header \p Filename, starting from the search
+  /// directory \p StartIdx.
+  ///
+  /// \returns true if the result is known, in which case it is stored in
+  /// \p ResultIdx, and the time of the lookup, in seconds since the epoch, in
+  /// \p LookupTime.  The search directories before the result which were
+  /// modified since may hold the header too.
+  bool lookup(StringRef Filename, unsigned StartIdx, unsigned &ResultIdx,
+              uint64_t &LookupTime) const;
+
+  /// \brief Records the result of a lookup, to be written by save().  The
+  /// time of the lookup is the time this translation unit started, so that
+  /// the directories it searched count as modified since if they were
+  /// modified while it ran.
+  void record(StringRef Filename, unsigned StartIdx, unsigned ResultIdx);
+
+  /// \brief Merges the recorded lookups into the store.
+  ///
+  /// \returns true if the store could not be written.
+  bool save();
+};
+
+} // end namespace clang
+
+#endif
@@ -18,11 +18,15 @@
 #include "clang/Lex/HeaderMap.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/Lexer.h"
+#include "clang/Lex/Preprocessor.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Capacity.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include "HeaderLookupCache.h"
+#include "IncludeGuardCache.h"
 #include <cstdio>
 #if defined(LLVM_ON_UNIX)
 #include <limits.h>
@@ -58,7 +62,20 @@ HeaderSearch::HeaderSearch(IntrusiveRefCntPtr<HeaderSearchOptions> HSOpts,
   ExternalSource = 0;
   NumIncluded = 0;
   NumMultiIncludeFileOptzn = 0;
+  NumGuardCacheOptzn = 0;
+  NumLookupCacheHits = NumLookupCacheMisses = 0;
   NumFrameworkLookups = NumSubFrameworkLookups = 0;
+
+  if (!HSOpts->IncludeGuardCachePath.empty()) {
+    GuardCache.reset(new IncludeGuardCache(HSOpts->IncludeGuardCachePath));
+    GuardCache->load();
+  }
+
+  // The header lookup cache is loaded on first use, once the search
+  // directories are known.
+  if (!HSOpts->HeaderLookupCachePath.empty())
+    LookupCache.reset(new HeaderLookupCache(HSOpts->HeaderLookupCachePath));
+  LookupCacheLoaded = LookupCacheUsable = false;
 }
 
 HeaderSearch::~HeaderSearch() {
@@ -84,6 +101,13 @@ void HeaderSearch::PrintStats() {
   fprintf(stderr, "  %d #include/#include_next/#import.\n", NumIncluded);
   fprintf(stderr, "    %d #includes skipped due to"
           " the multi-include optimization.\n", NumMultiIncludeFileOptzn);
+  if (GuardCache)
+    fprintf(stderr, "    %d #includes skipped with guards from the include"
+            " guard cache.\n", NumGuardCacheOptzn);
+
+  if (LookupCache)
+    fprintf(stderr, "%d header lookups found in the header lookup cache,"
+            " %d not found.\n", NumLookupCacheHits, NumLookupCacheMisses);
 
   fprintf(stderr, "%d framework lookups.\n", NumFrameworkLookups);
   fprintf(stderr, "%d subframework lookups.\n", NumSubFrameworkLookups);
@@ -605,6 +629,11 @@ const FileEntry *HeaderSearch::LookupFile(
   // If the entry has been previously looked up, the first value will be
   // non-zero.  If the value is equal to i (the start point of our search), then
   // this is a matching hit.
+  unsigned StartIdx = i;
+  HeaderLookupCache *PersistentCache = 0;
+  bool FoundInPersistentCache = false;
+  unsigned CachedIdx = 0;
+  uint64_t CachedTime = 0;
   if (!SkipCache && CacheLookup.first == i+1) {
     // Skip querying potentially lots of directories for this lookup.
     i = CacheLookup.second;
@@ -613,10 +642,38 @@ const FileEntry *HeaderSearch::LookupFile(
     // our search start.  We will fill in our found location below, so prime the
     // start point value.
     CacheLookup.first = i+1;
+
+    // Other translation units may have made the same query with the same
+    // search directories.  A header added to a search directory changes its
+    // modification time, so the directories before the one found which were
+    // modified since are searched again below.  One added to a subdirectory
+    // does not, so only names without path components are persisted.  If the
+    // header has moved since, the search below goes on from the stale
+    // location.
+    if (!SkipCache && !llvm::sys::path::has_parent_path(Filename) &&
+        (PersistentCache = getHeaderLookupCache())) {
+      if (PersistentCache->lookup(Filename, i, CachedIdx, CachedTime) &&
+          CachedIdx >= i && CachedIdx < SearchDirs.size()) {
+        ++NumLookupCacheHits;
+        FoundInPersistentCache = true;
+      } else {
+        ++NumLookupCacheMisses;
+        CachedIdx = i;
+      }
+    }
   }
 
   // Check each directory in sequence to see if it contains this file.
+  bool SearchedAgain = false;
   for (; i != SearchDirs.size(); ++i) {
+    // Skip the directories which did not hold the header when it was
+    // persisted, unless they were modified since.
+    if (i < CachedIdx) {
+      if (SearchDirModTimes[i] < CachedTime)
+        continue;
+      SearchedAgain = true;
+    }
+
     bool InUserSpecifiedSystemFramework = false;
     const FileEntry *FE =
       SearchDirs[i].LookupFile(Filename, *this, SearchPath, RelativePath,
@@ -658,6 +715,9 @@ const FileEntry *HeaderSearch::LookupFile(
     
     // Remember this location for the next lookup we do.
     CacheLookup.second = i;
+    if (PersistentCache &&
+        (!FoundInPersistentCache || SearchedAgain || i != CachedIdx))
+      PersistentCache->record(Filename, StartIdx, i);
     return FE;
   }
 
@@ -685,7 +745,9 @@ const FileEntry *HeaderSearch::LookupFile(
     }
   }
 
-  // Otherwise, didn't find it. Remember we didn't find this.
+  // Otherwise, didn't find it. Remember we didn't find this.  Misses are not
+  // persisted, as the header may well be generated before the next
+  // translation unit looks for it.
   CacheLookup.second = SearchDirs.size();
   return 0;
 }
@@ -902,12 +964,26 @@ void HeaderSearch::MarkFileModuleHeader(const FileEntry *FE,
   HFI.setHeaderRole(Role);
 }
 
-bool HeaderSearch::ShouldEnterIncludeFile(const FileEntry *File, bool isImport){
+bool HeaderSearch::ShouldEnterIncludeFile(Preprocessor &PP,
+                                          const FileEntry *File,
+                                          bool isImport) {
   ++NumIncluded; // Count # of attempted #includes.
 
   // Get information about this file.
   HeaderFileInfo &FileInfo = getFileInfo(File);
 
+  // If this translation unit has not entered the file yet, its guard may have
+  // been found by another one.
+  bool GuardFromCache = false;
+  if (GuardCache && !FileInfo.ControllingMacro &&
+      !FileInfo.ControllingMacroID) {
+    StringRef Macro = GuardCache->lookup(File);
+    if (!Macro.empty()) {
+      FileInfo.ControllingMacro = PP.getIdentifierInfo(Macro);
+      GuardFromCache = true;
+    }
+  }
+
   // If this is a #import directive, check that we have not already imported
   // this header.
   if (isImport) {
@@ -929,6 +1005,8 @@ bool HeaderSearch::ShouldEnterIncludeFile(const FileEntry *File, bool isImport){
       = FileInfo.getControllingMacro(ExternalLookup))
     if (ControllingMacro->hasMacroDefinition()) {
       ++NumMultiIncludeFileOptzn;
+      if (GuardFromCache)
+        ++NumGuardCacheOptzn;
       return false;
     }
 
@@ -938,6 +1016,90 @@ bool HeaderSearch::ShouldEnterIncludeFile(const FileEntry *File, bool isImport){
   return true;
 }
 
+void HeaderSearch::SetFileControllingMacro(
+    const FileEntry *File, const IdentifierInfo *ControllingMacro) {
+  getFileInfo(File).ControllingMacro = ControllingMacro;
+  if (GuardCache)
+    GuardCache->record(File, ControllingMacro->getName());
+}
+
+void HeaderSearch::saveIncludeGuardCache() {
+  // The cache only saves work, so failing to update it is not an error.
+  if (GuardCache)
+    GuardCache->save();
+}
+
+void HeaderSearch::saveHeaderLookupCache() {
+  // Likewise.
+  if (LookupCache && LookupCacheLoaded && LookupCacheUsable)
+    LookupCache->save();
+}
+
+HeaderLookupCache *HeaderSearch::getHeaderLookupCache() {
+  if (!LookupCache)
+    return 0;
+  if (!LookupCacheLoaded) {
+    LookupCacheLoaded = true;
+
+    // Writing the store changes the modification time of its directory, which
+    // would then be searched again by every lookup.
+    StringRef StoreDir =
+      llvm::sys::path::parent_path(LookupCache->getPath());
+    LookupCacheUsable = !isSearchDir(StoreDir.empty() ? "." : StoreDir);
+    if (!LookupCacheUsable)
+      return 0;
+
+    SearchDirModTimes.resize(SearchDirs.size());
+    for (unsigned i = 0, e = SearchDirs.size(); i != e; ++i) {
+      llvm::sys::fs::file_status Status;
+      SearchDirModTimes[i] = 0;
+      if (!llvm::sys::fs::status(SearchDirs[i].getName(), Status))
+        SearchDirModTimes[i] =
+          Status.getLastModificationTime().toEpochTime();
+    }
+    LookupCache->load(hashSearchDirs());
+  }
+  return LookupCacheUsable ? LookupCache.get() : 0;
+}
+
+bool HeaderSearch::isSearchDir(StringRef Dir) const {
+  const DirectoryEntry *Entry = FileMgr.getDirectory(Dir);
+  if (!Entry)
+    return false;
+  for (unsigned i = 0, e = SearchDirs.size(); i != e; ++i)
+    if (SearchDirs[i].isNormalDir() && SearchDirs[i].getDir() == Entry)
+      return true;
+  return false;
+}
+
+uint64_t HeaderSearch::hashSearchDirs() const {
+  SmallString<1024> Description;
+  llvm::raw_svector_ostream OS(Description);
+
+  // Relative search directories depend on the working directory.
+  SmallString<128> WorkingDir;
+  llvm::sys::fs::current_path(WorkingDir);
+  OS << WorkingDir << '\n'
+     << FileMgr.getFileSystemOptions().WorkingDir << '\n'
+     << AngledDirIdx << ' ' << SystemDirIdx << ' ' << NoCurDirSearch << '\n';
+
+  for (unsigned i = 0, e = SearchDirs.size(); i != e; ++i)
+    OS << SearchDirs[i].getLookupType() << ' '
+       << SearchDirs[i].getDirCharacteristic() << ' '
+       << SearchDirs[i].isIndexHeaderMap() << ' ' << SearchDirs[i].getName()
+       << '\n';
+
+  llvm::MD5 Hash;
+  Hash.update(OS.str());
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+
+  uint64_t SearchDirsHash = 0;
+  for (unsigned i = 0; i != 8; ++i)
+    SearchDirsHash |= uint64_t(Result[i]) << (i * 8);
+  return SearchDirsHash;
+}
+
 size_t HeaderSearch::getTotalMemory() const {
   return SearchDirs.capacity()
     + llvm::capacity_in_bytes(FileInfo)
@@ -1163,6 +1325,7 @@ void HeaderSearch::collectAllModules(SmallVectorImpl<Module *> &Modules) {
   }
   
   // Populate the list of modules.
+  ModMap.parseLazyModules();
   for (ModuleMap::module_iterator M = ModMap.module_begin(), 
                                MEnd = ModMap.module_end();
        M != MEnd; ++M) {
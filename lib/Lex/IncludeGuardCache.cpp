@@ -0,0 +1,86 @@
+//===--- IncludeGuardCache.cpp - Include guards kept across TUs -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements IncludeGuardCache.
+//
+// The store is a KeyedLineStore whose section header holds a signature; each
+// entry holds the size, the modification time, the controlling macro and the
+// path of one header.
+//
+//===----------------------------------------------------------------------===//
+
+#include "IncludeGuardCache.h"
+#include "clang/Basic/FileManager.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+/// \brief The signature of the store, which changes with its format.
+static const char * const GuardSignature = "CLANG-INCLUDE-GUARDS 1";
+
+IncludeGuardCache::IncludeGuardCache(StringRef Path)
+  : Store(Path, GuardSignature, 3) {}
+
+void IncludeGuardCache::load() {
+  KeyedLineStore::EntryMap Entries;
+  Store.read(Entries);
+  for (KeyedLineStore::EntryMap::iterator I = Entries.begin(),
+                                          E = Entries.end();
+       I != E; ++I) {
+    StringRef Size, ModTime, Macro;
+    llvm::tie(Size, ModTime) = StringRef(I->getValue()).split(' ');
+    llvm::tie(ModTime, Macro) = ModTime.split(' ');
+
+    Guard G;
+    long long Time;
+    if (Size.getAsInteger(10, G.Size) || ModTime.getAsInteger(10, Time))
+      continue;
+    G.ModTime = (time_t)Time;
+    G.Macro = Macro;
+    Loaded[I->getKey()] = G;
+  }
+}
+
+StringRef IncludeGuardCache::lookup(const FileEntry *File) const {
+  GuardMap::const_iterator I = Loaded.find(File->getName());
+  if (I == Loaded.end())
+    return StringRef();
+
+  const Guard &G = I->getValue();
+  if (G.Size != (uint64_t)File->getSize() ||
+      G.ModTime != File->getModificationTime())
+    return StringRef();
+  return G.Macro;
+}
+
+void IncludeGuardCache::record(const FileEntry *File, StringRef Macro) {
+  // Relative paths mean different files to translation units compiled in
+  // different directories.
+  StringRef Name = File->getName();
+  if (!llvm::sys::path::is_absolute(Name))
+    return;
+
+  // Don't rewrite the store for guards it already holds.
+  if (lookup(File) == Macro)
+    return;
+
+  SmallString<64> Fields;
+  llvm::raw_svector_ostream(Fields) << File->getSize() << ' '
+                                    << (long long)File->getModificationTime()
+                                    << ' ' << Macro;
+  Recorded[Name] = Fields.str();
+}
+
+bool IncludeGuardCache::save() {
+  bool Failed = Store.update(Recorded);
+  Recorded.clear();
+  return Failed;
+}
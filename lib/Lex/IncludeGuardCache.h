@@ -0,0 +1,77 @@
+//===--- IncludeGuardCache.h - Include guards kept across TUs ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines IncludeGuardCache, which keeps the controlling macros of
+// headers in a file so that other translation units can skip the headers
+// without reading them.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_INCLUDEGUARDCACHE_H
+#define LLVM_CLANG_LEX_INCLUDEGUARDCACHE_H
+
+#include "clang/Basic/KeyedLineStore.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/DataTypes.h"
+#include <ctime>
+#include <string>
+
+namespace clang {
+
+class FileEntry;
+
+/// \brief A store of the controlling macros of headers, as found by the
+/// multiple-include optimization, which persists across translation units.
+///
+/// Headers are identified by their absolute paths. Every controlling macro is
+/// recorded along with the size and modification time of the header, so that
+/// it is only used while the header is unchanged.
+class IncludeGuardCache {
+  struct Guard {
+    uint64_t Size;
+    time_t ModTime;
+    std::string Macro;
+  };
+
+  typedef llvm::StringMap<Guard> GuardMap;
+
+  /// \brief The file holding the store.
+  KeyedLineStore Store;
+
+  /// \brief The guards read from the file.
+  GuardMap Loaded;
+
+  /// \brief The guards found by this translation unit which the file does not
+  /// hold yet.
+  KeyedLineStore::EntryMap Recorded;
+
+public:
+  /// \brief Uses the store in the file \p Path.
+  explicit IncludeGuardCache(StringRef Path);
+
+  /// \brief Reads the store.
+  void load();
+
+  /// \brief Returns the controlling macro stored for \p File, or an empty
+  /// string if there is none for its current contents.
+  StringRef lookup(const FileEntry *File) const;
+
+  /// \brief Records the controlling macro of \p File, to be written by save().
+  void record(const FileEntry *File, StringRef Macro);
+
+  /// \brief Merges the recorded guards into the store.
+  ///
+  /// \returns true if the store could not be written.
+  bool save();
+};
+
+} // end namespace clang
+
+#endif
@@ -39,8 +39,109 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "UnicodeCharSets.h"
 #include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+
 using namespace clang;
 
+//===----------------------------------------------------------------------===//
+// Vectorized Scanning
+//===----------------------------------------------------------------------===//
+
+#ifdef __SSE2__
+namespace {
+/// Returns the bytes of \p Chars equal to \p C.
+inline __m128i matchChar(__m128i Chars, char C) {
+  return _mm_cmpeq_epi8(Chars, _mm_set1_epi8(C));
+}
+
+/// Returns the bytes of \p Chars in the ASCII range [\p Lo, \p Hi].  Non-ASCII
+/// bytes compare as negative and are never in the range.
+inline __m128i matchRange(__m128i Chars, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmplt_epi8(Chars, _mm_set1_epi8(Hi + 1)));
+}
+
+/// Matches the characters which end the body of a line comment.
+struct LineCommentEnd {
+  static int match(__m128i Chars) {
+    return _mm_movemask_epi8(
+        _mm_or_si128(_mm_or_si128(matchChar(Chars, '\n'),
+                                  matchChar(Chars, '\r')),
+                     matchChar(Chars, '\0')));
+  }
+};
+
+/// Matches the characters which are not horizontal whitespace.
+struct NonHorizontalWhitespace {
+  static int match(__m128i Chars) {
+    __m128i Whitespace =
+        _mm_or_si128(_mm_or_si128(matchChar(Chars, ' '),
+                                  matchChar(Chars, '\t')),
+                     _mm_or_si128(matchChar(Chars, '\f'),
+                                  matchChar(Chars, '\v')));
+    return ~_mm_movemask_epi8(Whitespace) & 0xFFFF;
+  }
+};
+
+/// Matches the characters which are not [_A-Za-z0-9].
+struct NonIdentifierBody {
+  static int match(__m128i Chars) {
+    // Setting bit 5 maps upper case letters to lower case ones, and leaves
+    // digits unchanged.
+    __m128i Lower = _mm_or_si128(Chars, _mm_set1_epi8(0x20));
+    __m128i Body =
+        _mm_or_si128(_mm_or_si128(matchRange(Lower, 'a', 'z'),
+                                  matchRange(Chars, '0', '9')),
+                     matchChar(Chars, '_'));
+    return ~_mm_movemask_epi8(Body) & 0xFFFF;
+  }
+};
+
+/// Matches the characters of a string literal which getAndAdvanceChar or
+/// LexStringLiteral have to look at: the closing quote, the start of escapes,
+/// escaped newlines and trigraphs, newlines and nul characters.
+struct StringLiteralSpecial {
+  static int match(__m128i Chars) {
+    __m128i Special =
+        _mm_or_si128(_mm_or_si128(matchChar(Chars, '"'),
+                                  matchChar(Chars, '\\')),
+                     _mm_or_si128(matchChar(Chars, '?'),
+                                  matchChar(Chars, '\0')));
+    Special = _mm_or_si128(Special,
+                           _mm_or_si128(matchChar(Chars, '\n'),
+                                        matchChar(Chars, '\r')));
+    return _mm_movemask_epi8(Special);
+  }
+};
+} // end anonymous namespace
+
+/// Scans 16 characters at a time for the first character matched by
+/// \p Matcher, as long as they all come before \p BufferEnd.  Returns the
+/// matched character, or the first of the remaining characters, which have to
+/// be scanned one at a time.
+///
+/// Every matcher matches the nul character, either explicitly or because it
+/// only skips printable characters, so the scan stops at code-completion
+/// points.
+template <typename Matcher>
+static inline const char *findFirstMatch(const char *CurPtr,
+                                         const char *BufferEnd) {
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chars = _mm_loadu_si128((const __m128i *)CurPtr);
+    if (int Mask = Matcher::match(Chars))
+      return CurPtr + llvm::countTrailingZeros<unsigned>(Mask);
+    CurPtr += 16;
+  }
+  return CurPtr;
+}
+#endif
+
 //===----------------------------------------------------------------------===//
 // Token Class Implementation
 //===----------------------------------------------------------------------===//
@@ -1450,6 +1551,9 @@ static void maybeDiagnoseIDCharCompat(DiagnosticsEngine &Diags, uint32_t C,
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+#ifdef __SSE2__
+  CurPtr = findFirstMatch<NonIdentifierBody>(CurPtr, BufferEnd);
+#endif
   unsigned char C = *CurPtr++;
   while (isIdentifierBody(C))
     C = *CurPtr++;
@@ -1712,6 +1816,9 @@ bool Lexer::LexStringLiteral(Token &Result, const char *CurPtr,
            ? diag::warn_cxx98_compat_unicode_literal
            : diag::warn_c99_compat_unicode_literal);
 
+#ifdef __SSE2__
+  CurPtr = findFirstMatch<StringLiteralSpecial>(CurPtr, BufferEnd);
+#endif
   char C = getAndAdvanceChar(CurPtr, Result);
   while (C != '"') {
     // Skip escaped characters.  Escaped newlines will already be processed by
@@ -1737,6 +1844,10 @@ bool Lexer::LexStringLiteral(Token &Result, const char *CurPtr,
 
       NulCharacter = CurPtr-1;
     }
+#ifdef __SSE2__
+    // Skip the characters which getAndAdvanceChar would return unchanged.
+    CurPtr = findFirstMatch<StringLiteralSpecial>(CurPtr, BufferEnd);
+#endif
     C = getAndAdvanceChar(CurPtr, Result);
   }
 
@@ -1946,6 +2057,15 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
 
   // Skip consecutive spaces efficiently.
   while (1) {
+#ifdef __SSE2__
+    // Skip runs of indentation 16 characters at a time.  A single space is
+    // cheaper to skip on its own.
+    if (isHorizontalWhitespace(Char) && isHorizontalWhitespace(CurPtr[1])) {
+      CurPtr = findFirstMatch<NonHorizontalWhitespace>(CurPtr, BufferEnd);
+      Char = *CurPtr;
+    }
+#endif
+
     // Skip horizontal whitespace very aggressively.
     while (isHorizontalWhitespace(Char))
       Char = *++CurPtr;
@@ -2013,6 +2133,9 @@ bool Lexer::SkipLineComment(Token &Result, const char *CurPtr,
   // them.  As such, optimize for this case with the inner loop.
   char C;
   do {
+#ifdef __SSE2__
+    CurPtr = findFirstMatch<LineCommentEnd>(CurPtr, BufferEnd);
+#endif
     C = *CurPtr;
     // Skip over characters in the fast loop.
     while (C != 0 &&                // Potentially EOF.
@@ -2211,13 +2334,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
@@ -61,9 +61,15 @@ MacroArgs *MacroArgs::create(const MacroInfo *MI,
   }
 
   // Copy the actual unexpanded tokens to immediately after the result ptr.
-  if (!UnexpArgTokens.empty())
-    std::copy(UnexpArgTokens.begin(), UnexpArgTokens.end(), 
-              const_cast<Token*>(Result->getUnexpArgument(0)));
+  std::copy(UnexpArgTokens.begin(), UnexpArgTokens.end(),
+            (Token *)(Result+1));
+
+  // Record where each argument starts, so that looking an argument up doesn't
+  // scan all of the arguments before it.
+  Result->ArgStarts.clear();
+  for (unsigned i = 0, e = UnexpArgTokens.size(); i != e; ++i)
+    if (i == 0 || UnexpArgTokens[i-1].is(tok::eof))
+      Result->ArgStarts.push_back(i);
 
   return Result;
 }
@@ -111,18 +117,11 @@ unsigned MacroArgs::getArgLength(const Token *ArgPtr) {
 /// getUnexpArgument - Return the unexpanded tokens for the specified formal.
 ///
 const Token *MacroArgs::getUnexpArgument(unsigned Arg) const {
+  assert(Arg < ArgStarts.size() && "Invalid arg #");
   // The unexpanded argument tokens start immediately after the MacroArgs object
   // in memory.
   const Token *Start = (const Token *)(this+1);
-  const Token *Result = Start;
-  // Scan to find Arg.
-  for (; Arg; ++Result) {
-    assert(Result < Start+NumUnexpArgTokens && "Invalid arg #");
-    if (Result->is(tok::eof))
-      --Arg;
-  }
-  assert(Result < Start+NumUnexpArgTokens && "Invalid arg #");
-  return Result;
+  return Start + ArgStarts[Arg];
 }
 
 
@@ -220,10 +219,14 @@ Token MacroArgs::StringifyArgument(const Token *ArgToks,
         Tok.is(tok::wide_char_constant) ||     // L'x'.
         Tok.is(tok::utf16_char_constant) ||    // u'x'.
         Tok.is(tok::utf32_char_constant)) {    // U'x'.
+      // Escape the spelling in a local buffer rather than in std::strings,
+      // which would allocate for every literal.
+      SmallString<64> Buffer;
       bool Invalid = false;
-      std::string TokStr = PP.getSpelling(Tok, &Invalid);
+      StringRef TokStr = PP.getSpelling(Tok, Buffer, &Invalid);
       if (!Invalid) {
-        std::string Str = Lexer::Stringify(TokStr);
+        SmallString<64> Str(TokStr);
+        Lexer::Stringify(Str);
         Result.append(Str.begin(), Str.end());
       }
     } else if (Tok.is(tok::code_completion)) {
@@ -19,6 +19,7 @@
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/TargetOptions.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/LiteralSupport.h"
@@ -169,6 +170,8 @@ static bool isBuiltinHeader(StringRef FileName) {
 ModuleMap::KnownHeader
 ModuleMap::findModuleForHeader(const FileEntry *File,
                                Module *RequestingModule) {
+  parseLazyModulesForHeader(File);
+
   HeadersMap::iterator Known = Headers.find(File);
   if (Known != Headers.end()) {
     ModuleMap::KnownHeader Result = KnownHeader();
@@ -209,6 +212,7 @@ ModuleMap::findModuleForHeader(const FileEntry *File,
   if (File->getDir() == BuiltinIncludeDir &&
       isBuiltinHeader(llvm::sys::path::filename(File->getName()))) {
     HeaderInfo.loadTopLevelSystemModules();
+    parseLazyModulesForHeader(File);
 
     // Check again.
     if (Headers.find(File) != Headers.end())
@@ -306,6 +310,8 @@ ModuleMap::findModuleForHeader(const FileEntry *File,
 }
 
 bool ModuleMap::isHeaderInUnavailableModule(const FileEntry *Header) const {
+  const_cast<ModuleMap *>(this)->parseLazyModulesForHeader(Header);
+
   HeadersMap::const_iterator Known = Headers.find(Header);
   if (Known != Headers.end()) {
     for (SmallVectorImpl<KnownHeader>::const_iterator
@@ -380,6 +386,8 @@ bool ModuleMap::isHeaderInUnavailableModule(const FileEntry *Header) const {
 }
 
 Module *ModuleMap::findModule(StringRef Name) const {
+  const_cast<ModuleMap *>(this)->parseLazyModules(Name);
+
   llvm::StringMap<Module *>::const_iterator Known = Modules.find(Name);
   if (Known != Modules.end())
     return Known->getValue();
@@ -660,6 +668,8 @@ ModuleMap::getContainingModuleMapFile(Module *Module) const {
 }
 
 void ModuleMap::dump() {
+  parseLazyModules();
+
   llvm::errs() << "Modules:";
   for (llvm::StringMap<Module *>::iterator M = Modules.begin(), 
                                         MEnd = Modules.end(); 
@@ -847,6 +857,18 @@ namespace clang {
 
     /// \brief Whether this module map is in a system header directory.
     bool IsSystem;
+
+    /// \brief Whether top-level module declarations are only indexed, to be
+    /// parsed once they are needed.
+    bool Lazy;
+
+    /// \brief Whether we are skipping over the body of a module declaration
+    /// that is being indexed.
+    bool Indexing;
+
+    /// \brief The location of the first declaration that could not be
+    /// indexed, if any.
+    SourceLocation UnindexedLoc;
     
     /// \brief Whether an error occurred.
     bool HadError;
@@ -871,6 +893,7 @@ namespace clang {
     typedef SmallVector<std::pair<std::string, SourceLocation>, 2> ModuleId;
     bool parseModuleId(ModuleId &Id);
     void parseModuleDecl();
+    bool indexModuleDecl();
     void parseExternModuleDecl();
     void parseRequiresDecl();
     void parseHeaderDecl(clang::MMToken::TokenKind,
@@ -893,16 +916,25 @@ namespace clang {
                              ModuleMap &Map,
                              const DirectoryEntry *Directory,
                              const DirectoryEntry *BuiltinIncludeDir,
-                             bool IsSystem)
+                             bool IsSystem, bool Lazy = false)
       : L(L), SourceMgr(SourceMgr), Target(Target), Diags(Diags), Map(Map), 
         Directory(Directory), BuiltinIncludeDir(BuiltinIncludeDir),
-        IsSystem(IsSystem), HadError(false), ActiveModule(0)
+        IsSystem(IsSystem), Lazy(Lazy), Indexing(false), HadError(false),
+        ActiveModule(0)
     {
       Tok.clear();
       consumeToken();
     }
     
     bool parseModuleMapFile();
+
+    /// \brief Parse the single top-level module declaration at the current
+    /// position.
+    bool parseTopLevelModuleDecl();
+
+    /// \brief Retrieve the location of the first declaration which could not
+    /// be indexed, and from which the file must be parsed eagerly.
+    SourceLocation getUnindexedLoc() const { return UnindexedLoc; }
   };
 }
 
@@ -974,8 +1006,10 @@ retry:
       
   case tok::string_literal: {
     if (LToken.hasUDSuffix()) {
-      Diags.Report(LToken.getLocation(), diag::err_invalid_string_udl);
-      HadError = true;
+      if (!Indexing) {
+        Diags.Report(LToken.getLocation(), diag::err_invalid_string_udl);
+        HadError = true;
+      }
       goto retry;
     }
 
@@ -1002,8 +1036,12 @@ retry:
     goto retry;
       
   default:
-    Diags.Report(LToken.getLocation(), diag::err_mmap_unknown_token);
-    HadError = true;
+    // Problems within the body of an indexed declaration are reported when
+    // the declaration is parsed.
+    if (!Indexing) {
+      Diags.Report(LToken.getLocation(), diag::err_mmap_unknown_token);
+      HadError = true;
+    }
     goto retry;
   }
   
@@ -1347,6 +1385,91 @@ void ModuleMapParser::parseModuleDecl() {
   ActiveModule = PreviousActiveModule;
 }
 
+/// \brief Index a top-level module declaration without parsing it.
+///
+/// The declaration is recorded in the module map under the name of the module
+/// and under the file names of the headers it mentions, so that it can be
+/// parsed once the module or one of those headers is needed.
+///
+/// \returns true if the declaration could not be indexed, in which case the
+/// rest of the file, starting with this declaration, has to be parsed.
+bool ModuleMapParser::indexModuleDecl() {
+  assert(Tok.is(MMToken::ModuleKeyword) || Tok.is(MMToken::FrameworkKeyword));
+  SourceLocation StartLoc = Tok.getLocation();
+
+  bool Framework = false;
+  if (Tok.is(MMToken::FrameworkKeyword)) {
+    consumeToken();
+    Framework = true;
+  }
+  if (!Tok.is(MMToken::ModuleKeyword)) {
+    UnindexedLoc = StartLoc;
+    return true;
+  }
+  consumeToken();
+
+  // An inferred framework module only states which modules may be inferred,
+  // which is cheap to parse.
+  if (Tok.is(MMToken::Star)) {
+    parseInferredModuleDecl(Framework, /*Explicit=*/false);
+    return false;
+  }
+
+  if (!Tok.is(MMToken::Identifier)) {
+    UnindexedLoc = StartLoc;
+    return true;
+  }
+  StringRef Name = Tok.getString();
+  consumeToken();
+
+  // Skip the rest of the module-id and the attributes.
+  skipUntil(MMToken::LBrace);
+  if (!Tok.is(MMToken::LBrace)) {
+    UnindexedLoc = StartLoc;
+    return true;
+  }
+
+  // Skip the body, collecting the file names of the headers.
+  SmallVector<StringRef, 4> HeaderNames;
+  bool HasUmbrella = false;
+  unsigned BraceDepth = 0;
+  Indexing = true;
+  do {
+    switch (Tok.Kind) {
+    case MMToken::EndOfFile:
+      Indexing = false;
+      UnindexedLoc = StartLoc;
+      return true;
+
+    case MMToken::LBrace:
+      ++BraceDepth;
+      break;
+
+    case MMToken::RBrace:
+      --BraceDepth;
+      break;
+
+    case MMToken::StringLiteral:
+      HeaderNames.push_back(llvm::sys::path::filename(Tok.getString()));
+      break;
+
+    case MMToken::UmbrellaKeyword:
+      HasUmbrella = true;
+      break;
+
+    default:
+      break;
+    }
+    consumeToken();
+  } while (BraceDepth != 0);
+  Indexing = false;
+
+  Map.addLazyModuleDecl(Name, SourceMgr.getFileID(StartLoc), Directory,
+                        SourceMgr.getFileOffset(StartLoc), IsSystem,
+                        HeaderNames, HasUmbrella);
+  return false;
+}
+
 /// \brief Parse an extern module declaration.
 ///
 ///   extern module-declaration:
@@ -2082,10 +2205,18 @@ bool ModuleMapParser::parseModuleMapFile() {
     case MMToken::EndOfFile:
       return HadError;
       
-    case MMToken::ExplicitKeyword:
-    case MMToken::ExternKeyword:
     case MMToken::ModuleKeyword:
     case MMToken::FrameworkKeyword:
+      if (Lazy) {
+        if (indexModuleDecl())
+          return HadError;
+        break;
+      }
+      parseModuleDecl();
+      break;
+
+    case MMToken::ExplicitKeyword:
+    case MMToken::ExternKeyword:
       parseModuleDecl();
       break;
 
@@ -2117,6 +2248,12 @@ bool ModuleMapParser::parseModuleMapFile() {
   } while (true);
 }
 
+bool ModuleMapParser::parseTopLevelModuleDecl() {
+  assert(Tok.is(MMToken::ModuleKeyword) || Tok.is(MMToken::FrameworkKeyword));
+  parseModuleDecl();
+  return HadError;
+}
+
 bool ModuleMap::parseModuleMapFile(const FileEntry *File, bool IsSystem) {
   llvm::DenseMap<const FileEntry *, bool>::iterator Known
     = ParsedModuleMap.find(File);
@@ -2129,13 +2266,126 @@ bool ModuleMap::parseModuleMapFile(const FileEntry *File, bool IsSystem) {
   if (!Buffer)
     return ParsedModuleMap[File] = true;
   
-  // Parse this module map file.
+  // Parse this module map file, or only index its module declarations.
+  bool Lazy = HeaderInfo.getHeaderSearchOpts().LazyModuleMaps;
   Lexer L(ID, SourceMgr.getBuffer(ID), SourceMgr, MMapLangOpts);
   Diags->getClient()->BeginSourceFile(MMapLangOpts);
   ModuleMapParser Parser(L, SourceMgr, Target, *Diags, *this, File->getDir(),
-                         BuiltinIncludeDir, IsSystem);
+                         BuiltinIncludeDir, IsSystem, Lazy);
   bool Result = Parser.parseModuleMapFile();
+
+  // Parse the rest of the file if some declaration could not be indexed, so
+  // that its problems are reported as usual.
+  SourceLocation UnindexedLoc = Parser.getUnindexedLoc();
+  if (UnindexedLoc.isValid()) {
+    unsigned Offset = SourceMgr.getFileOffset(UnindexedLoc);
+    Lexer RestL(SourceMgr.getLocForStartOfFile(ID), MMapLangOpts,
+                Buffer->getBufferStart(), Buffer->getBufferStart() + Offset,
+                Buffer->getBufferEnd());
+    ModuleMapParser RestParser(RestL, SourceMgr, Target, *Diags, *this,
+                               File->getDir(), BuiltinIncludeDir, IsSystem);
+    if (RestParser.parseModuleMapFile())
+      Result = true;
+  }
   Diags->getClient()->EndSourceFile();
   ParsedModuleMap[File] = Result;
   return Result;
 }
+
+void ModuleMap::addLazyModuleDecl(StringRef Name, FileID ID,
+                                  const DirectoryEntry *Dir, unsigned Offset,
+                                  bool IsSystem,
+                                  ArrayRef<StringRef> HeaderNames,
+                                  bool HasUmbrella) {
+  unsigned Index = LazyDecls.size();
+  LazyModuleDecl Decl = { ID, Dir, Offset, IsSystem, false };
+  LazyDecls.push_back(Decl);
+
+  LazyDeclsByName[Name].push_back(Index);
+  for (unsigned I = 0, N = HeaderNames.size(); I != N; ++I) {
+    SmallVectorImpl<unsigned> &Decls = LazyDeclsByHeader[HeaderNames[I]];
+    if (Decls.empty() || Decls.back() != Index)
+      Decls.push_back(Index);
+  }
+  if (HasUmbrella)
+    LazyUmbrellaDecls.push_back(Index);
+}
+
+void ModuleMap::parseLazyModuleDecl(unsigned Index) {
+  if (LazyDecls[Index].Parsed)
+    return;
+  LazyDecls[Index].Parsed = true;
+
+  // Parsing may index more declarations, so don't keep a reference into
+  // LazyDecls.
+  LazyModuleDecl Decl = LazyDecls[Index];
+  const llvm::MemoryBuffer *Buffer = SourceMgr.getBuffer(Decl.ID);
+  Lexer L(SourceMgr.getLocForStartOfFile(Decl.ID), MMapLangOpts,
+          Buffer->getBufferStart(), Buffer->getBufferStart() + Decl.Offset,
+          Buffer->getBufferEnd());
+  Diags->getClient()->BeginSourceFile(MMapLangOpts);
+  ModuleMapParser Parser(L, SourceMgr, Target, *Diags, *this, Decl.Dir,
+                         BuiltinIncludeDir, Decl.IsSystem);
+  Parser.parseTopLevelModuleDecl();
+  Diags->getClient()->EndSourceFile();
+}
+
+void ModuleMap::parseLazyModules(StringRef Name) {
+  llvm::StringMap<SmallVector<unsigned, 1> >::iterator Known
+    = LazyDeclsByName.find(Name);
+  if (Known == LazyDeclsByName.end())
+    return;
+
+  // Remove the entry first: parsing the declarations looks the module up.
+  SmallVector<unsigned, 1> Decls = Known->getValue();
+  LazyDeclsByName.erase(Known);
+  for (unsigned I = 0, N = Decls.size(); I != N; ++I)
+    parseLazyModuleDecl(Decls[I]);
+}
+
+/// \brief Determine whether the directory \p Dir is \p Parent or one of its
+/// subdirectories.
+static bool isWithinDirectory(StringRef Dir, StringRef Parent) {
+  if (!Dir.startswith(Parent))
+    return false;
+  return Dir.size() == Parent.size() ||
+         llvm::sys::path::is_separator(Dir[Parent.size()]);
+}
+
+void ModuleMap::parseLazyModulesForHeader(const FileEntry *File) {
+  llvm::StringMap<SmallVector<unsigned, 1> >::iterator Known
+    = LazyDeclsByHeader.find(llvm::sys::path::filename(File->getName()));
+  if (Known != LazyDeclsByHeader.end()) {
+    SmallVector<unsigned, 1> Decls = Known->getValue();
+    LazyDeclsByHeader.erase(Known);
+    for (unsigned I = 0, N = Decls.size(); I != N; ++I)
+      parseLazyModuleDecl(Decls[I]);
+  }
+
+  // A module with an umbrella header or directory may own any header below
+  // the directory of its module map.
+  if (LazyUmbrellaDecls.empty())
+    return;
+  FileManager &FileMgr = SourceMgr.getFileManager();
+  StringRef HeaderDir = FileMgr.getCanonicalName(File->getDir());
+  for (unsigned I = 0; I != LazyUmbrellaDecls.size(); /* in loop */) {
+    unsigned Index = LazyUmbrellaDecls[I];
+    if (!LazyDecls[Index].Parsed &&
+        !isWithinDirectory(HeaderDir,
+                           FileMgr.getCanonicalName(LazyDecls[Index].Dir))) {
+      ++I;
+      continue;
+    }
+    LazyUmbrellaDecls.erase(LazyUmbrellaDecls.begin() + I);
+    parseLazyModuleDecl(Index);
+  }
+}
+
+void ModuleMap::parseLazyModules() {
+  // Parsing may index more declarations, which are parsed as well.
+  for (unsigned I = 0; I != LazyDecls.size(); ++I)
+    parseLazyModuleDecl(I);
+  LazyDeclsByName.clear();
+  LazyDeclsByHeader.clear();
+  LazyUmbrellaDecls.clear();
+}
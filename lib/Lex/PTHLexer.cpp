@@ -24,7 +24,9 @@
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
 using namespace clang;
 using namespace clang::io;
@@ -298,12 +300,20 @@ namespace {
 class PTHFileData {
   const uint32_t TokenOff;
   const uint32_t PPCondOff;
+  const uint64_t ContentHash;
+  const uint64_t Size;
+  const time_t ModTime;
 public:
-  PTHFileData(uint32_t tokenOff, uint32_t ppCondOff)
-    : TokenOff(tokenOff), PPCondOff(ppCondOff) {}
+  PTHFileData(uint32_t tokenOff, uint32_t ppCondOff, uint64_t contentHash,
+              uint64_t size, time_t modTime)
+    : TokenOff(tokenOff), PPCondOff(ppCondOff), ContentHash(contentHash),
+      Size(size), ModTime(modTime) {}
 
   uint32_t getTokenOffset() const { return TokenOff; }
   uint32_t getPPCondOffset() const { return PPCondOff; }
+  uint64_t getContentHash() const { return ContentHash; }
+  uint64_t getSize() const { return Size; }
+  time_t getModificationTime() const { return ModTime; }
 };
 
 
@@ -346,7 +356,11 @@ public:
     assert(k.first == 0x1 && "Only file lookups can match!");
     uint32_t x = ::ReadUnalignedLE32(d);
     uint32_t y = ::ReadUnalignedLE32(d);
-    return PTHFileData(x, y);
+    uint64_t h = ::ReadUnalignedLE64(d);
+    d += 8 * 2; // Skip the unique ID.
+    time_t ModTime = ::ReadUnalignedLE64(d);
+    uint64_t Size = ::ReadUnalignedLE64(d);
+    return PTHFileData(x, y, h, Size, ModTime);
   }
 };
 
@@ -409,7 +423,8 @@ PTHManager::PTHManager(const llvm::MemoryBuffer* buf, void* fileLookup,
 : Buf(buf), PerIDCache(perIDCache), FileLookup(fileLookup),
   IdDataTable(idDataTable), StringIdLookup(stringIdLookup),
   NumIds(numIds), PP(0), SpellingBase(spellingBase),
-  OriginalSourceFile(originalSourceFile) {}
+  OriginalSourceFile(originalSourceFile), NumCachedFiles(0),
+  NumStaleFiles(0) {}
 
 PTHManager::~PTHManager() {
   delete Buf;
@@ -590,6 +605,23 @@ PTHLexer *PTHManager::CreateLexer(FileID FID) {
 
   const PTHFileData& FileData = *I;
 
+  // The file may have been modified since the PTH file was generated, in
+  // which case its tokens have to be lexed from source again.  The stat cache
+  // gives the current size and modification time of files, so only hash the
+  // contents of those which were touched.
+  if (FE->getSize() != (off_t)FileData.getSize() ||
+      FE->getModificationTime() != FileData.getModificationTime()) {
+    bool Invalid = false;
+    const llvm::MemoryBuffer *Contents =
+      PP->getSourceManager().getBuffer(FID, &Invalid);
+    if (Invalid || getContentHash(Contents->getBuffer()) !=
+                       FileData.getContentHash()) {
+      ++NumStaleFiles;
+      return 0;
+    }
+  }
+  ++NumCachedFiles;
+
   const unsigned char *BufStart = (const unsigned char *)Buf->getBufferStart();
   // Compute the offset of the token data within the buffer.
   const unsigned char* data = BufStart + FileData.getTokenOffset();
@@ -647,7 +679,7 @@ public:
       bool IsDirectory = true;
       if (k.first == 0x1 /* File */) {
         IsDirectory = false;
-        d += 4 * 2; // Skip the first 2 words.
+        d += 4 * 2 + 8; // Skip the token offsets and the content hash.
       }
 
       uint64_t File = ReadUnalignedLE64(d);
@@ -688,6 +720,15 @@ public:
     if (!D.HasData)
       return CacheMissing;
 
+    // Files may have been modified since the PTH file was generated, and
+    // their contents are read with the size given here, so they have to be
+    // stat'ed for real.  Their tokens are only replayed if they are unchanged.
+    if (!D.IsDirectory) {
+      LookupResult Result = statChained(Path, Data, isFile, FileDescriptor);
+      Data.InPCH = Result == CacheExists;
+      return Result;
+    }
+
     Data.Size = D.Size;
     Data.ModTime = D.ModTime;
     Data.UniqueID = D.UniqueID;
@@ -703,3 +744,21 @@ public:
 FileSystemStatCache *PTHManager::createStatCache() {
   return new PTHStatCache(*((PTHFileLookup*) FileLookup));
 }
+
+uint64_t PTHManager::getContentHash(StringRef Contents) {
+  llvm::MD5 Hash;
+  Hash.update(Contents);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+
+  uint64_t ContentHash = 0;
+  for (unsigned i = 0; i != 8; ++i)
+    ContentHash |= uint64_t(Result[i]) << (i * 8);
+  return ContentHash;
+}
+
+void PTHManager::PrintStats() const {
+  llvm::errs() << "\n*** PTH Stats:\n";
+  llvm::errs() << NumCachedFiles << " files read from the token cache, "
+               << NumStaleFiles << " stale files lexed from source.\n";
+}
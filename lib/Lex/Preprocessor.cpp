@@ -248,6 +248,9 @@ void Preprocessor::PrintStats() {
              << " token paste (##) operations performed, "
              << NumFastTokenPaste << " on the fast path.\n";
 
+  if (PTH)
+    PTH->PrintStats();
+
   llvm::errs() << "\nPreprocessor Memory: " << getTotalMemory() << "B total";
 
   llvm::errs() << "\n  BumpPtr: " << BP.getTotalMemory();
@@ -497,6 +500,9 @@ void Preprocessor::EndSourceFile() {
   // Notify the client that we reached the end of the source file.
   if (Callbacks)
     Callbacks->EndOfMainFile();
+
+  HeaderInfo.saveIncludeGuardCache();
+  HeaderInfo.saveHeaderLookupCache();
 }
 
 //===----------------------------------------------------------------------===//
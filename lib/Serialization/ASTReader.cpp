@@ -604,7 +604,7 @@ IdentifierInfo *ASTIdentifierLookupTrait::ReadData(const internal_key_type& k,
 }
 
 unsigned 
-ASTDeclContextNameLookupTrait::ComputeHash(const DeclNameKey &Key) const {
+ASTDeclContextNameLookupTrait::ComputeHash(const DeclNameKey &Key) {
   llvm::FoldingSetNodeID ID;
   ID.AddInteger(Key.Kind);
 
@@ -633,7 +633,7 @@ ASTDeclContextNameLookupTrait::ComputeHash(const DeclNameKey &Key) const {
 
 ASTDeclContextNameLookupTrait::internal_key_type 
 ASTDeclContextNameLookupTrait::GetInternalKey(
-                                          const external_key_type& Name) const {
+                                          const external_key_type& Name) {
   DeclNameKey Key;
   Key.Kind = Name.getNameKind();
   switch (Name.getNameKind()) {
@@ -5817,7 +5817,20 @@ ASTReader::FindExternalVisibleDeclsByName(const DeclContext *DC,
       (Definitive = getDefinitiveModuleFileFor(DC, *this))) {
     DeclContextNameLookupVisitor::visit(*Definitive, &Visitor);
   } else {
-    ModuleMgr.visit(&DeclContextNameLookupVisitor::visit, &Visitor);
+    // If there is a global index, look there first to determine which modules
+    // provably do not have any declarations with this name.
+    GlobalModuleIndex::HitSet Hits;
+    GlobalModuleIndex::HitSet *HitsPtr = 0;
+    if (!loadGlobalIndex()) {
+      if (GlobalIndex->lookupDeclName(Name, Hits)) {
+        HitsPtr = &Hits;
+        // Modules the index does not know about are still visited.
+        NumDeclNameLookupFilesSkipped +=
+            ModuleMgr.getNumModulesInCommonWithGlobalIndex() - Hits.size();
+      }
+    }
+
+    ModuleMgr.visit(&DeclContextNameLookupVisitor::visit, &Visitor, HitsPtr);
   }
   ++NumVisibleDeclContextsRead;
   SetExternalVisibleDeclsForName(DC, Name, Decls);
@@ -6028,6 +6041,9 @@ void ASTReader::PrintStats() {
                  NumVisibleDeclContextsRead, TotalVisibleDeclContexts,
                  ((float)NumVisibleDeclContextsRead/TotalVisibleDeclContexts
                   * 100));
+  if (NumDeclNameLookupFilesSkipped)
+    std::fprintf(stderr, "  %u module files skipped by declaration name "
+                 "lookups\n", NumDeclNameLookupFilesSkipped);
   if (TotalNumMethodPoolEntries) {
     std::fprintf(stderr, "  %u/%u method pool entries read (%f%%)\n",
                  NumMethodPoolEntriesRead, TotalNumMethodPoolEntries,
@@ -6335,7 +6351,18 @@ void ASTReader::ReadMethodPool(Selector Sel) {
   // Search for methods defined with this selector.
   ++NumMethodPoolLookups;
   ReadMethodPoolVisitor Visitor(*this, Sel, PriorGeneration);
-  ModuleMgr.visit(&ReadMethodPoolVisitor::visit, &Visitor);
+
+  // If there is a global index, look there first to determine which modules
+  // provably do not have any methods with this selector.
+  GlobalModuleIndex::HitSet Hits;
+  GlobalModuleIndex::HitSet *HitsPtr = 0;
+  if (!loadGlobalIndex()) {
+    if (GlobalIndex->lookupSelector(Sel, Hits)) {
+      HitsPtr = &Hits;
+    }
+  }
+
+  ModuleMgr.visit(&ReadMethodPoolVisitor::visit, &Visitor, HitsPtr);
   
   if (Visitor.getInstanceMethods().empty() &&
       Visitor.getFactoryMethods().empty())
@@ -7605,7 +7632,8 @@ ASTReader::ASTReader(Preprocessor &PP, ASTContext &Context,
     TotalNumMethodPoolEntries(0),
     NumLexicalDeclContextsRead(0), TotalLexicalDeclContexts(0), 
     NumVisibleDeclContextsRead(0), TotalVisibleDeclContexts(0),
-    TotalModulesSizeInBits(0), NumCurrentElementsDeserializing(0),
+    NumDeclNameLookupFilesSkipped(0), TotalModulesSizeInBits(0),
+    NumCurrentElementsDeserializing(0),
     PassingDeclsToConsumer(false),
     NumCXXBaseSpecifiersLoaded(0), ReadingKind(Read_None)
 {
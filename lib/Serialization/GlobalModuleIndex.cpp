@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ASTCommon.h"
 #include "ASTReaderInternals.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/OnDiskHashTable.h"
@@ -28,6 +29,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include <cstdio>
+#include <map>
 using namespace clang;
 using namespace serialization;
 
@@ -48,7 +50,13 @@ namespace {
     /// \brief Describes a module, including its file name and dependencies.
     MODULE,
     /// \brief The index for identifiers.
-    IDENTIFIER_INDEX
+    IDENTIFIER_INDEX,
+    /// \brief The index for selectors in the global method pools, keyed by
+    /// selector hash.
+    SELECTOR_INDEX,
+    /// \brief The index for the names in declaration context lookup tables,
+    /// keyed by name hash.
+    DECL_NAME_INDEX
   };
 }
 
@@ -56,7 +64,7 @@ namespace {
 static const char * const IndexFileName = "modules.idx";
 
 /// \brief The global index file version.
-static const unsigned CurrentVersion = 1;
+static const unsigned CurrentVersion = 2;
 
 //----------------------------------------------------------------------------//
 // Global module index reader.
@@ -116,12 +124,68 @@ public:
 
 typedef OnDiskChainedHashTable<IdentifierIndexReaderTrait> IdentifierIndexTable;
 
+/// \brief Trait used to read the selector and declaration name indexes, which
+/// map the hash of a key to the module files with entries for that key, from
+/// the on-disk hash table.
+class HashIndexReaderTrait {
+public:
+  typedef unsigned external_key_type;
+  typedef unsigned internal_key_type;
+  typedef SmallVector<unsigned, 2> data_type;
+
+  static bool EqualKey(const internal_key_type& a, const internal_key_type& b) {
+    return a == b;
+  }
+
+  static unsigned ComputeHash(const internal_key_type& a) {
+    return a;
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char*& d) {
+    using namespace clang::io;
+    unsigned KeyLen = ReadUnalignedLE16(d);
+    unsigned DataLen = ReadUnalignedLE16(d);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static const internal_key_type&
+  GetInternalKey(const external_key_type& x) { return x; }
+
+  static const external_key_type&
+  GetExternalKey(const internal_key_type& x) { return x; }
+
+  static internal_key_type ReadKey(const unsigned char* d, unsigned n) {
+    using namespace clang::io;
+    return ReadUnalignedLE32(d);
+  }
+
+  static data_type ReadData(const internal_key_type& k,
+                            const unsigned char* d,
+                            unsigned DataLen) {
+    using namespace clang::io;
+
+    data_type Result;
+    while (DataLen > 0) {
+      unsigned ID = ReadUnalignedLE32(d);
+      Result.push_back(ID);
+      DataLen -= 4;
+    }
+
+    return Result;
+  }
+};
+
+typedef OnDiskChainedHashTable<HashIndexReaderTrait> HashIndexTable;
+
 }
 
 GlobalModuleIndex::GlobalModuleIndex(llvm::MemoryBuffer *Buffer,
                                      llvm::BitstreamCursor Cursor)
-  : Buffer(Buffer), IdentifierIndex(),
-    NumIdentifierLookups(), NumIdentifierLookupHits()
+  : Buffer(Buffer), IdentifierIndex(), SelectorIndex(), DeclNameIndex(),
+    NumIdentifierLookups(), NumIdentifierLookupHits(),
+    NumSelectorLookups(), NumSelectorLookupHits(),
+    NumDeclNameLookups(), NumDeclNameLookupHits()
 {
   // Read the global index.
   bool InGlobalIndexBlock = false;
@@ -215,11 +279,35 @@ GlobalModuleIndex::GlobalModuleIndex(llvm::MemoryBuffer *Buffer,
                             IdentifierIndexReaderTrait());
       }
       break;
+
+    case SELECTOR_INDEX:
+      // Wire up the selector index.
+      if (Record[0]) {
+        SelectorIndex = HashIndexTable::Create(
+                          (const unsigned char *)Blob.data() + Record[0],
+                          (const unsigned char *)Blob.data(),
+                          HashIndexReaderTrait());
+      }
+      break;
+
+    case DECL_NAME_INDEX:
+      // Wire up the declaration name index.
+      if (Record[0]) {
+        DeclNameIndex = HashIndexTable::Create(
+                          (const unsigned char *)Blob.data() + Record[0],
+                          (const unsigned char *)Blob.data(),
+                          HashIndexReaderTrait());
+      }
+      break;
     }
   }
 }
 
-GlobalModuleIndex::~GlobalModuleIndex() { }
+GlobalModuleIndex::~GlobalModuleIndex() {
+  delete static_cast<IdentifierIndexTable *>(IdentifierIndex);
+  delete static_cast<HashIndexTable *>(SelectorIndex);
+  delete static_cast<HashIndexTable *>(DeclNameIndex);
+}
 
 std::pair<GlobalModuleIndex *, GlobalModuleIndex::ErrorCode>
 GlobalModuleIndex::readIndex(StringRef Path) {
@@ -304,6 +392,48 @@ bool GlobalModuleIndex::lookupIdentifier(StringRef Name, HitSet &Hits) {
   return true;
 }
 
+bool GlobalModuleIndex::lookupHash(void *Index, unsigned Hash, HitSet &Hits) {
+  HashIndexTable &Table = *static_cast<HashIndexTable *>(Index);
+  HashIndexTable::iterator Known = Table.find(Hash);
+  if (Known == Table.end())
+    return false;
+
+  SmallVector<unsigned, 2> ModuleIDs = *Known;
+  for (unsigned I = 0, N = ModuleIDs.size(); I != N; ++I) {
+    if (ModuleFile *MF = Modules[ModuleIDs[I]].File)
+      Hits.insert(MF);
+  }
+  return true;
+}
+
+bool GlobalModuleIndex::lookupSelector(Selector Sel, HitSet &Hits) {
+  Hits.clear();
+
+  // If there's no selector index, there is nothing we can do.
+  if (!SelectorIndex)
+    return false;
+
+  ++NumSelectorLookups;
+  if (lookupHash(SelectorIndex, serialization::ComputeHash(Sel), Hits))
+    ++NumSelectorLookupHits;
+  return true;
+}
+
+bool GlobalModuleIndex::lookupDeclName(DeclarationName Name, HitSet &Hits) {
+  Hits.clear();
+
+  // If there's no declaration name index, there is nothing we can do.
+  if (!DeclNameIndex)
+    return false;
+
+  typedef reader::ASTDeclContextNameLookupTrait Trait;
+  ++NumDeclNameLookups;
+  if (lookupHash(DeclNameIndex,
+                 Trait::ComputeHash(Trait::GetInternalKey(Name)), Hits))
+    ++NumDeclNameLookupHits;
+  return true;
+}
+
 bool GlobalModuleIndex::loadedModuleFile(ModuleFile *File) {
   // Look for the module in the global module index based on the module name.
   StringRef Name = llvm::sys::path::stem(File->FileName);
@@ -338,6 +468,16 @@ void GlobalModuleIndex::printStats() {
             NumIdentifierLookupHits, NumIdentifierLookups,
             (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
   }
+  if (NumSelectorLookups) {
+    fprintf(stderr, "  %u / %u selector lookups succeeded (%f%%)\n",
+            NumSelectorLookupHits, NumSelectorLookups,
+            (double)NumSelectorLookupHits*100.0/NumSelectorLookups);
+  }
+  if (NumDeclNameLookups) {
+    fprintf(stderr, "  %u / %u declaration name lookups succeeded (%f%%)\n",
+            NumDeclNameLookupHits, NumDeclNameLookups,
+            (double)NumDeclNameLookupHits*100.0/NumDeclNameLookups);
+  }
   std::fprintf(stderr, "\n");
 }
 
@@ -373,7 +513,24 @@ namespace {
     /// \brief A mapping from all interesting identifiers to the set of module
     /// files in which those identifiers are considered interesting.
     InterestingIdentifierMap InterestingIdentifiers;
-    
+
+    /// \brief Mapping from key hashes to the list of module file IDs with
+    /// entries for a key with that hash.
+    typedef std::map<unsigned, SmallVector<unsigned, 2> > HashIndexMap;
+
+    /// \brief The hashes of the selectors in each module file's global
+    /// method pool.
+    HashIndexMap SelectorHashes;
+
+    /// \brief The hashes of the names in each module file's declaration
+    /// context lookup tables.
+    HashIndexMap DeclNameHashes;
+
+    /// \brief Record that module file \p ID has entries for every key whose
+    /// hash is stored in the given on-disk hash table.
+    void addHashes(HashIndexMap &Index, unsigned ID, StringRef Blob,
+                   uint32_t BucketOffset);
+
     /// \brief Write the block-info block for the global module index file.
     void emitBlockInfoBlock(llvm::BitstreamWriter &Stream);
 
@@ -439,6 +596,8 @@ GlobalModuleIndexBuilder::emitBlockInfoBlock(llvm::BitstreamWriter &Stream) {
   RECORD(INDEX_METADATA);
   RECORD(MODULE);
   RECORD(IDENTIFIER_INDEX);
+  RECORD(SELECTOR_INDEX);
+  RECORD(DECL_NAME_INDEX);
 #undef RECORD
 #undef BLOCK
 
@@ -466,6 +625,41 @@ namespace {
   };
 }
 
+void GlobalModuleIndexBuilder::addHashes(HashIndexMap &Index, unsigned ID,
+                                         StringRef Blob,
+                                         uint32_t BucketOffset) {
+  using namespace clang::io;
+
+  // Walk the items of the table directly rather than through an
+  // OnDiskChainedHashTable: the hash of each key is stored next to it, so we
+  // never need to decode the keys themselves, which refer to identifiers by
+  // module-local ID. The method pool and the declaration context lookup
+  // tables both store 16-bit key and data lengths.
+  const unsigned char *Base = (const unsigned char *)Blob.data();
+  const unsigned char *Table = Base + BucketOffset;
+  ReadUnalignedLE32(Table); // Skip the number of buckets.
+  unsigned NumEntries = ReadUnalignedLE32(Table);
+
+  // The first bucket starts after the padding at offset 0.
+  const unsigned char *Items = Base + 4;
+  unsigned NumItemsInBucketLeft = 0;
+  for (; NumEntries; --NumEntries) {
+    if (!NumItemsInBucketLeft)
+      NumItemsInBucketLeft = ReadUnalignedLE16(Items);
+    unsigned Hash = ReadUnalignedLE32(Items);
+    unsigned KeyLen = ReadUnalignedLE16(Items);
+    unsigned DataLen = ReadUnalignedLE16(Items);
+    Items += KeyLen + DataLen;
+    --NumItemsInBucketLeft;
+
+    // Module files are loaded one at a time, so this module file can only
+    // be at the end of the list.
+    SmallVector<unsigned, 2> &IDs = Index[Hash];
+    if (IDs.empty() || IDs.back() != ID)
+      IDs.push_back(ID);
+  }
+}
+
 bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
   // Open the module file.
   OwningPtr<llvm::MemoryBuffer> Buffer;
@@ -495,7 +689,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
   unsigned ID = getModuleFileInfo(File).ID;
 
   // Search for the blocks and records we care about.
-  enum { Other, ControlBlock, ASTBlock } State = Other;
+  enum { Other, ControlBlock, ASTBlock, DeclTypesBlock } State = Other;
   bool Done = false;
   while (!Done) {
     llvm::BitstreamEntry Entry = InStream.advance();
@@ -533,13 +727,23 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
         continue;
       }
 
+      // The lookup tables of the declaration contexts defined in this module
+      // file live among its declarations.
+      if (State == ASTBlock && Entry.ID == DECLTYPES_BLOCK_ID) {
+        if (InStream.EnterSubBlock(DECLTYPES_BLOCK_ID))
+          return true;
+
+        State = DeclTypesBlock;
+        continue;
+      }
+
       if (InStream.SkipBlock())
         return true;
 
       continue;
 
     case llvm::BitstreamEntry::EndBlock:
-      State = Other;
+      State = State == DeclTypesBlock ? ASTBlock : Other;
       continue;
     }
 
@@ -607,6 +811,24 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
       }
     }
 
+    // Handle the global method pool.
+    if (State == ASTBlock && Code == METHOD_POOL && Record[0] > 0) {
+      addHashes(SelectorHashes, ID, Blob, Record[0]);
+      continue;
+    }
+
+    // Handle the lookup tables of declaration contexts, and the additions to
+    // the lookup tables of declaration contexts from other module files.
+    if (State == DeclTypesBlock && Code == DECL_CONTEXT_VISIBLE &&
+        !Blob.empty() && Record[0] > 0) {
+      addHashes(DeclNameHashes, ID, Blob, Record[0]);
+      continue;
+    }
+    if (State == ASTBlock && Code == UPDATE_VISIBLE && Record[1] > 0) {
+      addHashes(DeclNameHashes, ID, Blob, Record[1]);
+      continue;
+    }
+
     // We don't care about this record.
   }
 
@@ -648,6 +870,74 @@ public:
   }
 };
 
+/// \brief Trait used to generate the selector and declaration name indexes
+/// as on-disk hash tables.
+class HashIndexWriterTrait {
+public:
+  typedef unsigned key_type;
+  typedef unsigned key_type_ref;
+  typedef SmallVector<unsigned, 2> data_type;
+  typedef const SmallVector<unsigned, 2> &data_type_ref;
+
+  static unsigned ComputeHash(key_type_ref Key) {
+    return Key;
+  }
+
+  std::pair<unsigned,unsigned>
+  EmitKeyDataLength(raw_ostream& Out, key_type_ref Key, data_type_ref Data) {
+    unsigned KeyLen = 4;
+    unsigned DataLen = Data.size() * 4;
+    clang::io::Emit16(Out, KeyLen);
+    clang::io::Emit16(Out, DataLen);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  void EmitKey(raw_ostream& Out, key_type_ref Key, unsigned KeyLen) {
+    clang::io::Emit32(Out, Key);
+  }
+
+  void EmitData(raw_ostream& Out, key_type_ref Key, data_type_ref Data,
+                unsigned DataLen) {
+    for (unsigned I = 0, N = Data.size(); I != N; ++I)
+      clang::io::Emit32(Out, Data[I]);
+  }
+};
+
+}
+
+/// \brief Write one of the hash-keyed indexes as the record \p Code.
+static void writeHashIndex(llvm::BitstreamWriter &Stream, unsigned Code,
+                           const std::map<unsigned,
+                                          SmallVector<unsigned, 2> > &Index) {
+  using namespace llvm;
+
+  OnDiskChainedHashTableGenerator<HashIndexWriterTrait> Generator;
+  HashIndexWriterTrait Trait;
+  for (std::map<unsigned, SmallVector<unsigned, 2> >::const_iterator
+         I = Index.begin(), IEnd = Index.end();
+       I != IEnd; ++I)
+    Generator.insert(I->first, I->second, Trait);
+
+  // Create the on-disk hash table in a buffer.
+  SmallString<4096> Table;
+  uint32_t BucketOffset;
+  {
+    llvm::raw_svector_ostream Out(Table);
+    // Make sure that no bucket is at offset 0
+    clang::io::Emit32(Out, 0);
+    BucketOffset = Generator.Emit(Out, Trait);
+  }
+
+  BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(Code));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+  unsigned TableAbbrev = Stream.EmitAbbrev(Abbrev);
+
+  SmallVector<uint64_t, 2> Record;
+  Record.push_back(Code);
+  Record.push_back(BucketOffset);
+  Stream.EmitRecordWithBlob(TableAbbrev, Record, Table.str());
 }
 
 void GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
@@ -726,6 +1016,11 @@ void GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
     Stream.EmitRecordWithBlob(IDTableAbbrev, Record, IdentifierTable.str());
   }
 
+  // Write the selector -> module file and declaration name -> module file
+  // mappings.
+  writeHashIndex(Stream, SELECTOR_INDEX, SelectorHashes);
+  writeHashIndex(Stream, DECL_NAME_INDEX, DeclNameHashes);
+
   Stream.ExitBlock();
 }
 
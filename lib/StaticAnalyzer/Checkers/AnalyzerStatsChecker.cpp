@@ -110,7 +110,8 @@ void AnalyzerStatsChecker::checkEndAnalysis(ExplodedGraph &G,
       << unreachable << " | Exhausted Block: "
       << (Eng.wasBlocksExhausted() ? "yes" : "no")
       << " | Empty WorkList: "
-      << (Eng.hasEmptyWorkList() ? "yes" : "no");
+      << (Eng.hasEmptyWorkList() ? "yes" : "no")
+      << " | Graph Memory: " << (G.getTotalMemory() >> 10) << " KB";
 
   B.EmitBasicReport(D, "Analyzer Statistics", "Internal Statistics",
                     output.str(), PathDiagnosticLocation(D, SM));
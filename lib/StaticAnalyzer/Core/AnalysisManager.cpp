@@ -45,11 +45,14 @@ AnalysisManager::~AnalysisManager() {
   }
 }
 
-void AnalysisManager::FlushDiagnostics() {
+void AnalysisManager::FlushDiagnostics(
+    PathDiagnosticConsumer::FilesMade *Files) {
   PathDiagnosticConsumer::FilesMade filesMade;
+  if (!Files)
+    Files = &filesMade;
   for (PathDiagnosticConsumers::iterator I = PathConsumers.begin(),
        E = PathConsumers.end();
        I != E; ++I) {
-    (*I)->FlushDiagnostics(&filesMade);
+    (*I)->FlushDiagnostics(Files);
   }
 }
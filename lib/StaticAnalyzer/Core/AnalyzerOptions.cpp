@@ -65,6 +65,24 @@ IPAKind AnalyzerOptions::getIPAMode() {
   return IPAMode;
 }
 
+ExplorationStrategyKind AnalyzerOptions::getExplorationStrategy() {
+  if (ExplorationStrategy == ESK_NotSet) {
+    StringRef StrategyStr(
+        Config.GetOrCreateValue("exploration-strategy", "dfs").getValue());
+    ExplorationStrategyKind Strategy =
+      llvm::StringSwitch<ExplorationStrategyKind>(StrategyStr)
+        .Case("dfs", ESK_DFS)
+        .Case("bfs", ESK_BFS)
+        .Case("bfs-block-dfs-contents", ESK_BFSBlockDFSContents)
+        .Case("unexplored-first", ESK_UnexploredFirst)
+        .Case("unexplored-first-queue", ESK_UnexploredFirstQueue)
+        .Default(ESK_NotSet);
+    assert(Strategy != ESK_NotSet && "Exploration strategy is invalid.");
+    ExplorationStrategy = Strategy;
+  }
+  return ExplorationStrategy;
+}
+
 bool
 AnalyzerOptions::mayInlineCXXMemberFunction(CXXInlineableMemberKind K) {
   if (getIPAMode() < IPAK_Inlining)
@@ -229,6 +247,17 @@ unsigned AnalyzerOptions::getGraphTrimInterval() {
   return GraphTrimInterval.getValue();
 }
 
+bool AnalyzerOptions::shouldTrimGraphAggressively() {
+  return getBooleanOption(TrimGraphAggressively, "graph-trim-aggressive",
+                          /* Default = */ false);
+}
+
+unsigned AnalyzerOptions::getGraphMemoryLimit() {
+  if (!GraphMemoryLimit.hasValue())
+    GraphMemoryLimit = getOptionAsInteger("graph-memory-limit", 0);
+  return GraphMemoryLimit.getValue();
+}
+
 unsigned AnalyzerOptions::getMaxTimesInlineLarge() {
   if (!MaxTimesInlineLarge.hasValue())
     MaxTimesInlineLarge = getOptionAsInteger("max-times-inline-large", 32);
@@ -45,6 +45,9 @@ STATISTIC(MaxBugClassSize,
 STATISTIC(MaxValidBugClassSize,
           "The maximum number of bug reports in the same equivalence class "
           "where at least one report is valid (not suppressed)");
+STATISTIC(NumTrimmedGraphsReused,
+          "The number of times a trimmed graph was reused for another "
+          "PathDiagnosticConsumer");
 
 BugReporterVisitor::~BugReporterVisitor() {}
 
@@ -2756,6 +2759,11 @@ PathDiagnosticLocation BugReport::getLocation(const SourceManager &SM) const {
 
 BugReportEquivClass::~BugReportEquivClass() { }
 GRBugReporter::~GRBugReporter() { }
+
+void GRBugReporter::finishPathGeneration() {
+  TrimG.reset();
+  TrimmedReports = ArrayRef<BugReport *>();
+}
 BugReporterData::~BugReporterData() {}
 
 ExplodedGraph &GRBugReporter::getGraph() { return Eng.getGraph(); }
@@ -2814,7 +2822,8 @@ void BugReporter::FlushReports() {
 // PathDiagnostics generation.
 //===----------------------------------------------------------------------===//
 
-namespace {
+namespace clang {
+namespace ento {
 /// A wrapper around a report graph, which contains only a single path, and its
 /// node maps.
 class ReportGraph {
@@ -2835,6 +2844,9 @@ class TrimmedGraph {
   typedef std::pair<const ExplodedNode *, size_t> NodeIndexPair;
   SmallVector<NodeIndexPair, 32> ReportNodes;
 
+  /// The number of report graphs popped since the last rewind().
+  size_t NumPopped;
+
   OwningPtr<ExplodedGraph> G;
 
   /// A helper class for sorting ExplodedNodes by priority.
@@ -2868,12 +2880,19 @@ public:
   TrimmedGraph(const ExplodedGraph *OriginalGraph,
                ArrayRef<const ExplodedNode *> Nodes);
 
+  /// Creates the graph of the shortest path to the next error node, starting
+  /// from the closest one.
   bool popNextReportGraph(ReportGraph &GraphWrapper);
+
+  /// Starts over from the closest error node.
+  void rewind() { NumPopped = 0; }
 };
-}
+} // end namespace ento
+} // end namespace clang
 
 TrimmedGraph::TrimmedGraph(const ExplodedGraph *OriginalGraph,
-                           ArrayRef<const ExplodedNode *> Nodes) {
+                           ArrayRef<const ExplodedNode *> Nodes)
+  : NumPopped(0) {
   // The trimmed graph is created in the body of the constructor to ensure
   // that the DenseMaps have been initialized already.
   InterExplodedGraphMap ForwardMap;
@@ -2931,11 +2950,12 @@ TrimmedGraph::TrimmedGraph(const ExplodedGraph *OriginalGraph,
 }
 
 bool TrimmedGraph::popNextReportGraph(ReportGraph &GraphWrapper) {
-  if (ReportNodes.empty())
+  if (NumPopped == ReportNodes.size())
     return false;
 
   const ExplodedNode *OrigN;
-  llvm::tie(OrigN, GraphWrapper.Index) = ReportNodes.pop_back_val();
+  llvm::tie(OrigN, GraphWrapper.Index) =
+    ReportNodes[ReportNodes.size() - ++NumPopped];
   assert(PriorityMap.find(OrigN) != PriorityMap.end() &&
          "error node not accessible from root");
 
@@ -3114,15 +3134,26 @@ bool GRBugReporter::generatePathDiagnostic(PathDiagnostic& PD,
     }
   }
 
-  TrimmedGraph TrimG(&getGraph(), errorNodes);
+  // Trimming the graph is expensive, so the trimmed graph is shared by the
+  // consumers. It still contains the error nodes of the reports which the
+  // previous consumers found invalid, which are skipped.
+  if (!TrimG || TrimmedReports.data() != bugReports.data() ||
+      TrimmedReports.size() != bugReports.size()) {
+    TrimG.reset(new TrimmedGraph(&getGraph(), errorNodes));
+    TrimmedReports = bugReports;
+  } else {
+    TrimG->rewind();
+    ++NumTrimmedGraphsReused;
+  }
   ReportGraph ErrorGraph;
 
-  while (TrimG.popNextReportGraph(ErrorGraph)) {
+  while (TrimG->popNextReportGraph(ErrorGraph)) {
     // Find the BugReport with the original location.
     assert(ErrorGraph.Index < bugReports.size());
     BugReport *R = bugReports[ErrorGraph.Index];
     assert(R && "No original report found for sliced graph.");
-    assert(R->isValid() && "Report selected by trimmed graph marked invalid.");
+    if (!R->isValid())
+      continue;
 
     // Start building the path diagnostic...
     PathDiagnosticBuilder PDB(*this, R, ErrorGraph.BackMap, &PC);
@@ -3408,6 +3439,7 @@ void BugReporter::FlushReport(BugReportEquivClass& EQ) {
                                                  E=C.end(); I != E; ++I) {
       FlushReport(exampleReport, **I, bugReports);
     }
+    finishPathGeneration();
   }
 }
 
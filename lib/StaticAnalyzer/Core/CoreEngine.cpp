@@ -20,8 +20,12 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Casting.h"
+#include <algorithm>
+#include <climits>
+#include <queue>
 
 using namespace clang;
 using namespace ento;
@@ -32,6 +36,13 @@ STATISTIC(NumReachedMaxSteps,
             "The # of times we reached the max number of steps.");
 STATISTIC(NumPathsExplored,
             "The # of paths explored by the analyzer.");
+STATISTIC(NumReachedGraphMemoryLimit,
+            "The # of times we reached the exploded graph memory limit.");
+STATISTIC(MaxGraphMemory,
+            "The maximum # of kilobytes used by an exploded graph.");
+
+/// How many steps to take between checks of the graph memory limit.
+static const unsigned GraphMemoryCheckInterval = 1024;
 
 //===----------------------------------------------------------------------===//
 // Worklist classes for exploration of reachable states.
@@ -156,6 +167,175 @@ WorkList* WorkList::makeBFSBlockDFSContents() {
   return new BFSBlockDFSContents();
 }
 
+/// Identifies a basic block entered in a given stack frame.
+typedef std::pair<unsigned, const StackFrameContext *> BlockInFrame;
+
+static BlockInFrame getBlockInFrame(const ExplodedNode *N,
+                                    const BlockEntrance &BE) {
+  return std::make_pair(BE.getBlock()->getBlockID(),
+                        N->getLocationContext()->getCurrentStackFrame());
+}
+
+namespace {
+  class UnexploredFirstStack : public WorkList {
+    /// The units that enter a block for the first time, and the units
+    /// following them within the block.
+    SmallVector<WorkListUnit,20> StackUnexplored;
+    /// All the other units.
+    SmallVector<WorkListUnit,20> StackOthers;
+    llvm::DenseSet<BlockInFrame> Reached;
+  public:
+    virtual bool hasWork() const {
+      return !StackUnexplored.empty() || !StackOthers.empty();
+    }
+
+    virtual void enqueue(const WorkListUnit& U) {
+      const ExplodedNode *N = U.getNode();
+      Optional<BlockEntrance> BE = N->getLocation().getAs<BlockEntrance>();
+      // Assume the choice of the block entrance preceding this unit was
+      // right, and keep going.
+      if (!BE || Reached.insert(getBlockInFrame(N, *BE)).second)
+        StackUnexplored.push_back(U);
+      else
+        StackOthers.push_back(U);
+    }
+
+    virtual WorkListUnit dequeue() {
+      SmallVectorImpl<WorkListUnit> &Stack =
+        StackUnexplored.empty() ? StackOthers : StackUnexplored;
+      assert(!Stack.empty());
+      WorkListUnit U = Stack.back();
+      Stack.pop_back();
+      return U;
+    }
+
+    virtual bool visitItemsInWorkList(Visitor &V) {
+      for (SmallVectorImpl<WorkListUnit>::iterator
+           I = StackUnexplored.begin(), E = StackUnexplored.end(); I != E; ++I)
+        if (V.visit(*I))
+          return true;
+      for (SmallVectorImpl<WorkListUnit>::iterator
+           I = StackOthers.begin(), E = StackOthers.end(); I != E; ++I)
+        if (V.visit(*I))
+          return true;
+      return false;
+    }
+  };
+
+  class UnexploredFirstPriorityQueue : public WorkList {
+    struct QueueItem {
+      WorkListUnit Unit;
+      /// How often the block was entered before this unit was queued, over
+      /// all paths.
+      unsigned TimesReached;
+      /// How often the path of this unit went through the block before.
+      unsigned TimesOnPath;
+      /// The order in which the units were queued.
+      unsigned Order;
+
+      QueueItem(const WorkListUnit &Unit, unsigned TimesReached,
+                unsigned TimesOnPath, unsigned Order)
+        : Unit(Unit), TimesReached(TimesReached), TimesOnPath(TimesOnPath),
+          Order(Order) {}
+    };
+
+    /// Orders the items by increasing priority.
+    struct LowerPriority {
+      bool operator()(const QueueItem &LHS, const QueueItem &RHS) const {
+        if (LHS.TimesReached != RHS.TimesReached)
+          return LHS.TimesReached > RHS.TimesReached;
+        if (LHS.TimesOnPath != RHS.TimesOnPath)
+          return LHS.TimesOnPath > RHS.TimesOnPath;
+        // Otherwise behave like a stack.
+        return LHS.Order < RHS.Order;
+      }
+    };
+
+    std::priority_queue<QueueItem, std::vector<QueueItem>, LowerPriority>
+      Queue;
+    llvm::DenseMap<BlockInFrame, unsigned> NumReached;
+    unsigned NumQueued;
+  public:
+    UnexploredFirstPriorityQueue() : NumQueued(0) {}
+
+    virtual bool hasWork() const {
+      return !Queue.empty();
+    }
+
+    virtual void enqueue(const WorkListUnit& U) {
+      const ExplodedNode *N = U.getNode();
+      unsigned TimesReached = 0, TimesOnPath = 0;
+      // Units within a block are continued right away.
+      if (Optional<BlockEntrance> BE =
+              N->getLocation().getAs<BlockEntrance>()) {
+        BlockInFrame B = getBlockInFrame(N, *BE);
+        TimesReached = NumReached[B]++;
+        TimesOnPath = U.getBlockCounter().getNumVisited(B.second, B.first);
+      }
+      Queue.push(QueueItem(U, TimesReached, TimesOnPath, NumQueued++));
+    }
+
+    virtual WorkListUnit dequeue() {
+      assert(!Queue.empty());
+      WorkListUnit U = Queue.top().Unit;
+      Queue.pop();
+      return U;
+    }
+
+    virtual bool visitItemsInWorkList(Visitor &V) {
+      // std::priority_queue does not expose its elements, so we walk a copy.
+      std::priority_queue<QueueItem, std::vector<QueueItem>, LowerPriority>
+        Copy(Queue);
+      for (; !Copy.empty(); Copy.pop())
+        if (V.visit(Copy.top().Unit))
+          return true;
+      return false;
+    }
+  };
+} // end anonymous namespace
+
+WorkList *WorkList::makeUnexploredFirst() {
+  return new UnexploredFirstStack();
+}
+
+WorkList *WorkList::makeUnexploredFirstPriorityQueue() {
+  return new UnexploredFirstPriorityQueue();
+}
+
+static WorkList *makeWorkList(AnalyzerOptions &Opts) {
+  switch (Opts.getExplorationStrategy()) {
+  case ESK_DFS:
+    return WorkList::makeDFS();
+  case ESK_BFS:
+    return WorkList::makeBFS();
+  case ESK_BFSBlockDFSContents:
+    return WorkList::makeBFSBlockDFSContents();
+  case ESK_UnexploredFirst:
+    return WorkList::makeUnexploredFirst();
+  case ESK_UnexploredFirstQueue:
+    return WorkList::makeUnexploredFirstPriorityQueue();
+  case ESK_NotSet:
+    break;
+  }
+  llvm_unreachable("Unknown exploration strategy.");
+}
+
+CoreEngine::CoreEngine(SubEngine &subengine, FunctionSummariesTy *FS,
+                       AnalyzerOptions &Opts)
+  : SubEng(subengine), G(new ExplodedGraph()),
+    WList(makeWorkList(Opts)),
+    BCounterFactory(G->getAllocator()),
+    FunctionSummaries(FS), NumStepsTaken(0),
+    GraphMemoryLimit(uint64_t(Opts.getGraphMemoryLimit()) << 20) {}
+
+bool CoreEngine::exceedsGraphMemoryLimit() {
+  // Measuring the graph walks the slabs of its allocator, so only do it
+  // every so often.
+  if (!GraphMemoryLimit || NumStepsTaken % GraphMemoryCheckInterval != 0)
+    return false;
+  return G->getTotalMemory() > GraphMemoryLimit;
+}
+
 //===----------------------------------------------------------------------===//
 // Core analysis engine.
 //===----------------------------------------------------------------------===//
@@ -209,7 +389,13 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
       --Steps;
     }
 
+    if (exceedsGraphMemoryLimit()) {
+      NumReachedGraphMemoryLimit++;
+      break;
+    }
+
     NumSteps++;
+    NumStepsTaken++;
 
     const WorkListUnit& WU = WList->dequeue();
 
@@ -221,6 +407,14 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
 
     dispatchWorkItem(Node, Node->getLocation(), WU);
   }
+
+  // The graph only grows while we explore it, so its final size is its peak.
+  // Statistics are only 32 bits wide, so count kilobytes rather than bytes.
+  uint64_t GraphMemoryKB = G->getTotalMemory() / 1024;
+  if (GraphMemoryKB > MaxGraphMemory)
+    MaxGraphMemory = static_cast<unsigned>(
+        std::min(GraphMemoryKB, static_cast<uint64_t>(UINT_MAX)));
+
   SubEng.processEndWorklist(hasWorkRemaining());
   return WList->hasWork();
 }
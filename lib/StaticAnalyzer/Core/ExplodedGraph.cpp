@@ -48,7 +48,8 @@ void ExplodedNode::SetAuditor(ExplodedNode::Auditor* A) {
 //===----------------------------------------------------------------------===//
 
 ExplodedGraph::ExplodedGraph()
-  : NumNodes(0), ReclaimNodeInterval(0) {}
+  : NumNodes(0), ReclaimNodeInterval(0), ReclaimCounter(0),
+    AggressiveReclamation(false) {}
 
 ExplodedGraph::~ExplodedGraph() {}
 
@@ -92,7 +93,15 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // (9) The PostStmt isn't for a non-consumed Stmt or Expr.
   // (10) The successor is not a CallExpr StmtPoint (so that we would
   //      be able to find it when retrying a call with no inlining).
-  // FIXME: It may be safe to reclaim PreCall and PostCall nodes as well.
+  //
+  // In aggressive mode, condition (3) also admits the PreStmt, PreLoad,
+  // PreStore, PostStmtPurgeDeadSymbols and PreImplicitCall points. Nothing
+  // but their location tells such an untagged node apart from its
+  // predecessor, and path diagnostics are built from the PostStmt, call and
+  // block edge nodes, which we keep. Tagged nodes are still kept, as checkers
+  // anchor bug reports to them. Conditions (8) and (9) only concern PostStmt
+  // nodes.
+  // FIXME: It may be safe to reclaim PostCall nodes as well.
 
   // Conditions 1 and 2.
   if (node->pred_size() != 1 || node->succ_size() != 1)
@@ -113,7 +122,15 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
     return !progPoint.getTag();
 
   // Condition 3.
-  if (!progPoint.getAs<PostStmt>() || progPoint.getAs<PostStore>())
+  bool IsPostStmt = progPoint.getAs<PostStmt>() &&
+                    !progPoint.getAs<PostStore>();
+  bool IsIntermediate = AggressiveReclamation &&
+                        (progPoint.getAs<PreStmt>() ||
+                         progPoint.getAs<PreLoad>() ||
+                         progPoint.getAs<PreStore>() ||
+                         progPoint.getAs<PostStmtPurgeDeadSymbols>() ||
+                         progPoint.getAs<PreImplicitCall>());
+  if (!IsPostStmt && !IsIntermediate)
     return false;
 
   // Condition 4.
@@ -127,6 +144,15 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
       progPoint.getLocationContext() != pred->getLocationContext())
     return false;
 
+  // Condition 10.
+  const ProgramPoint SuccLoc = succ->getLocation();
+  if (Optional<StmtPoint> SP = SuccLoc.getAs<StmtPoint>())
+    if (CallEvent::isCallStmt(SP->getStmt()))
+      return false;
+
+  if (!IsPostStmt)
+    return true;
+
   // All further checks require expressions. As per #3, we know that we have
   // a PostStmt.
   const Expr *Ex = dyn_cast<Expr>(progPoint.castAs<PostStmt>().getStmt());
@@ -147,12 +173,6 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   if (!PM.isConsumedExpr(Ex))
     return false;
 
-  // Condition 10.
-  const ProgramPoint SuccLoc = succ->getLocation();
-  if (Optional<StmtPoint> SP = SuccLoc.getAs<StmtPoint>())
-    if (CallEvent::isCallStmt(SP->getStmt()))
-      return false;
-
   return true;
 }
 
@@ -836,7 +836,7 @@ bool ExprEngine::shouldInlineCall(const CallEvent &Call, const Decl *D,
     if (mayInlineDecl(CalleeADC, Opts)) {
       Engine.FunctionSummaries->markMayInline(D);
     } else {
-      Engine.FunctionSummaries->markShouldNotInline(D);
+      Engine.FunctionSummaries->markShouldNeverInline(D);
       return false;
     }
   }
@@ -0,0 +1,97 @@
+//== GenericDataMap.cpp - Checker data stored in a ProgramState --*- C++ -*--=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements GenericDataMap.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "GenericDataMap"
+
+#include "clang/StaticAnalyzer/Core/PathSensitive/GenericDataMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Allocator.h"
+#include <algorithm>
+#include <functional>
+
+using namespace clang;
+using namespace ento;
+
+STATISTIC(NumGenericDataMaps,
+            "The # of distinct generic data maps created.");
+STATISTIC(NumGenericDataMapBytes,
+            "The # of bytes allocated for generic data maps.");
+
+namespace {
+/// \brief Orders the entries of a GenericDataMap by key.
+struct KeyLess {
+  bool operator()(const GenericDataMap::value_type &LHS, void *Key) const {
+    return std::less<void *>()(LHS.first, Key);
+  }
+};
+}
+
+void *const *GenericDataMap::lookup(void *Key) const {
+  iterator I = std::lower_bound(begin(), end(), Key, KeyLess());
+  if (I == end() || I->first != Key)
+    return 0;
+  return &I->second;
+}
+
+void GenericDataMap::Storage::Profile(llvm::FoldingSetNodeID &ID,
+                                      ArrayRef<value_type> Entries) {
+  for (unsigned I = 0, E = Entries.size(); I != E; ++I) {
+    ID.AddPointer(Entries[I].first);
+    ID.AddPointer(Entries[I].second);
+  }
+}
+
+GenericDataMap GenericDataMap::Factory::getMap(ArrayRef<value_type> Entries) {
+  if (Entries.empty())
+    return getEmptyMap();
+
+  llvm::FoldingSetNodeID ID;
+  Storage::Profile(ID, Entries);
+  void *InsertPos;
+  if (Storage *Existing = Maps.FindNodeOrInsertPos(ID, InsertPos))
+    return GenericDataMap(Existing);
+
+  size_t Size = sizeof(Storage) + Entries.size() * sizeof(value_type);
+  void *Mem = Alloc.Allocate(Size, llvm::AlignOf<Storage>::Alignment);
+  Storage *New = new (Mem) Storage(Entries.size());
+  std::copy(Entries.begin(), Entries.end(), New->begin());
+  Maps.InsertNode(New, InsertPos);
+
+  ++NumGenericDataMaps;
+  NumGenericDataMapBytes += Size;
+  return GenericDataMap(New);
+}
+
+GenericDataMap GenericDataMap::Factory::add(GenericDataMap Old, void *Key,
+                                            void *Value) {
+  iterator I = std::lower_bound(Old.begin(), Old.end(), Key, KeyLess());
+  bool Replace = I != Old.end() && I->first == Key;
+  if (Replace && I->second == Value)
+    return Old;
+
+  SmallVector<value_type, 16> Entries(Old.begin(), I);
+  Entries.push_back(value_type(Key, Value));
+  Entries.append(Replace ? I + 1 : I, Old.end());
+  return getMap(Entries);
+}
+
+GenericDataMap GenericDataMap::Factory::remove(GenericDataMap Old, void *Key) {
+  iterator I = std::lower_bound(Old.begin(), Old.end(), Key, KeyLess());
+  if (I == Old.end() || I->first != Key)
+    return Old;
+
+  SmallVector<value_type, 16> Entries(Old.begin(), I);
+  Entries.append(I + 1, Old.end());
+  return getMap(Entries);
+}
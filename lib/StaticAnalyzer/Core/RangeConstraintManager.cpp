@@ -12,18 +12,27 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "RangeConstraintManager"
+
 #include "SimpleConstraintManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/APSIntType.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "llvm/ADT/FoldingSet.h"
-#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <memory>
 
 using namespace clang;
 using namespace ento;
 
+STATISTIC(NumRangeSets, "The # of distinct range sets created.");
+STATISTIC(NumRangeSetBytes, "The # of bytes allocated for range sets.");
+
 /// A Range represents the closed range [from, to].  The caller must
 /// guarantee that from <= to.  Note that Range is immutable, so as not
 /// to subvert RangeSet's immutability.
@@ -55,59 +64,113 @@ public:
 };
 
 
-class RangeTrait : public llvm::ImutContainerInfo<Range> {
-public:
-  // When comparing if one Range is less than another, we should compare
-  // the actual APSInt values instead of their pointers.  This keeps the order
-  // consistent (instead of comparing by pointer values) and can potentially
-  // be used to speed up some of the operations in RangeSet.
-  static inline bool isLess(key_type_ref lhs, key_type_ref rhs) {
-    return *lhs.first < *rhs.first || (!(*rhs.first < *lhs.first) &&
-                                       *lhs.second < *rhs.second);
-  }
-};
-
 /// RangeSet contains a set of ranges. If the set is empty, then
 ///  there the value of a symbol is overly constrained and there are no
 ///  possible values for that symbol.
+///
+/// The ranges are disjoint and stored in ascending order in an immutable
+/// array. Sets are uniqued by their Factory, so two sets with the same
+/// ranges share one array and are compared and profiled by address.
 class RangeSet {
-  typedef llvm::ImmutableSet<Range, RangeTrait> PrimRangeSet;
-  PrimRangeSet ranges; // no need to make const, since it is an
-                       // ImmutableSet - this allows default operator=
-                       // to work.
+  /// The uniqued storage of a non-empty set, followed in memory by its
+  /// ranges.
+  class Storage : public llvm::FoldingSetNode {
+    unsigned NumRanges;
+
+  public:
+    explicit Storage(unsigned NumRanges) : NumRanges(NumRanges) {}
+
+    unsigned size() const { return NumRanges; }
+    Range *begin() { return reinterpret_cast<Range *>(this + 1); }
+    const Range *begin() const {
+      return reinterpret_cast<const Range *>(this + 1);
+    }
+    const Range *end() const { return begin() + NumRanges; }
+
+    static void Profile(llvm::FoldingSetNodeID &ID, ArrayRef<Range> Ranges) {
+      for (unsigned I = 0, E = Ranges.size(); I != E; ++I)
+        Ranges[I].Profile(ID);
+    }
+    void Profile(llvm::FoldingSetNodeID &ID) const {
+      Profile(ID, ArrayRef<Range>(begin(), end()));
+    }
+  };
+
+  /// The ranges of the set, or null if the set is empty.
+  const Storage *Ranges;
+
+  explicit RangeSet(const Storage *Ranges) : Ranges(Ranges) {}
+
 public:
-  typedef PrimRangeSet::Factory Factory;
-  typedef PrimRangeSet::iterator iterator;
+  /// Creates and uniques RangeSets.
+  class Factory {
+    llvm::BumpPtrAllocator Alloc;
+    llvm::FoldingSet<Storage> Sets;
+
+    Factory(const Factory &) LLVM_DELETED_FUNCTION;
+    void operator=(const Factory &) LLVM_DELETED_FUNCTION;
+
+  public:
+    Factory() {}
+
+    RangeSet getEmptySet() const { return RangeSet(0); }
+
+    /// Returns the unique set of the given ranges, which must be disjoint
+    /// and in ascending order.
+    RangeSet getSet(ArrayRef<Range> NewRanges) {
+      if (NewRanges.empty())
+        return getEmptySet();
+
+      llvm::FoldingSetNodeID ID;
+      Storage::Profile(ID, NewRanges);
+      void *InsertPos;
+      if (Storage *Existing = Sets.FindNodeOrInsertPos(ID, InsertPos))
+        return RangeSet(Existing);
+
+      size_t Size = sizeof(Storage) + NewRanges.size() * sizeof(Range);
+      void *Mem = Alloc.Allocate(Size, llvm::AlignOf<Storage>::Alignment);
+      Storage *New = new (Mem) Storage(NewRanges.size());
+      std::uninitialized_copy(NewRanges.begin(), NewRanges.end(),
+                              New->begin());
+      Sets.InsertNode(New, InsertPos);
+
+      ++NumRangeSets;
+      NumRangeSetBytes += Size;
+      return RangeSet(New);
+    }
+  };
 
-  RangeSet(PrimRangeSet RS) : ranges(RS) {}
+  typedef const Range *iterator;
 
-  iterator begin() const { return ranges.begin(); }
-  iterator end() const { return ranges.end(); }
+  iterator begin() const { return Ranges ? Ranges->begin() : 0; }
+  iterator end() const { return Ranges ? Ranges->end() : 0; }
 
-  bool isEmpty() const { return ranges.isEmpty(); }
+  bool isEmpty() const { return !Ranges; }
 
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
-    : ranges(F.add(F.getEmptySet(), Range(from, to))) {}
+    : Ranges(F.getSet(Range(from, to)).Ranges) {}
 
   /// Profile - Generates a hash profile of this RangeSet for use
   ///  by FoldingSet.
-  void Profile(llvm::FoldingSetNodeID &ID) const { ranges.Profile(ID); }
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Ranges); }
 
   /// getConcreteValue - If a symbol is contrained to equal a specific integer
   ///  constant then this method returns that value.  Otherwise, it returns
   ///  NULL.
   const llvm::APSInt* getConcreteValue() const {
-    return ranges.isSingleton() ? ranges.begin()->getConcreteValue() : 0;
+    return Ranges && Ranges->size() == 1 ? begin()->getConcreteValue() : 0;
   }
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
+  typedef SmallVector<Range, 4> RangeVector;
+
+  void IntersectInRange(BasicValueFactory &BV,
                         const llvm::APSInt &Lower,
                         const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges,
-                        PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const {
+                        RangeVector &newRanges,
+                        iterator &i,
+                        iterator &e) const {
     // There are six cases for each range R in the set:
     //   1. R is entirely before the intersection range.
     //   2. R is entirely after the intersection range.
@@ -126,24 +189,23 @@ private:
 
       if (i->Includes(Lower)) {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower),
-                                             BV.getValue(Upper)));
+          newRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
+          newRanges.push_back(Range(BV.getValue(Lower), i->To()));
       } else {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
+          newRanges.push_back(Range(i->From(), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, *i);
+          newRanges.push_back(*i);
       }
     }
   }
 
   const llvm::APSInt &getMinValue() const {
     assert(!isEmpty());
-    return ranges.begin()->From();
+    return begin()->From();
   }
 
   bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
@@ -240,20 +302,26 @@ public:
     if (!pin(Lower, Upper))
       return F.getEmptySet();
 
-    PrimRangeSet newRanges = F.getEmptySet();
+    RangeVector newRanges;
 
-    PrimRangeSet::iterator i = begin(), e = end();
+    iterator i = begin(), e = end();
     if (Lower <= Upper)
-      IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, Upper, newRanges, i, e);
     else {
       // The order of the next two statements is important!
       // IntersectInRange() does not reset the iteration state for i and e.
       // Therefore, the lower range most be handled first.
-      IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-      IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+      IntersectInRange(BV, BV.getMinValue(Upper), Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, BV.getMaxValue(Lower), newRanges, i, e);
     }
 
-    return newRanges;
+    // Intersecting with a range that covers the whole set is common, and
+    // then there is no need to look the set up again.
+    if (newRanges.size() == Ranges->size() &&
+        std::equal(newRanges.begin(), newRanges.end(), begin()))
+      return *this;
+
+    return F.getSet(newRanges);
   }
 
   void print(raw_ostream &os) const {
@@ -272,7 +340,7 @@ public:
   }
 
   bool operator==(const RangeSet &other) const {
-    return ranges == other.ranges;
+    return Ranges == other.Ranges;
   }
 };
 } // end anonymous namespace
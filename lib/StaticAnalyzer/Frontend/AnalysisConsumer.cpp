@@ -14,6 +14,8 @@
 #define DEBUG_TYPE "AnalysisConsumer"
 
 #include "AnalysisConsumer.h"
+#include "ResultCache.h"
+#include "SummaryCache.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
@@ -25,6 +27,9 @@
 #include "clang/Analysis/CallGraph.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/StaticAnalyzer/Checkers/LocalCheckers.h"
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
@@ -35,16 +40,19 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Frontend/CheckerRegistration.h"
-#include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
 #include <queue>
 
 using namespace clang;
@@ -52,6 +60,8 @@ using namespace ento;
 using llvm::SmallPtrSet;
 
 static ExplodedNode::Auditor* CreateUbiViz();
+static void printConfiguration(const AnalyzerOptions &Opts, raw_ostream &OS);
+static unsigned hashConfiguration(const AnalyzerOptions &Opts);
 
 STATISTIC(NumFunctionTopLevel, "The # of functions at top level.");
 STATISTIC(NumFunctionsAnalyzed,
@@ -61,6 +71,18 @@ STATISTIC(NumBlocksInAnalyzedFunctions,
                       "The # of basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(NumStepsInAnalyzedFunctions,
+                      "The # of work list steps taken in the analyzed "
+                      "functions.");
+STATISTIC(VisitedBlocksPerKiloStep,
+                      "The # of basic blocks visited per 1000 work list "
+                      "steps.");
+STATISTIC(NumNotInlinableFromSummaryCache,
+                      "The # of functions known not to be inlinable from "
+                      "the analysis of another translation unit.");
+STATISTIC(NumTranslationUnitsReplayed,
+                      "The # of translation units whose reports were "
+                      "replayed from the result cache.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -86,9 +108,10 @@ namespace {
 class ClangDiagPathDiagConsumer : public PathDiagnosticConsumer {
   DiagnosticsEngine &Diag;
   bool IncludePath;
+  ResultCache *Results;
 public:
   ClangDiagPathDiagConsumer(DiagnosticsEngine &Diag)
-    : Diag(Diag), IncludePath(false) {}
+    : Diag(Diag), IncludePath(false), Results(0) {}
   virtual ~ClangDiagPathDiagConsumer() {}
   virtual StringRef getName() const { return "ClangDiags"; }
 
@@ -103,9 +126,19 @@ public:
     IncludePath = true;
   }
 
-  void emitDiag(SourceLocation L, unsigned DiagID,
-                ArrayRef<SourceRange> Ranges) {
-    DiagnosticBuilder DiagBuilder = Diag.Report(L, DiagID);
+  /// Records the diagnostics emitted from now on in \p R.
+  void recordDiagsIn(ResultCache *R) {
+    Results = R;
+  }
+
+  void emitDiag(SourceLocation L, DiagnosticsEngine::Level Level,
+                StringRef Message, ArrayRef<SourceRange> Ranges) {
+    if (Results)
+      Results->recordDiagnostic(Diag.getSourceManager(), Level, Message, L,
+                                Ranges);
+
+    DiagnosticBuilder DiagBuilder =
+      Diag.Report(L, Diag.getCustomDiagID(Level, Message));
 
     for (ArrayRef<SourceRange>::iterator I = Ranges.begin(), E = Ranges.end();
          I != E; ++I) {
@@ -128,10 +161,9 @@ public:
           Out << *I;
       }
       Out.flush();
-      unsigned ErrorDiag = Diag.getCustomDiagID(DiagnosticsEngine::Warning,
-                                                TmpStr);
       SourceLocation L = PD->getLocation().asLocation();
-      emitDiag(L, ErrorDiag, PD->path.back()->getRanges());
+      emitDiag(L, DiagnosticsEngine::Warning, TmpStr,
+               PD->path.back()->getRanges());
 
       if (!IncludePath)
         continue;
@@ -140,11 +172,9 @@ public:
       for (PathPieces::const_iterator PI = FlatPath.begin(),
                                       PE = FlatPath.end();
            PI != PE; ++PI) {
-        unsigned NoteID = Diag.getCustomDiagID(DiagnosticsEngine::Note,
-                                               (*PI)->getString());
-
         SourceLocation NoteLoc = (*PI)->getLocation().asLocation();
-        emitDiag(NoteLoc, NoteID, (*PI)->getRanges());
+        emitDiag(NoteLoc, DiagnosticsEngine::Note, (*PI)->getString(),
+                 (*PI)->getRanges());
       }
     }
   }
@@ -188,6 +218,9 @@ public:
   // Set of PathDiagnosticConsumers.  Owned by AnalysisManager.
   PathDiagnosticConsumers PathConsumers;
 
+  /// The consumer emitting the reports as warnings, among PathConsumers.
+  ClangDiagPathDiagConsumer *ClangDiags;
+
   StoreManagerCreator CreateStoreMgr;
   ConstraintManagerCreator CreateConstraintMgr;
 
@@ -201,13 +234,37 @@ public:
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// The summaries of functions shared with the analyses of other translation
+  /// units, if enabled with -analyzer-summary-cache.
+  OwningPtr<SummaryCache> PersistentSummaries;
+
+  /// Identifies the summary of a function kept in PersistentSummaries.
+  struct PersistentSummaryKey {
+    std::string Name;
+
+    /// The hash of the tokens of the function's definition.
+    unsigned CodeHash;
+
+    /// The flags of the summary left by other translation units.
+    unsigned Flags;
+  };
+
+  /// The keys of the functions in the call graph.
+  llvm::DenseMap<const Decl *, PersistentSummaryKey> PersistentSummaryKeys;
+
   AnalysisConsumer(const Preprocessor& pp,
                    const std::string& outdir,
                    AnalyzerOptionsRef opts,
                    ArrayRef<std::string> plugins)
     : RecVisitorMode(0), RecVisitorBR(0),
-      Ctx(0), PP(pp), OutDir(outdir), Opts(opts), Plugins(plugins) {
+      Ctx(0), PP(pp), OutDir(outdir), Opts(opts), Plugins(plugins),
+      ClangDiags(0) {
     DigestAnalyzerOptions();
+    if (!Opts->SummaryCacheDir.empty()) {
+      PersistentSummaries.reset(
+          new SummaryCache(Opts->SummaryCacheDir, hashConfiguration(*Opts)));
+      PersistentSummaries->load();
+    }
     if (Opts->PrintStats) {
       llvm::EnableStatistics();
       TUTotalTimer = new llvm::Timer("Analyzer Total Time");
@@ -221,12 +278,11 @@ public:
 
   void DigestAnalyzerOptions() {
     // Create the PathDiagnosticConsumer.
-    ClangDiagPathDiagConsumer *clangDiags =
-      new ClangDiagPathDiagConsumer(PP.getDiagnostics());
-    PathConsumers.push_back(clangDiags);
+    ClangDiags = new ClangDiagPathDiagConsumer(PP.getDiagnostics());
+    PathConsumers.push_back(ClangDiags);
 
     if (Opts->AnalysisDiagOpt == PD_TEXT) {
-      clangDiags->enablePaths();
+      ClangDiags->enablePaths();
 
     } else if (!OutDir.empty()) {
       switch (Opts->AnalysisDiagOpt) {
@@ -330,6 +386,25 @@ public:
   /// use it to define the order in which the functions should be visited.
   void HandleDeclsCallGraph(const unsigned LocalTUDeclsSize);
 
+  /// \brief Compute the keys of the summaries of the functions in the call
+  /// graph which other translation units may share, and look up the
+  /// summaries they left.
+  void computePersistentSummaryKeys(ArrayRef<Decl *> Order);
+
+  /// \brief Compute the key of the results of this translation unit in the
+  /// result cache.
+  ///
+  /// \returns false if the results cannot be cached.
+  bool computeResultCacheKey(SmallString<32> &Key);
+
+  /// \brief Record the summaries of the given functions, for the analyses of
+  /// other translation units.
+  void recordPersistentSummaries(ArrayRef<Decl *> Order);
+
+  /// \brief Run path sensitive analysis on the given functions, in order,
+  /// skipping the ones inlined while analyzing the functions before them.
+  void HandleTopLevelFunctions(ArrayRef<Decl *> Order);
+
   /// \brief Run analyzes(syntax or path sensitive) on the given function.
   /// \param Mode - determines if we are requesting syntax only or path
   /// sensitive only analysis.
@@ -473,25 +548,291 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   }
 
   // Walk over all of the call graph nodes in topological order, so that we
-  // analyze parents before the children. Skip the functions inlined into
-  // the previously processed functions. Use external Visited set to identify
-  // inlined functions. The topological order allows the "do not reanalyze
-  // previously inlined function" performance heuristic to be triggered more
-  // often.
-  SetOfConstDecls Visited;
-  SetOfConstDecls VisitedAsTopLevel;
+  // analyze parents before the children. The topological order allows the
+  // "do not reanalyze previously inlined function" performance heuristic to
+  // be triggered more often.
+  SmallVector<Decl *, 64> Order;
   llvm::ReversePostOrderTraversal<clang::CallGraph*> RPOT(&CG);
   for (llvm::ReversePostOrderTraversal<clang::CallGraph*>::rpo_iterator
          I = RPOT.begin(), E = RPOT.end(); I != E; ++I) {
     NumFunctionTopLevel++;
 
-    CallGraphNode *N = *I;
-    Decl *D = N->getDecl();
-    
     // Skip the abstract root node.
-    if (!D)
+    if (Decl *D = (*I)->getDecl())
+      Order.push_back(D);
+  }
+
+  if (PersistentSummaries)
+    computePersistentSummaryKeys(Order);
+
+  HandleTopLevelFunctions(Order);
+}
+
+/// \brief Prints the options which may change the results of the analysis of
+/// a function.
+static void printConfiguration(const AnalyzerOptions &Opts, raw_ostream &OS) {
+  OS << getClangFullVersion() << '\n';
+
+  // Only the options given on the command line are in the table yet, and the
+  // others take their default values. Sort them, as the table is unordered.
+  std::vector<std::string> Entries;
+  for (AnalyzerOptions::ConfigTable::const_iterator I = Opts.Config.begin(),
+                                                    E = Opts.Config.end();
+       I != E; ++I)
+    Entries.push_back((I->getKey() + "=" + I->getValue()).str());
+  std::sort(Entries.begin(), Entries.end());
+  for (unsigned I = 0, E = Entries.size(); I != E; ++I)
+    OS << Entries[I] << '\n';
+
+  for (unsigned I = 0, E = Opts.CheckersControlList.size(); I != E; ++I)
+    OS << (Opts.CheckersControlList[I].second ? '+' : '-')
+       << Opts.CheckersControlList[I].first << '\n';
+
+  OS << Opts.AnalysisStoreOpt << ' ' << Opts.AnalysisConstraintsOpt << ' '
+     << Opts.AnalysisPurgeOpt << ' ' << Opts.AnalyzeAll << ' '
+     << Opts.AnalyzeNestedBlocks << ' ' << Opts.AnalyzeSpecificFunction << ' '
+     << Opts.maxBlockVisitOnPath << ' ' << Opts.eagerlyAssumeBinOpBifurcation
+     << ' ' << Opts.UnoptimizedCFG << ' ' << Opts.NoRetryExhausted << ' '
+     << Opts.InlineMaxStackDepth << ' ' << Opts.InliningMode << '\n';
+}
+
+static unsigned hashConfiguration(const AnalyzerOptions &Opts) {
+  std::string Config;
+  llvm::raw_string_ostream OS(Config);
+  printConfiguration(Opts, OS);
+  return llvm::HashString(OS.str());
+}
+
+typedef std::pair<const FileEntry *, SrcMgr::ContentCache *> FileAndContents;
+
+static bool compareFileNames(const FileAndContents &LHS,
+                             const FileAndContents &RHS) {
+  return std::strcmp(LHS.first->getName(), RHS.first->getName()) < 0;
+}
+
+bool AnalysisConsumer::computeResultCacheKey(SmallString<32> &Key) {
+  SourceManager &SM = Ctx->getSourceManager();
+
+  // The contents of the files in precompiled headers and modules are not
+  // available.
+  if (SM.loaded_sloc_entry_size() != 0)
+    return false;
+
+  llvm::MD5 Hash;
+  std::string Config;
+  llvm::raw_string_ostream OS(Config);
+  printConfiguration(*Opts, OS);
+  OS << Opts->AnalysisDiagOpt << '\n' << PP.getPredefines() << '\n';
+
+  // The plugins loaded with -load may register checkers, or change the ones
+  // they register when rebuilt.
+  for (unsigned I = 0, E = Plugins.size(); I != E; ++I) {
+    OS << "-load " << Plugins[I];
+    llvm::sys::fs::file_status Status;
+    if (!llvm::sys::fs::status(Plugins[I], Status))
+      OS << ' ' << Status.getSize() << ' '
+         << Status.getLastModificationTime().toEpochTime();
+    OS << '\n';
+  }
+  Hash.update(OS.str());
+  Hash.update(SM.getBuffer(SM.getMainFileID())->getBuffer());
+
+  // Hash the files read by the translation unit in a deterministic order.
+  std::vector<FileAndContents> Files(SM.fileinfo_begin(), SM.fileinfo_end());
+  std::sort(Files.begin(), Files.end(), compareFileNames);
+  for (unsigned I = 0, E = Files.size(); I != E; ++I) {
+    const FileEntry *File = Files[I].first;
+    Hash.update(StringRef(File->getName(), std::strlen(File->getName()) + 1));
+    if (const llvm::MemoryBuffer *Buffer = Files[I].second->getRawBuffer()) {
+      Hash.update(Buffer->getBuffer());
+    } else {
+      SmallString<32> Stamp;
+      llvm::raw_svector_ostream(Stamp) << File->getSize() << ' '
+                                       << File->getModificationTime();
+      Hash.update(Stamp.str());
+    }
+  }
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  llvm::MD5::stringifyResult(Result, Key);
+  return true;
+}
+
+/// \brief Prints the name identifying \p D in the summary cache.
+///
+/// Functions sharing a name, such as the instantiations of a member of a class
+/// template, share a summary, which is dropped whenever their code differs.
+///
+/// \returns true if \p D cannot be named across translation units.
+static bool printSummaryName(const Decl *D, const SourceManager &SM,
+                             raw_ostream &OS) {
+  const NamedDecl *ND = dyn_cast<NamedDecl>(D);
+  if (!ND || !ND->getDeclName())
+    return true;
+
+  // Other files may give the same name to other functions with internal
+  // linkage.
+  if (!ND->isExternallyVisible()) {
+    FileID FID = SM.getFileID(SM.getExpansionLoc(ND->getLocation()));
+    const FileEntry *File = SM.getFileEntryForID(FID);
+    if (!File)
+      return true;
+    OS << File->getName() << ' ';
+  }
+
+  if (const ObjCMethodDecl *MD = dyn_cast<ObjCMethodDecl>(ND))
+    OS << (MD->isInstanceMethod() ? '-' : '+');
+  ND->printQualifiedName(OS);
+
+  // Tell overloads apart.
+  if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(ND))
+    OS << ' ' << FD->getType().getAsString();
+  return false;
+}
+
+/// \brief Mixes the spelling of a token into \p Hash.
+static unsigned hashToken(StringRef Spelling, unsigned Hash) {
+  // Separate the tokens, so that "a b" and "ab" hash differently.
+  return llvm::HashString(Spelling, Hash) * 33 + ' ';
+}
+
+/// \brief Mixes the definition of the macro \p II into \p Hash, along with
+/// the definitions of the macros it names, unless they are in \p Seen.
+static unsigned hashMacro(const Preprocessor &PP, IdentifierInfo *II,
+                          unsigned Hash,
+                          SmallPtrSet<IdentifierInfo *, 8> &Seen) {
+  const MacroInfo *MI = PP.getMacroInfo(II);
+  if (!MI || !Seen.insert(II))
+    return Hash;
+
+  Hash = hashToken(II->getName(), Hash);
+  if (MI->isFunctionLike()) {
+    Hash = hashToken("(", Hash);
+    for (MacroInfo::arg_iterator I = MI->arg_begin(), E = MI->arg_end();
+         I != E; ++I)
+      Hash = hashToken((*I)->getName(), Hash);
+    Hash = hashToken(MI->isVariadic() ? "...)" : ")", Hash);
+  }
+  for (MacroInfo::tokens_iterator I = MI->tokens_begin(),
+                                  E = MI->tokens_end();
+       I != E; ++I) {
+    Hash = hashToken(PP.getSpelling(*I), Hash);
+    if (IdentifierInfo *TokII = I->getIdentifierInfo())
+      if (TokII->hasMacroDefinition())
+        Hash = hashMacro(PP, TokII, Hash, Seen);
+  }
+  return Hash;
+}
+
+/// \brief Hashes the tokens of the definition of \p D, along with the
+/// definitions of the macros they name, so that the hash only stays the same
+/// while the code the definition expands to does.
+///
+/// \returns true if the definition does not lie within one file.
+static bool hashDefinition(const Decl *D, const Preprocessor &PP,
+                           unsigned &Hash) {
+  SourceManager &SM = PP.getSourceManager();
+  SourceRange Range = D->getSourceRange();
+  std::pair<FileID, unsigned> Begin =
+      SM.getDecomposedLoc(SM.getExpansionLoc(Range.getBegin()));
+  std::pair<FileID, unsigned> End =
+      SM.getDecomposedLoc(SM.getExpansionRange(Range.getEnd()).second);
+  if (Begin.first != End.first || Begin.second > End.second)
+    return true;
+
+  bool Invalid = false;
+  StringRef Buffer = SM.getBufferData(Begin.first, &Invalid);
+  if (Invalid)
+    return true;
+
+  // End points at the start of the last token of the definition.
+  Lexer RawLex(SM.getLocForStartOfFile(Begin.first), PP.getLangOpts(),
+               Buffer.begin(), Buffer.begin() + Begin.second, Buffer.end());
+  SmallPtrSet<IdentifierInfo *, 8> SeenMacros;
+  Hash = 0;
+  Token Tok;
+  for (;;) {
+    RawLex.LexFromRawLexer(Tok);
+    unsigned Offset = SM.getFileOffset(Tok.getLocation());
+    if (Tok.is(tok::eof) || Offset > End.second)
+      return false;
+
+    Hash = hashToken(Buffer.substr(Offset, Tok.getLength()), Hash);
+    if (Tok.is(tok::raw_identifier)) {
+      IdentifierInfo *II = PP.LookUpIdentifierInfo(Tok);
+      if (II->hasMacroDefinition())
+        Hash = hashMacro(PP, II, Hash, SeenMacros);
+    }
+  }
+}
+
+void AnalysisConsumer::computePersistentSummaryKeys(ArrayRef<Decl *> Order) {
+  SourceManager &SM = Ctx->getSourceManager();
+  for (unsigned I = 0, E = Order.size(); I != E; ++I) {
+    Decl *D = Order[I];
+
+    // Other translation units only see the functions of the main file if they
+    // include it, which they hardly ever do.
+    if (SM.isInMainFile(SM.getExpansionLoc(D->getLocation())))
+      continue;
+
+    SmallString<128> Name;
+    llvm::raw_svector_ostream NameOS(Name);
+    unsigned CodeHash;
+    if (printSummaryName(D, SM, NameOS) ||
+        hashDefinition(D, PP, CodeHash))
       continue;
 
+    PersistentSummaryKey &Key = PersistentSummaryKeys[D];
+    Key.Name = NameOS.str();
+    Key.CodeHash = CodeHash;
+    Key.Flags = PersistentSummaries->lookup(Key.Name, CodeHash);
+  }
+}
+
+void AnalysisConsumer::recordPersistentSummaries(ArrayRef<Decl *> Order) {
+  for (unsigned I = 0, E = Order.size(); I != E; ++I) {
+    llvm::DenseMap<const Decl *, PersistentSummaryKey>::const_iterator K =
+        PersistentSummaryKeys.find(Order[I]);
+    if (K == PersistentSummaryKeys.end())
+      continue;
+
+    // Only record the decisions which depend on the function alone. Whether a
+    // call could be inlined within the budget of an analysis depends on the
+    // caller, and so on which translation unit got to the function first.
+    unsigned Flags = 0;
+    if (FunctionSummaries.shouldNeverInline(Order[I]))
+      Flags |= SummaryCache::SF_NotInlinable;
+
+    if (Flags & ~K->second.Flags)
+      PersistentSummaries->record(K->second.Name, K->second.CodeHash, Flags);
+  }
+}
+
+void AnalysisConsumer::HandleTopLevelFunctions(ArrayRef<Decl *> Order) {
+  // Skip the functions inlined into the previously processed functions. Use
+  // external Visited set to identify inlined functions.
+  SetOfConstDecls Visited;
+  SetOfConstDecls VisitedAsTopLevel;
+
+  // Do not check again whether the functions which other translation units
+  // found could never be inlined may be inlined. This saves building their
+  // CFGs, which only the check would need if they are not analyzed at top
+  // level.
+  for (unsigned I = 0, E = Order.size(); I != E; ++I) {
+    llvm::DenseMap<const Decl *, PersistentSummaryKey>::const_iterator K =
+        PersistentSummaryKeys.find(Order[I]);
+    if (K != PersistentSummaryKeys.end() &&
+        (K->second.Flags & SummaryCache::SF_NotInlinable)) {
+      FunctionSummaries.markShouldNeverInline(Order[I]);
+      ++NumNotInlinableFromSummaryCache;
+    }
+  }
+
+  for (unsigned I = 0, E = Order.size(); I != E; ++I) {
+    Decl *D = Order[I];
+
     // Skip the functions which have been processed already or previously
     // inlined.
     if (shouldSkipFunction(D, Visited, VisitedAsTopLevel))
@@ -510,6 +851,9 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
     }
     VisitedAsTopLevel.insert(D);
   }
+
+  if (PersistentSummaries)
+    recordPersistentSummaries(Order);
 }
 
 void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
@@ -518,6 +862,44 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   if (Diags.hasErrorOccurred() || Diags.hasFatalErrorOccurred())
     return;
 
+  // The reports written to files can be cached, along with the warnings, but
+  // not the paths of the text output.
+  StringRef PlistPath, HTMLDir;
+  switch (Opts->AnalysisDiagOpt) {
+  default:
+    break;
+  case PD_HTML:
+    HTMLDir = OutDir;
+    break;
+  case PD_PLIST:
+  case PD_PLIST_MULTI_FILE:
+    PlistPath = OutDir;
+    break;
+  case PD_PLIST_HTML:
+    PlistPath = OutDir;
+    HTMLDir = llvm::sys::path::parent_path(OutDir);
+    break;
+  }
+
+  OwningPtr<ResultCache> Results;
+  SmallString<32> Key;
+  if (!Opts->ResultCacheDir.empty() && !OutDir.empty() &&
+      (!PlistPath.empty() || !HTMLDir.empty()) && computeResultCacheKey(Key)) {
+    Results.reset(new ResultCache(Opts->ResultCacheDir, Key));
+
+    // Write the reports of the same analysis again instead of analyzing. The
+    // consumers write their (empty) files first, so that they get replaced.
+    if (Results->load()) {
+      Mgr.reset(NULL);
+      if (Results->replay(PlistPath, HTMLDir, Diags))
+        Diags.Report(diag::warn_analyzer_result_cache_replay)
+          << Opts->ResultCacheDir;
+      ++NumTranslationUnitsReplayed;
+      return;
+    }
+    ClangDiags->recordDiagsIn(Results.get());
+  }
+
   {
     if (TUTotalTimer) TUTotalTimer->startTimer();
 
@@ -558,16 +940,39 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   // FIXME: This should be replaced with something that doesn't rely on
   // side-effects in PathDiagnosticConsumer's destructor. This is required when
   // used with option -disable-free.
+  PathDiagnosticConsumer::FilesMade FilesMade;
+  Mgr->FlushDiagnostics(&FilesMade);
   Mgr.reset(NULL);
 
+  // Cache the reports, including the files written for no report, as
+  // unchanged translation units usually have none.
+  if (Results) {
+    std::vector<std::string> HTMLFiles;
+    for (PathDiagnosticConsumer::FilesMade::iterator I = FilesMade.begin(),
+                                                     E = FilesMade.end();
+         I != E; ++I)
+      for (unsigned F = 0, FE = I->files.size(); F != FE; ++F)
+        HTMLFiles.push_back(I->files[F].second);
+    Results->store(PlistPath, HTMLDir, HTMLFiles);
+  }
+
   if (TUTotalTimer) TUTotalTimer->stopTimer();
 
-  // Count how many basic blocks we have not covered.
+  // The store is only a cache, so failing to update it is not an error.
+  if (PersistentSummaries)
+    PersistentSummaries->save();
+
+  // Count how many basic blocks we have not covered, and how much work it
+  // took to cover the others.
   NumBlocksInAnalyzedFunctions = FunctionSummaries.getTotalNumBasicBlocks();
+  unsigned NumVisitedBlocks =
+    FunctionSummaries.getTotalNumVisitedBasicBlocks();
   if (NumBlocksInAnalyzedFunctions > 0)
     PercentReachableBlocks =
-      (FunctionSummaries.getTotalNumVisitedBasicBlocks() * 100) /
-        NumBlocksInAnalyzedFunctions;
+      (NumVisitedBlocks * 100) / NumBlocksInAnalyzedFunctions;
+  if (NumStepsInAnalyzedFunctions > 0)
+    VisitedBlocksPerKiloStep =
+      (uint64_t(NumVisitedBlocks) * 1000) / NumStepsInAnalyzedFunctions;
 
 }
 
@@ -662,6 +1067,7 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
   // Execute the worklist algorithm.
   Eng.ExecuteWorkList(Mgr->getAnalysisDeclContextManager().getStackFrame(D),
                       Mgr->options.getMaxNodesPerTopLevelFunction());
+  NumStepsInAnalyzedFunctions += Eng.getCoreEngine().getNumStepsTaken();
 
   // Release the auditor (if any) so that it doesn't monitor the graph
   // created BugReporter.
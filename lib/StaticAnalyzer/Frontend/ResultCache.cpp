@@ -0,0 +1,278 @@
+//===--- ResultCache.cpp - Reports of previously analyzed TUs -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements ResultCache.
+//
+// An entry starts with a signature line. Each file follows, as a line holding
+// its kind ('P' for the plist file, 'H' for an HTML file, 'D' for the
+// diagnostics), its size and its name, and then its contents.
+//
+// The diagnostics are a sequence of lines holding the level ('W' for a
+// warning, 'N' for a note), the offset of the location in its file, the
+// length of the message, the number of ranges, the offsets of the begin and
+// end of every range and the name of the file, each followed by the message
+// and a newline.  The files of the translation unit are the same whenever an
+// entry is used, so offsets within them identify the same locations.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ResultCache.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+using namespace ento;
+
+/// \brief The signature of an entry, which changes with its format.
+static const char * const ResultSignature = "CLANG-ANALYZER-RESULTS 2";
+
+ResultCache::ResultCache(StringRef Dir, StringRef Key)
+  : DiagnosticsIncomplete(false) {
+  SmallString<128> P(Dir);
+  llvm::sys::path::append(P, Key);
+  Path = P.str();
+}
+
+bool ResultCache::load() {
+  if (llvm::MemoryBuffer::getFile(Path, Entry))
+    return false;
+
+  StringRef Signature = Entry->getBuffer().split('\n').first;
+  if (Signature != ResultSignature) {
+    Entry.reset();
+    return false;
+  }
+  return true;
+}
+
+/// \brief Writes \p Contents to the file \p Path.
+///
+/// \returns true on error.
+static bool writeFile(StringRef Path, StringRef Contents) {
+  std::string ErrorInfo;
+  llvm::raw_fd_ostream Out(Path.str().c_str(), ErrorInfo,
+                           llvm::sys::fs::F_Binary);
+  if (!ErrorInfo.empty())
+    return true;
+  Out << Contents;
+  Out.close();
+  return Out.has_error();
+}
+
+/// \brief Emits the diagnostics stored in an entry through \p Diags.
+///
+/// \returns true if they are malformed or refer to files which are not part
+/// of the translation unit.
+static bool replayDiagnostics(StringRef Rest, DiagnosticsEngine &Diags) {
+  SourceManager &SM = Diags.getSourceManager();
+  while (!Rest.empty()) {
+    StringRef Header, Field;
+    llvm::tie(Header, Rest) = Rest.split('\n');
+
+    unsigned Fields[3];
+    StringRef Level;
+    llvm::tie(Level, Header) = Header.split(' ');
+    for (unsigned I = 0; I != 3; ++I) {
+      llvm::tie(Field, Header) = Header.split(' ');
+      if (Field.getAsInteger(10, Fields[I]))
+        return true;
+    }
+    unsigned Offset = Fields[0], Length = Fields[1], NumRanges = Fields[2];
+
+    SmallVector<unsigned, 4> RangeOffsets;
+    for (unsigned I = 0; I != 2 * NumRanges; ++I) {
+      unsigned RangeOffset;
+      llvm::tie(Field, Header) = Header.split(' ');
+      if (Field.getAsInteger(10, RangeOffset))
+        return true;
+      RangeOffsets.push_back(RangeOffset);
+    }
+
+    // Header is left with the name of the file.
+    const FileEntry *File = SM.getFileManager().getFile(Header);
+    if (!File || Length >= Rest.size() || Rest[Length] != '\n')
+      return true;
+    StringRef Message = Rest.substr(0, Length);
+    Rest = Rest.substr(Length + 1);
+
+    FileID FID = SM.translateFile(File);
+    if (FID.isInvalid() || Offset > File->getSize())
+      return true;
+    SourceLocation Start = SM.getLocForStartOfFile(FID);
+
+    DiagnosticsEngine::Level DiagLevel;
+    if (Level == "W")
+      DiagLevel = DiagnosticsEngine::Warning;
+    else if (Level == "N")
+      DiagLevel = DiagnosticsEngine::Note;
+    else
+      return true;
+
+    DiagnosticBuilder DiagBuilder =
+        Diags.Report(Start.getLocWithOffset(Offset),
+                     Diags.getCustomDiagID(DiagLevel, Message));
+    for (unsigned I = 0, E = RangeOffsets.size(); I != E; I += 2) {
+      if (RangeOffsets[I + 1] > File->getSize())
+        return true;
+      DiagBuilder << SourceRange(Start.getLocWithOffset(RangeOffsets[I]),
+                                 Start.getLocWithOffset(RangeOffsets[I + 1]));
+    }
+  }
+  return false;
+}
+
+bool ResultCache::replay(StringRef PlistPath, StringRef HTMLDir,
+                         DiagnosticsEngine &Diags) const {
+  assert(Entry && "No entry loaded");
+  StringRef Rest = Entry->getBuffer().split('\n').second;
+
+  if (!HTMLDir.empty()) {
+    bool Existed;
+    if (llvm::sys::fs::create_directories(HTMLDir, Existed))
+      return true;
+  }
+
+  while (!Rest.empty()) {
+    StringRef Header, Kind, Size, Name;
+    llvm::tie(Header, Rest) = Rest.split('\n');
+    llvm::tie(Kind, Header) = Header.split(' ');
+    llvm::tie(Size, Name) = Header.split(' ');
+
+    size_t Length;
+    if (Size.getAsInteger(10, Length) || Length > Rest.size())
+      return true;
+    StringRef Contents = Rest.substr(0, Length);
+    Rest = Rest.substr(Length);
+
+    if (Kind == "P") {
+      if (!PlistPath.empty() && writeFile(PlistPath, Contents))
+        return true;
+    } else if (Kind == "H") {
+      if (HTMLDir.empty())
+        continue;
+      SmallString<128> HTMLPath(HTMLDir);
+      llvm::sys::path::append(HTMLPath, Name);
+      if (writeFile(HTMLPath, Contents))
+        return true;
+    } else if (Kind == "D") {
+      if (replayDiagnostics(Contents, Diags))
+        return true;
+    } else {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// \brief Finds the file and the offset within it of \p Loc.
+///
+/// \returns true if \p Loc is not the location of a file.
+static bool getFileOffset(const SourceManager &SM, SourceLocation Loc,
+                          FileID &FID, unsigned &Offset) {
+  if (Loc.isInvalid() || !Loc.isFileID())
+    return true;
+  llvm::tie(FID, Offset) = SM.getDecomposedLoc(Loc);
+  return !SM.getFileEntryForID(FID);
+}
+
+void ResultCache::recordDiagnostic(const SourceManager &SM,
+                                   DiagnosticsEngine::Level Level,
+                                   StringRef Message, SourceLocation Loc,
+                                   ArrayRef<SourceRange> Ranges) {
+  FileID FID;
+  unsigned Offset;
+  if ((Level != DiagnosticsEngine::Warning &&
+       Level != DiagnosticsEngine::Note) ||
+      getFileOffset(SM, Loc, FID, Offset)) {
+    DiagnosticsIncomplete = true;
+    return;
+  }
+
+  // Only the ranges in the file of the location are highlighted.
+  SmallVector<unsigned, 4> RangeOffsets;
+  for (unsigned I = 0, E = Ranges.size(); I != E; ++I) {
+    FileID BeginFID, EndFID;
+    unsigned Begin, End;
+    if (getFileOffset(SM, Ranges[I].getBegin(), BeginFID, Begin) ||
+        getFileOffset(SM, Ranges[I].getEnd(), EndFID, End)) {
+      DiagnosticsIncomplete = true;
+      return;
+    }
+    if (BeginFID != FID || EndFID != FID)
+      continue;
+    RangeOffsets.push_back(Begin);
+    RangeOffsets.push_back(End);
+  }
+
+  llvm::raw_string_ostream OS(Diagnostics);
+  OS << (Level == DiagnosticsEngine::Warning ? 'W' : 'N') << ' ' << Offset
+     << ' ' << Message.size() << ' ' << RangeOffsets.size() / 2;
+  for (unsigned I = 0, E = RangeOffsets.size(); I != E; ++I)
+    OS << ' ' << RangeOffsets[I];
+  OS << ' ' << SM.getFileEntryForID(FID)->getName() << '\n' << Message
+     << '\n';
+}
+
+/// \brief Appends the file \p Path to an entry.
+///
+/// \returns true on error.
+static bool appendFile(raw_ostream &Out, char Kind, StringRef Name,
+                       StringRef Path) {
+  OwningPtr<llvm::MemoryBuffer> Buffer;
+  if (llvm::MemoryBuffer::getFile(Path, Buffer))
+    return true;
+  Out << Kind << ' ' << Buffer->getBufferSize() << ' ' << Name << '\n'
+      << Buffer->getBuffer();
+  return false;
+}
+
+bool ResultCache::store(StringRef PlistPath, StringRef HTMLDir,
+                        ArrayRef<std::string> HTMLFiles) const {
+  // Replaying the entry would drop the diagnostics which were not recorded.
+  if (DiagnosticsIncomplete)
+    return true;
+
+  if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(Path)))
+    return true;
+
+  // Write the entry to a temporary file first, so that analyses running in
+  // parallel never see a partial entry.
+  SmallString<128> TmpPath;
+  int TmpFD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", TmpFD, TmpPath))
+    return true;
+
+  bool Failed = false;
+  {
+    llvm::raw_fd_ostream Out(TmpFD, true);
+    Out << ResultSignature << '\n';
+    if (!PlistPath.empty())
+      Failed |= appendFile(Out, 'P', "-", PlistPath);
+    for (unsigned I = 0, E = HTMLFiles.size(); I != E && !Failed; ++I) {
+      SmallString<128> HTMLPath(HTMLDir);
+      llvm::sys::path::append(HTMLPath, HTMLFiles[I]);
+      Failed |= appendFile(Out, 'H', HTMLFiles[I], HTMLPath);
+    }
+    if (!Diagnostics.empty())
+      Out << "D " << Diagnostics.size() << " -\n" << Diagnostics;
+    Out.close();
+    Failed |= Out.has_error();
+  }
+
+  bool Existed;
+  if (Failed || llvm::sys::fs::rename(TmpPath.str(), Path)) {
+    llvm::sys::fs::remove(TmpPath.str(), Existed);
+    return true;
+  }
+  return false;
+}
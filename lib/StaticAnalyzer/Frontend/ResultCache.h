@@ -0,0 +1,101 @@
+//===--- ResultCache.h - Reports of previously analyzed TUs -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines ResultCache, which keeps the report files and warnings
+// written by the analysis of a translation unit so that they can be written
+// again when the same translation unit is analyzed with the same options.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_GR_RESULTCACHE_H
+#define LLVM_CLANG_GR_RESULTCACHE_H
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <string>
+
+namespace clang {
+
+class SourceManager;
+
+namespace ento {
+
+/// \brief The entry of a cache of analysis results, holding the report files
+/// and the warnings written by one analysis.
+///
+/// Entries are identified by a key which must cover everything the results
+/// depend on: the contents of the files of the translation unit and the
+/// analyzer configuration. Each entry is a single file, which holds a plist
+/// file, any number of HTML files and the warnings and notes emitted.
+class ResultCache {
+  /// \brief The path of the file holding the entry.
+  std::string Path;
+
+  /// \brief The contents of the entry, once loaded.
+  OwningPtr<llvm::MemoryBuffer> Entry;
+
+  /// \brief The diagnostics recorded by recordDiagnostic(), in the format of
+  /// the entry.
+  std::string Diagnostics;
+
+  /// \brief True if a diagnostic could not be recorded, in which case no
+  /// entry is stored.
+  bool DiagnosticsIncomplete;
+
+public:
+  /// \brief Uses the entry with the given key in directory \p Dir.
+  ResultCache(StringRef Dir, StringRef Key);
+
+  /// \brief Reads the entry.
+  ///
+  /// \returns true if there is one.
+  bool load();
+
+  /// \brief Writes the report files of the loaded entry again, and emits its
+  /// diagnostics again.
+  ///
+  /// \param PlistPath The path the plist file is written to, or empty if it
+  /// is not wanted.
+  /// \param HTMLDir The directory the HTML files are written to, or empty if
+  /// they are not wanted.
+  /// \param Diags The engine the diagnostics are emitted through. Their
+  /// locations are found in the files of its source manager.
+  ///
+  /// \returns true on error.
+  bool replay(StringRef PlistPath, StringRef HTMLDir,
+              DiagnosticsEngine &Diags) const;
+
+  /// \brief Records a diagnostic emitted by the analysis, to be stored in the
+  /// entry.
+  ///
+  /// Diagnostics located in macro expansions or in buffers which are not
+  /// files cannot be recorded, and keep the entry from being stored.
+  void recordDiagnostic(const SourceManager &SM,
+                        DiagnosticsEngine::Level Level, StringRef Message,
+                        SourceLocation Loc, ArrayRef<SourceRange> Ranges);
+
+  /// \brief Stores the given report files and the recorded diagnostics as
+  /// the entry.
+  ///
+  /// \param PlistPath The path of the plist file written by the analysis, or
+  /// empty if there is none.
+  /// \param HTMLDir The directory of the HTML files.
+  /// \param HTMLFiles The names of the HTML files written by the analysis.
+  ///
+  /// \returns true on error.
+  bool store(StringRef PlistPath, StringRef HTMLDir,
+             ArrayRef<std::string> HTMLFiles) const;
+};
+
+} // end namespace ento
+} // end namespace clang
+
+#endif
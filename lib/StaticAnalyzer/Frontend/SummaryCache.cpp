@@ -0,0 +1,104 @@
+//===--- SummaryCache.cpp - Function summaries kept across TUs ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements SummaryCache.
+//
+// The store is a KeyedLineStore with one section per configuration. The
+// header of a section holds a signature and the hash of the configuration;
+// each of its entries holds the code hash (in hexadecimal), the flags and the
+// name of one function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SummaryCache.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+using namespace ento;
+
+/// \brief The name of the file holding the store.
+static const char * const SummaryFileName = "analyzer-summaries";
+
+/// \brief The signature of the store, which changes with its format.
+static const char * const SummarySignature = "CLANG-ANALYZER-SUMMARIES 3";
+
+static std::string getStorePath(StringRef Dir) {
+  SmallString<128> P(Dir);
+  llvm::sys::path::append(P, SummaryFileName);
+  return P.str();
+}
+
+static std::string getStoreHeader(unsigned ConfigHash) {
+  SmallString<64> Header;
+  llvm::raw_svector_ostream(Header) << SummarySignature << ' ' << ConfigHash;
+  return Header.str();
+}
+
+/// \brief Reads the fields of a summary.
+///
+/// \returns true if they are malformed.
+static bool parseSummary(StringRef Fields, SummaryCache::Summary &S) {
+  StringRef Hash, Flags;
+  llvm::tie(Hash, Flags) = Fields.split(' ');
+  return Hash.getAsInteger(16, S.CodeHash) || Flags.getAsInteger(10, S.Flags);
+}
+
+static void printSummary(const SummaryCache::Summary &S, std::string &Fields) {
+  llvm::raw_string_ostream OS(Fields);
+  OS.write_hex(S.CodeHash);
+  OS << ' ' << S.Flags;
+}
+
+/// \brief Keeps the flags already stored for the same code.
+static void mergeSummaries(std::string &Old, StringRef New) {
+  SummaryCache::Summary OldS, NewS;
+  if (parseSummary(New, NewS))
+    return;
+  if (!parseSummary(Old, OldS) && OldS.CodeHash == NewS.CodeHash)
+    NewS.Flags |= OldS.Flags;
+  Old.clear();
+  printSummary(NewS, Old);
+}
+
+SummaryCache::SummaryCache(StringRef Dir, unsigned ConfigHash)
+  : Store(getStorePath(Dir), getStoreHeader(ConfigHash), 2) {}
+
+void SummaryCache::load() {
+  KeyedLineStore::EntryMap Entries;
+  Store.read(Entries);
+  for (KeyedLineStore::EntryMap::iterator I = Entries.begin(),
+                                          E = Entries.end();
+       I != E; ++I) {
+    Summary S;
+    if (!parseSummary(I->getValue(), S))
+      Loaded[I->getKey()] = S;
+  }
+}
+
+unsigned SummaryCache::lookup(StringRef Name, unsigned CodeHash) const {
+  SummaryMap::const_iterator I = Loaded.find(Name);
+  if (I == Loaded.end() || I->getValue().CodeHash != CodeHash)
+    return 0;
+  return I->getValue().Flags;
+}
+
+void SummaryCache::record(StringRef Name, unsigned CodeHash, unsigned Flags) {
+  Summary S = { CodeHash, Flags };
+  std::string &Fields = Recorded[Name];
+  Fields.clear();
+  printSummary(S, Fields);
+}
+
+bool SummaryCache::save() {
+  bool Failed = Store.update(Recorded, mergeSummaries);
+  Recorded.clear();
+  return Failed;
+}
@@ -0,0 +1,81 @@
+//===--- SummaryCache.h - Function summaries kept across TUs ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines SummaryCache, which keeps function summaries in a file so
+// that they can be reused by the analysis of other translation units.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_GR_SUMMARYCACHE_H
+#define LLVM_CLANG_GR_SUMMARYCACHE_H
+
+#include "clang/Basic/KeyedLineStore.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+
+namespace clang {
+namespace ento {
+
+/// \brief A store of function summaries which persists across translation
+/// units.
+///
+/// Functions are identified by their qualified names and types. Every summary
+/// records a hash of the tokens of the function's definition, so that it is
+/// only used while that code is unchanged. Every analyzer configuration has
+/// its own summaries, which the analyses with other configurations keep.
+class SummaryCache {
+public:
+  enum SummaryFlags {
+    /// \brief The function may not be inlined into any caller, whatever the
+    /// budget of the analysis.
+    SF_NotInlinable = 1 << 0
+  };
+
+  struct Summary {
+    unsigned CodeHash;
+    unsigned Flags;
+  };
+
+private:
+  typedef llvm::StringMap<Summary> SummaryMap;
+
+  /// \brief The file holding the store.
+  KeyedLineStore Store;
+
+  /// \brief The summaries read from the file.
+  SummaryMap Loaded;
+
+  /// \brief The summaries recorded by this translation unit.
+  KeyedLineStore::EntryMap Recorded;
+
+public:
+  /// \brief Uses the store in directory \p Dir for analyses with the
+  /// configuration hashed to \p ConfigHash.
+  SummaryCache(StringRef Dir, unsigned ConfigHash);
+
+  /// \brief Reads the store.
+  void load();
+
+  /// \brief Returns the flags stored for the function with the given name, or
+  /// 0 if there is no summary of the same code.
+  unsigned lookup(StringRef Name, unsigned CodeHash) const;
+
+  /// \brief Records a summary, to be written by save().
+  void record(StringRef Name, unsigned CodeHash, unsigned Flags);
+
+  /// \brief Merges the recorded summaries into the store.
+  ///
+  /// \returns true if the store could not be written.
+  bool save();
+};
+
+} // end namespace ento
+} // end namespace clang
+
+#endif
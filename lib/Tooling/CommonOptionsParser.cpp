@@ -25,6 +25,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/CommandLine.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Tooling.h"
 
@@ -51,6 +52,9 @@ const char *const CommonOptionsParser::HelpMessage =
     "\tworking directory. \"./\" prefixes in the relative files will be\n"
     "\tautomatically removed, but the rest of a relative path must be a\n"
     "\tsuffix of a path in the compile command database.\n"
+    "\n"
+    "-j <N> processes up to N source files concurrently. -j 0 uses one\n"
+    "\tthread per hardware thread of the host.\n"
     "\n";
 
 CommonOptionsParser::CommonOptionsParser(int &argc, const char **argv,
@@ -61,10 +65,15 @@ CommonOptionsParser::CommonOptionsParser(int &argc, const char **argv,
   static cl::list<std::string> SourcePaths(
       cl::Positional, cl::desc("<source0> [... <sourceN>]"), cl::OneOrMore);
 
+  static cl::opt<unsigned> Jobs(
+      "j", cl::desc("Number of source files to process concurrently"),
+      cl::init(1));
+
   Compilations.reset(FixedCompilationDatabase::loadFromCommandLine(argc,
                                                                    argv));
   cl::ParseCommandLineOptions(argc, argv, Overview);
   SourcePathList = SourcePaths;
+  NumThreads = Jobs == 0 ? clang::getNumHardwareThreads() : unsigned(Jobs);
   if (!Compilations) {
     std::string ErrorMessage;
     if (!BuildPath.empty()) {
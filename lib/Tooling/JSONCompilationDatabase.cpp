@@ -16,8 +16,12 @@
 #include "clang/Tooling/CompilationDatabasePluginRegistry.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <cstring>
 
 namespace clang {
 namespace tooling {
@@ -117,6 +121,239 @@ std::vector<std::string> unescapeCommandLine(
   return parser.parse();
 }
 
+/// \brief The attributes of a compilation database entry, as they appear in
+/// the database (that is, still escaped).
+struct RawEntry {
+  RawEntry() : HasDirectory(false), HasCommand(false), HasFile(false) {}
+
+  StringRef Directory;
+  StringRef Command;
+  StringRef File;
+  bool HasDirectory;
+  bool HasCommand;
+  bool HasFile;
+};
+
+/// \brief A scanner for the subset of JSON used by compilation databases: an
+/// array of objects whose values are all strings.
+///
+/// The scanner does not allocate; strings are returned as references into
+/// the database and only unescaped on demand.
+class DatabaseScanner {
+public:
+  DatabaseScanner(StringRef Input, size_t Position = 0)
+      : Input(Input), Position(Position) {}
+
+  size_t getPosition() const { return Position; }
+
+  /// \brief Returns true if only whitespace is left in the input.
+  bool scanToEndOfInput(std::string &ErrorMessage) {
+    skipWhitespace();
+    if (Position == Input.size())
+      return true;
+    setError("Expected end of input", ErrorMessage);
+    return false;
+  }
+
+  /// \brief Scans the '[' that starts the list of entries.
+  bool scanArrayStart(std::string &ErrorMessage) {
+    skipWhitespace();
+    if (!consume('[')) {
+      ErrorMessage = "Expected array.";
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Returns true if the next entry starts at the current position,
+  /// false if we reached the ']' that ends the list of entries.
+  ///
+  /// \param First Whether no entry has been scanned yet.
+  bool scanToNextEntry(bool First, bool &Failed, std::string &ErrorMessage) {
+    skipWhitespace();
+    if (consume(']'))
+      return false;
+    if (!First && !consume(',')) {
+      setError("Expected ',' or ']'", ErrorMessage);
+      Failed = true;
+      return false;
+    }
+    skipWhitespace();
+    return true;
+  }
+
+  /// \brief Scans the entry object starting at the current position.
+  bool scanEntry(RawEntry &Entry, std::string &ErrorMessage) {
+    if (!consume('{')) {
+      ErrorMessage = "Expected object.";
+      return false;
+    }
+    skipWhitespace();
+    if (consume('}'))
+      return true;
+    do {
+      skipWhitespace();
+      StringRef Key;
+      if (!scanString(Key)) {
+        ErrorMessage = "Expected strings as key.";
+        return false;
+      }
+      skipWhitespace();
+      if (!consume(':')) {
+        setError("Expected ':'", ErrorMessage);
+        return false;
+      }
+      skipWhitespace();
+      StringRef Value;
+      if (!scanString(Value)) {
+        ErrorMessage = "Expected string as value.";
+        return false;
+      }
+      if (Key == "directory") {
+        Entry.Directory = Value;
+        Entry.HasDirectory = true;
+      } else if (Key == "command") {
+        Entry.Command = Value;
+        Entry.HasCommand = true;
+      } else if (Key == "file") {
+        Entry.File = Value;
+        Entry.HasFile = true;
+      } else {
+        ErrorMessage = ("Unknown key: \"" + Key + "\"").str();
+        return false;
+      }
+      skipWhitespace();
+    } while (consume(','));
+    if (!consume('}')) {
+      setError("Expected ',' or '}'", ErrorMessage);
+      return false;
+    }
+    return true;
+  }
+
+private:
+  void skipWhitespace() {
+    while (Position != Input.size() &&
+           (Input[Position] == ' ' || Input[Position] == '\t' ||
+            Input[Position] == '\n' || Input[Position] == '\r'))
+      ++Position;
+  }
+
+  bool consume(char C) {
+    if (Position == Input.size() || Input[Position] != C)
+      return false;
+    ++Position;
+    return true;
+  }
+
+  /// \brief Scans a double-quoted string and returns its escaped contents.
+  bool scanString(StringRef &Contents) {
+    if (!consume('"'))
+      return false;
+    size_t Start = Position;
+    while (Position != Input.size() && Input[Position] != '"') {
+      if (Input[Position] == '\\' && Position + 1 != Input.size())
+        ++Position;
+      ++Position;
+    }
+    if (Position == Input.size())
+      return false;
+    Contents = Input.slice(Start, Position);
+    ++Position;
+    return true;
+  }
+
+  void setError(StringRef Expected, std::string &ErrorMessage) {
+    ErrorMessage = ("Error while parsing JSON: " + Expected + " at offset " +
+                    Twine(Position) + ".").str();
+  }
+
+  StringRef Input;
+  size_t Position;
+};
+
+/// \brief Appends the UTF-8 encoding of \p CodePoint to \p Result.
+void appendUTF8(unsigned CodePoint, std::string &Result) {
+  if (CodePoint < 0x80) {
+    Result.push_back(CodePoint);
+  } else if (CodePoint < 0x800) {
+    Result.push_back(0xC0 | (CodePoint >> 6));
+    Result.push_back(0x80 | (CodePoint & 0x3F));
+  } else if (CodePoint < 0x10000) {
+    Result.push_back(0xE0 | (CodePoint >> 12));
+    Result.push_back(0x80 | ((CodePoint >> 6) & 0x3F));
+    Result.push_back(0x80 | (CodePoint & 0x3F));
+  } else {
+    Result.push_back(0xF0 | (CodePoint >> 18));
+    Result.push_back(0x80 | ((CodePoint >> 12) & 0x3F));
+    Result.push_back(0x80 | ((CodePoint >> 6) & 0x3F));
+    Result.push_back(0x80 | (CodePoint & 0x3F));
+  }
+}
+
+/// \brief Decodes the \uXXXX escape at the start of \p Escaped.
+bool decodeUnicodeEscape(StringRef Escaped, unsigned &CodeUnit) {
+  return Escaped.size() >= 6 && Escaped.startswith("\\u") &&
+         !Escaped.substr(2, 4).getAsInteger(16, CodeUnit);
+}
+
+/// \brief Returns the value of a JSON string given its escaped contents.
+std::string unescapeJSONString(StringRef Escaped) {
+  if (Escaped.find('\\') == StringRef::npos)
+    return Escaped.str();
+  std::string Result;
+  Result.reserve(Escaped.size());
+  for (size_t I = 0, E = Escaped.size(); I != E; ++I) {
+    if (Escaped[I] != '\\' || I + 1 == E) {
+      Result.push_back(Escaped[I]);
+      continue;
+    }
+    switch (Escaped[I + 1]) {
+    case 'b': Result.push_back('\b'); break;
+    case 'f': Result.push_back('\f'); break;
+    case 'n': Result.push_back('\n'); break;
+    case 'r': Result.push_back('\r'); break;
+    case 't': Result.push_back('\t'); break;
+    case 'u': {
+      unsigned CodePoint;
+      if (!decodeUnicodeEscape(Escaped.substr(I), CodePoint)) {
+        Result.push_back('u');
+        break;
+      }
+      I += 4;
+      unsigned Low;
+      if (CodePoint >= 0xD800 && CodePoint < 0xDC00 &&
+          decodeUnicodeEscape(Escaped.substr(I + 2), Low) &&
+          Low >= 0xDC00 && Low < 0xE000) {
+        CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+        I += 6;
+      }
+      appendUTF8(CodePoint, Result);
+      break;
+    }
+    default:
+      // '"', '\\' and '/' stand for themselves.
+      Result.push_back(Escaped[I + 1]);
+      break;
+    }
+    ++I;
+  }
+  return Result;
+}
+
+/// \brief Returns the native, absolute path of the file of \p Entry.
+void getNativeFilePath(const RawEntry &Entry,
+                       SmallVectorImpl<char> &NativeFilePath) {
+  std::string FileName = unescapeJSONString(Entry.File);
+  if (llvm::sys::path::is_relative(FileName)) {
+    SmallString<128> AbsolutePath(unescapeJSONString(Entry.Directory));
+    llvm::sys::path::append(AbsolutePath, FileName);
+    llvm::sys::path::native(AbsolutePath.str(), NativeFilePath);
+  } else {
+    llvm::sys::path::native(FileName, NativeFilePath);
+  }
+}
+
 class JSONCompilationDatabasePlugin : public CompilationDatabasePlugin {
   virtual CompilationDatabase *loadFromDirectory(
       StringRef Directory, std::string &ErrorMessage) {
@@ -141,28 +378,59 @@ X("json-compilation-database", "Reads JSON formatted compilation databases");
 // and thus register the JSONCompilationDatabasePlugin.
 volatile int JSONAnchorSource = 0;
 
+/// \brief Identifies (the version of) the format of index files.
+static const char IndexFileMagic[] = "CDBIDX01";
+
 JSONCompilationDatabase *
 JSONCompilationDatabase::loadFromFile(StringRef FilePath,
-                                      std::string &ErrorMessage) {
+                                      std::string &ErrorMessage,
+                                      bool UseIndexFile) {
+  llvm::sys::fs::file_status Status;
+  uint64_t DatabaseSize = 0;
+  uint64_t DatabaseModTime = 0;
+  if (UseIndexFile && !llvm::sys::fs::status(FilePath, Status)) {
+    DatabaseSize = Status.getSize();
+    DatabaseModTime = Status.getLastModificationTime().toEpochTime();
+  } else {
+    UseIndexFile = false;
+  }
+
+  // Entries are decoded straight out of the buffer, which therefore does not
+  // need a null terminator; this lets large databases be memory mapped.
   OwningPtr<llvm::MemoryBuffer> DatabaseBuffer;
   llvm::error_code Result =
-    llvm::MemoryBuffer::getFile(FilePath, DatabaseBuffer);
+    llvm::MemoryBuffer::getFile(FilePath, DatabaseBuffer, -1,
+                                /*RequiresNullTerminator=*/false);
   if (Result != 0) {
     ErrorMessage = "Error while opening JSON database: " + Result.message();
     return NULL;
   }
   OwningPtr<JSONCompilationDatabase> Database(
     new JSONCompilationDatabase(DatabaseBuffer.take()));
+  if (!UseIndexFile) {
+    if (!Database->parse(ErrorMessage))
+      return NULL;
+    return Database.take();
+  }
+
+  std::string IndexPath = getIndexFilePath(FilePath);
+  if (Database->readIndex(IndexPath, DatabaseSize, DatabaseModTime))
+    return Database.take();
   if (!Database->parse(ErrorMessage))
     return NULL;
+  Database->writeIndex(IndexPath, DatabaseSize, DatabaseModTime);
   return Database.take();
 }
 
+std::string JSONCompilationDatabase::getIndexFilePath(StringRef FilePath) {
+  return (FilePath + ".idx").str();
+}
+
 JSONCompilationDatabase *
 JSONCompilationDatabase::loadFromBuffer(StringRef DatabaseString,
                                         std::string &ErrorMessage) {
   OwningPtr<llvm::MemoryBuffer> DatabaseBuffer(
-      llvm::MemoryBuffer::getMemBuffer(DatabaseString));
+      llvm::MemoryBuffer::getMemBuffer(DatabaseString, "", false));
   OwningPtr<JSONCompilationDatabase> Database(
       new JSONCompilationDatabase(DatabaseBuffer.take()));
   if (!Database->parse(ErrorMessage))
@@ -180,7 +448,7 @@ JSONCompilationDatabase::getCompileCommands(StringRef FilePath) const {
   StringRef Match = MatchTrie.findEquivalent(NativeFilePath.str(), ES);
   if (Match.empty())
     return std::vector<CompileCommand>();
-  llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
+  llvm::StringMap< std::vector<unsigned> >::const_iterator
     CommandsRefI = IndexByFile.find(Match);
   if (CommandsRefI == IndexByFile.end())
     return std::vector<CompileCommand>();
@@ -193,9 +461,9 @@ std::vector<std::string>
 JSONCompilationDatabase::getAllFiles() const {
   std::vector<std::string> Result;
 
-  llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
+  llvm::StringMap< std::vector<unsigned> >::const_iterator
     CommandsRefI = IndexByFile.begin();
-  const llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
+  const llvm::StringMap< std::vector<unsigned> >::const_iterator
     CommandsRefEnd = IndexByFile.end();
   for (; CommandsRefI != CommandsRefEnd; ++CommandsRefI) {
     Result.push_back(CommandsRefI->first().str());
@@ -207,7 +475,7 @@ JSONCompilationDatabase::getAllFiles() const {
 std::vector<CompileCommand>
 JSONCompilationDatabase::getAllCompileCommands() const {
   std::vector<CompileCommand> Commands;
-  for (llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
+  for (llvm::StringMap< std::vector<unsigned> >::const_iterator
         CommandsRefI = IndexByFile.begin(), CommandsRefEnd = IndexByFile.end();
       CommandsRefI != CommandsRefEnd; ++CommandsRefI) {
     getCommands(CommandsRefI->getValue(), Commands);
@@ -216,108 +484,176 @@ JSONCompilationDatabase::getAllCompileCommands() const {
 }
 
 void JSONCompilationDatabase::getCommands(
-                                  ArrayRef<CompileCommandRef> CommandsRef,
+                                  ArrayRef<unsigned> EntryOffsets,
                                   std::vector<CompileCommand> &Commands) const {
-  for (int I = 0, E = CommandsRef.size(); I != E; ++I) {
-    SmallString<8> DirectoryStorage;
-    SmallString<1024> CommandStorage;
+  StringRef Input = Database->getBuffer();
+  for (int I = 0, E = EntryOffsets.size(); I != E; ++I) {
+    // The entry was validated when the database was loaded.
+    DatabaseScanner Scanner(Input, EntryOffsets[I]);
+    RawEntry Entry;
+    std::string ErrorMessage;
+    if (!Scanner.scanEntry(Entry, ErrorMessage))
+      continue;
     Commands.push_back(CompileCommand(
-      // FIXME: Escape correctly:
-      CommandsRef[I].first->getValue(DirectoryStorage),
-      unescapeCommandLine(CommandsRef[I].second->getValue(CommandStorage))));
+      unescapeJSONString(Entry.Directory),
+      unescapeCommandLine(unescapeJSONString(Entry.Command))));
   }
 }
 
+void JSONCompilationDatabase::addEntry(StringRef NativeFilePath,
+                                       unsigned Offset) {
+  IndexByFile[NativeFilePath].push_back(Offset);
+  MatchTrie.insert(NativeFilePath);
+}
+
 bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
-  llvm::yaml::document_iterator I = YAMLStream.begin();
-  if (I == YAMLStream.end()) {
-    ErrorMessage = "Error while parsing YAML.";
+  StringRef Input = Database->getBuffer();
+  DatabaseScanner Scanner(Input);
+  if (!Scanner.scanArrayStart(ErrorMessage))
     return false;
-  }
-  llvm::yaml::Node *Root = I->getRoot();
-  if (Root == NULL) {
-    ErrorMessage = "Error while parsing YAML.";
-    return false;
-  }
-  llvm::yaml::SequenceNode *Array = dyn_cast<llvm::yaml::SequenceNode>(Root);
-  if (Array == NULL) {
-    ErrorMessage = "Expected array.";
-    return false;
-  }
-  for (llvm::yaml::SequenceNode::iterator AI = Array->begin(),
-                                          AE = Array->end();
-       AI != AE; ++AI) {
-    llvm::yaml::MappingNode *Object = dyn_cast<llvm::yaml::MappingNode>(&*AI);
-    if (Object == NULL) {
-      ErrorMessage = "Expected object.";
+  bool Failed = false;
+  for (bool First = true;
+       Scanner.scanToNextEntry(First, Failed, ErrorMessage); First = false) {
+    unsigned Offset = Scanner.getPosition();
+    RawEntry Entry;
+    if (!Scanner.scanEntry(Entry, ErrorMessage))
       return false;
-    }
-    llvm::yaml::ScalarNode *Directory = NULL;
-    llvm::yaml::ScalarNode *Command = NULL;
-    llvm::yaml::ScalarNode *File = NULL;
-    for (llvm::yaml::MappingNode::iterator KVI = Object->begin(),
-                                           KVE = Object->end();
-         KVI != KVE; ++KVI) {
-      llvm::yaml::Node *Value = (*KVI).getValue();
-      if (Value == NULL) {
-        ErrorMessage = "Expected value.";
-        return false;
-      }
-      llvm::yaml::ScalarNode *ValueString =
-          dyn_cast<llvm::yaml::ScalarNode>(Value);
-      if (ValueString == NULL) {
-        ErrorMessage = "Expected string as value.";
-        return false;
-      }
-      llvm::yaml::ScalarNode *KeyString =
-          dyn_cast<llvm::yaml::ScalarNode>((*KVI).getKey());
-      if (KeyString == NULL) {
-        ErrorMessage = "Expected strings as key.";
-        return false;
-      }
-      SmallString<8> KeyStorage;
-      if (KeyString->getValue(KeyStorage) == "directory") {
-        Directory = ValueString;
-      } else if (KeyString->getValue(KeyStorage) == "command") {
-        Command = ValueString;
-      } else if (KeyString->getValue(KeyStorage) == "file") {
-        File = ValueString;
-      } else {
-        ErrorMessage = ("Unknown key: \"" +
-                        KeyString->getRawValue() + "\"").str();
-        return false;
-      }
-    }
-    if (!File) {
+    if (!Entry.HasFile) {
       ErrorMessage = "Missing key: \"file\".";
       return false;
     }
-    if (!Command) {
+    if (!Entry.HasCommand) {
       ErrorMessage = "Missing key: \"command\".";
       return false;
     }
-    if (!Directory) {
+    if (!Entry.HasDirectory) {
       ErrorMessage = "Missing key: \"directory\".";
       return false;
     }
-    SmallString<8> FileStorage;
-    StringRef FileName = File->getValue(FileStorage);
     SmallString<128> NativeFilePath;
-    if (llvm::sys::path::is_relative(FileName)) {
-      SmallString<8> DirectoryStorage;
-      SmallString<128> AbsolutePath(
-          Directory->getValue(DirectoryStorage));
-      llvm::sys::path::append(AbsolutePath, FileName);
-      llvm::sys::path::native(AbsolutePath.str(), NativeFilePath);
-    } else {
-      llvm::sys::path::native(FileName, NativeFilePath);
-    }
-    IndexByFile[NativeFilePath].push_back(
-        CompileCommandRef(Directory, Command));
-    MatchTrie.insert(NativeFilePath.str());
+    getNativeFilePath(Entry, NativeFilePath);
+    addEntry(NativeFilePath, Offset);
+  }
+  return !Failed && Scanner.scanToEndOfInput(ErrorMessage);
+}
+
+namespace {
+
+/// \brief Reads fixed-size values from an index file.
+class IndexReader {
+public:
+  IndexReader(StringRef Data) : Data(Data) {}
+
+  template <typename T> bool read(T &Value) {
+    if (Data.size() < sizeof(T))
+      return false;
+    memcpy(&Value, Data.data(), sizeof(T));
+    Data = Data.substr(sizeof(T));
+    return true;
+  }
+
+  bool read(size_t Size, StringRef &Value) {
+    if (Data.size() < Size)
+      return false;
+    Value = Data.substr(0, Size);
+    Data = Data.substr(Size);
+    return true;
   }
+
+  bool atEnd() const { return Data.empty(); }
+
+private:
+  StringRef Data;
+};
+
+template <typename T> void writeValue(llvm::raw_ostream &OS, T Value) {
+  OS.write(reinterpret_cast<const char *>(&Value), sizeof(T));
+}
+
+} // end namespace
+
+// An index file consists of IndexFileMagic, the size and modification time
+// of the database, the number of entries, and for each entry the offset at
+// which it starts in the database followed by the length and the text of the
+// native path of its file.  Values are stored in host byte order, since the
+// index is only useful on the machine that wrote it.
+bool JSONCompilationDatabase::readIndex(StringRef IndexPath,
+                                        uint64_t DatabaseSize,
+                                        uint64_t DatabaseModTime) {
+  OwningPtr<llvm::MemoryBuffer> IndexBuffer;
+  if (llvm::MemoryBuffer::getFile(IndexPath, IndexBuffer, -1,
+                                  /*RequiresNullTerminator=*/false))
+    return false;
+  IndexReader Reader(IndexBuffer->getBuffer());
+  StringRef Magic;
+  uint64_t Size, ModTime;
+  uint32_t NumEntries;
+  if (!Reader.read(sizeof(IndexFileMagic) - 1, Magic) ||
+      Magic != IndexFileMagic || !Reader.read(Size) ||
+      Size != DatabaseSize || Size != Database->getBufferSize() ||
+      !Reader.read(ModTime) || ModTime != DatabaseModTime ||
+      !Reader.read(NumEntries))
+    return false;
+
+  std::vector<std::pair<StringRef, unsigned> > Entries;
+  Entries.reserve(NumEntries);
+  for (uint32_t I = 0; I != NumEntries; ++I) {
+    uint32_t Offset, PathLength;
+    StringRef Path;
+    if (!Reader.read(Offset) || Offset >= Size || !Reader.read(PathLength) ||
+        !Reader.read(PathLength, Path))
+      return false;
+    Entries.push_back(std::make_pair(Path, Offset));
+  }
+  if (!Reader.atEnd())
+    return false;
+
+  for (unsigned I = 0, E = Entries.size(); I != E; ++I)
+    addEntry(Entries[I].first, Entries[I].second);
   return true;
 }
 
+void JSONCompilationDatabase::writeIndex(StringRef IndexPath,
+                                         uint64_t DatabaseSize,
+                                         uint64_t DatabaseModTime) const {
+  // Entries of a file are written in database order, so that reading the
+  // index back yields the commands in the same order as parsing does.
+  std::vector<std::pair<unsigned, StringRef> > Entries;
+  for (llvm::StringMap< std::vector<unsigned> >::const_iterator
+         I = IndexByFile.begin(), E = IndexByFile.end();
+       I != E; ++I)
+    for (unsigned J = 0, F = I->getValue().size(); J != F; ++J)
+      Entries.push_back(std::make_pair(I->getValue()[J], I->getKey()));
+  std::sort(Entries.begin(), Entries.end());
+
+  // Write to a temporary file first so that concurrent loads never see a
+  // partially written index.  Failing to write the index is not an error;
+  // the database is just scanned again next time.
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(IndexPath + "-%%%%%%%%", FD, TempPath))
+    return;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS.write(IndexFileMagic, sizeof(IndexFileMagic) - 1);
+    writeValue<uint64_t>(OS, DatabaseSize);
+    writeValue<uint64_t>(OS, DatabaseModTime);
+    writeValue<uint32_t>(OS, Entries.size());
+    for (unsigned I = 0, E = Entries.size(); I != E; ++I) {
+      writeValue<uint32_t>(OS, Entries[I].first);
+      writeValue<uint32_t>(OS, Entries[I].second.size());
+      OS << Entries[I].second;
+    }
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath.str());
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath.str(), IndexPath))
+    llvm::sys::fs::remove(TempPath.str());
+}
+
 } // end namespace tooling
 } // end namespace clang
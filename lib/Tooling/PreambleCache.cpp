@@ -0,0 +1,213 @@
+//===--- PreambleCache.cpp - Preambles shared between tool runs -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the PreambleCache.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/PreambleCache.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+
+namespace clang {
+namespace tooling {
+
+struct PreambleCache::Entry {
+  Entry() : Built(false), Usable(false), Size(0), EndsAtStartOfLine(false) {}
+
+  /// \brief Held while the preamble is being precompiled, so that other
+  /// threads wanting the same preamble wait for it.
+  llvm::sys::Mutex BuildLock;
+
+  /// \brief Whether we attempted to precompile the preamble.
+  bool Built;
+
+  /// \brief Whether the preamble was precompiled successfully.
+  bool Usable;
+
+  /// \brief The path of the precompiled preamble.
+  std::string Path;
+
+  unsigned Size;
+  bool EndsAtStartOfLine;
+};
+
+PreambleCache::PreambleCache() : NumHits(0), NumMisses(0) {}
+
+PreambleCache::~PreambleCache() {
+  for (llvm::StringMap<Entry *>::iterator I = Entries.begin(),
+                                          E = Entries.end();
+       I != E; ++I) {
+    if (!I->getValue()->Path.empty())
+      llvm::sys::fs::remove(I->getValue()->Path);
+    delete I->getValue();
+  }
+}
+
+/// \brief Returns the buffer \p Invocation remaps its main file to, if any.
+static const llvm::MemoryBuffer *
+getRemappedMainBuffer(const CompilerInvocation &Invocation) {
+  StringRef MainFile = Invocation.getFrontendOpts().Inputs[0].getFile();
+  const PreprocessorOptions &PPOpts = Invocation.getPreprocessorOpts();
+  // Later remappings win, so look for the last one.
+  const llvm::MemoryBuffer *Buffer = 0;
+  for (PreprocessorOptions::const_remapped_file_buffer_iterator
+           I = PPOpts.remapped_file_buffer_begin(),
+           E = PPOpts.remapped_file_buffer_end();
+       I != E; ++I)
+    if (I->first == MainFile)
+      Buffer = I->second;
+  return Buffer;
+}
+
+bool PreambleCache::attachPreamble(CompilerInvocation &Invocation,
+                                   const llvm::opt::ArgStringList &CC1Args,
+                                   FileManager &Files) {
+  FrontendOptions &FrontendOpts = Invocation.getFrontendOpts();
+  PreprocessorOptions &PPOpts = Invocation.getPreprocessorOpts();
+  if (FrontendOpts.Inputs.size() != 1 ||
+      FrontendOpts.Inputs[0].getKind() == IK_AST ||
+      FrontendOpts.Inputs[0].getKind() == IK_LLVM_IR ||
+      !FrontendOpts.Inputs[0].isFile())
+    return false;
+  // Don't stack our precompiled header on top of one the user asked for, and
+  // leave module builds alone.
+  if (!PPOpts.ImplicitPCHInclude.empty() ||
+      !PPOpts.ImplicitPTHInclude.empty() ||
+      PPOpts.PrecompiledPreambleBytes.first != 0 ||
+      Invocation.getLangOpts()->Modules)
+    return false;
+
+  StringRef MainFile = FrontendOpts.Inputs[0].getFile();
+  OwningPtr<llvm::MemoryBuffer> OwnedMainBuffer;
+  const llvm::MemoryBuffer *MainBuffer = getRemappedMainBuffer(Invocation);
+  if (!MainBuffer) {
+    OwnedMainBuffer.reset(Files.getBufferForFile(MainFile));
+    MainBuffer = OwnedMainBuffer.get();
+  }
+  if (!MainBuffer)
+    return false;
+
+  std::pair<unsigned, bool> Preamble =
+      Lexer::ComputePreamble(MainBuffer, *Invocation.getLangOpts());
+  if (Preamble.first == 0)
+    return false;
+
+  // Quoted #includes in the preamble are resolved relative to the main
+  // file's directory, and everything else depends on the arguments apart
+  // from the main file itself.
+  SmallString<1024> Key = MainFile;
+  Files.FixupRelativePath(Key);
+  llvm::sys::fs::make_absolute(Key);
+  Key.resize(llvm::sys::path::parent_path(Key).size());
+  Key.push_back('\0');
+  for (unsigned I = 0, E = CC1Args.size(); I != E; ++I) {
+    StringRef Arg = CC1Args[I];
+    if (Arg == MainFile)
+      continue;
+    if (Arg == "-main-file-name" || Arg == "-o") {
+      ++I;
+      continue;
+    }
+    Key += Arg;
+    Key.push_back('\0');
+  }
+  Key += MainBuffer->getBuffer().substr(0, Preamble.first);
+  Key.push_back(Preamble.second ? '1' : '0');
+
+  Entry *E;
+  {
+    llvm::sys::ScopedLock L(Lock);
+    Entry *&Slot = Entries[Key];
+    if (!Slot)
+      Slot = new Entry;
+    E = Slot;
+  }
+
+  {
+    llvm::sys::ScopedLock L(E->BuildLock);
+    if (!E->Built) {
+      E->Built = true;
+      E->Size = Preamble.first;
+      E->EndsAtStartOfLine = Preamble.second;
+      E->Usable = buildPreamble(*E, Invocation, *MainBuffer, Preamble.first,
+                                Files);
+      llvm::sys::ScopedLock StatsLock(Lock);
+      ++NumMisses;
+    } else {
+      llvm::sys::ScopedLock StatsLock(Lock);
+      ++NumHits;
+    }
+  }
+  if (!E->Usable)
+    return false;
+
+  PPOpts.ImplicitPCHInclude = E->Path;
+  PPOpts.PrecompiledPreambleBytes.first = E->Size;
+  PPOpts.PrecompiledPreambleBytes.second = E->EndsAtStartOfLine;
+  // The preamble was built from another main file; only its text, which we
+  // compared above, has to match.
+  PPOpts.DisablePCHValidation = true;
+  return true;
+}
+
+bool PreambleCache::buildPreamble(Entry &E,
+                                  const CompilerInvocation &Invocation,
+                                  const llvm::MemoryBuffer &MainBuffer,
+                                  unsigned PreambleSize, FileManager &Files) {
+  SmallString<128> Path;
+  if (llvm::sys::fs::createTemporaryFile("preamble", "pch", Path))
+    return false;
+  E.Path = Path.str();
+
+  IntrusiveRefCntPtr<CompilerInvocation> PreambleInvocation(
+      new CompilerInvocation(Invocation));
+  FrontendOptions &FrontendOpts = PreambleInvocation->getFrontendOpts();
+  FrontendOpts.ProgramAction = frontend::GeneratePCH;
+  FrontendOpts.OutputFile = E.Path;
+
+  // Parse only the preamble of the main file. The other remapped buffers are
+  // shared with Invocation, which keeps ownership of them.
+  StringRef MainFile = FrontendOpts.Inputs[0].getFile();
+  OwningPtr<llvm::MemoryBuffer> PreambleBuffer(
+      llvm::MemoryBuffer::getMemBufferCopy(
+          MainBuffer.getBuffer().substr(0, PreambleSize), MainFile));
+  PreprocessorOptions &PPOpts = PreambleInvocation->getPreprocessorOpts();
+  PPOpts.RetainRemappedFileBuffers = true;
+  PPOpts.addRemappedFile(MainFile, PreambleBuffer.get());
+
+  CompilerInstance Clang;
+  Clang.setInvocation(PreambleInvocation.getPtr());
+  // If the headers have errors the preamble is not shared, and they are
+  // reported when the translation unit is parsed as usual.
+  Clang.createDiagnostics(new IgnoringDiagConsumer());
+  Clang.setFileManager(&Files);
+  Clang.createSourceManager(Files);
+
+  GeneratePCHAction Action;
+  if (!Clang.ExecuteAction(Action) ||
+      Clang.getDiagnostics().hasErrorOccurred()) {
+    llvm::sys::fs::remove(E.Path);
+    E.Path.clear();
+    return false;
+  }
+  return true;
+}
+
+} // end namespace tooling
+} // end namespace clang
@@ -275,6 +275,16 @@ RefactoringTool::RefactoringTool(const CompilationDatabase &Compilations,
 
 Replacements &RefactoringTool::getReplacements() { return Replace; }
 
+void RefactoringTool::addReplacement(const Replacement &Replace) {
+  llvm::sys::ScopedLock L(ReplaceLock);
+  this->Replace.insert(Replace);
+}
+
+void RefactoringTool::addReplacements(const Replacements &Replaces) {
+  llvm::sys::ScopedLock L(ReplaceLock);
+  Replace.insert(Replaces.begin(), Replaces.end());
+}
+
 int RefactoringTool::runAndSave(FrontendActionFactory *ActionFactory) {
   if (int Result = run(ActionFactory)) {
     return Result;
@@ -14,6 +14,7 @@
 
 #include "clang/Tooling/Tooling.h"
 #include "clang/AST/ASTConsumer.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Driver/Compilation.h"
 #include "clang/Driver/Driver.h"
 #include "clang/Driver/Tool.h"
@@ -28,6 +29,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/raw_ostream.h"
 
 // For chdir, see the comment in ClangTool::run for more information.
@@ -169,7 +171,8 @@ ToolInvocation::ToolInvocation(ArrayRef<std::string> CommandLine,
       Action(Action),
       OwnsAction(false),
       Files(Files),
-      DiagConsumer(NULL) {}
+      DiagConsumer(NULL),
+      Preambles(NULL) {}
 
 ToolInvocation::ToolInvocation(ArrayRef<std::string> CommandLine,
                                FrontendAction *FAction, FileManager *Files)
@@ -177,7 +180,8 @@ ToolInvocation::ToolInvocation(ArrayRef<std::string> CommandLine,
       Action(new SingleFrontendActionFactory(FAction)),
       OwnsAction(true),
       Files(Files),
-      DiagConsumer(NULL) {}
+      DiagConsumer(NULL),
+      Preambles(NULL) {}
 
 ToolInvocation::~ToolInvocation() {
   if (OwnsAction)
@@ -188,6 +192,10 @@ void ToolInvocation::setDiagnosticConsumer(DiagnosticConsumer *D) {
   DiagConsumer = D;
 }
 
+void ToolInvocation::setPreambleCache(PreambleCache *Preambles) {
+  this->Preambles = Preambles;
+}
+
 void ToolInvocation::mapVirtualFile(StringRef FilePath, StringRef Content) {
   SmallString<1024> PathStorage;
   llvm::sys::path::native(FilePath, PathStorage);
@@ -227,6 +235,18 @@ bool ToolInvocation::run() {
         llvm::MemoryBuffer::getMemBuffer(It->getValue());
     Invocation->getPreprocessorOpts().addRemappedFile(It->getKey(), Input);
   }
+  if (Files) {
+    // File managers created for this invocation, such as ASTUnit's, see the
+    // same overlay and stat cache as Files, and resolve relative paths against
+    // the same directory.
+    FileSystemOptions &FileSystemOpts = Invocation->getFileSystemOpts();
+    FileSystemOpts.Overlay = Files->getFileSystemOptions().Overlay;
+    FileSystemOpts.SharedStats = Files->getFileSystemOptions().SharedStats;
+    if (FileSystemOpts.WorkingDir.empty())
+      FileSystemOpts.WorkingDir = Files->getFileSystemOptions().WorkingDir;
+  }
+  if (Preambles && Files)
+    Preambles->attachPreamble(*Invocation, *CC1Args, *Files);
   return runInvocation(BinaryName, Compilation.get(), Invocation.take());
 }
 
@@ -272,7 +292,14 @@ bool FrontendActionFactory::runInvocation(CompilerInvocation *Invocation,
 
 ClangTool::ClangTool(const CompilationDatabase &Compilations,
                      ArrayRef<std::string> SourcePaths)
-    : Files(new FileManager(FileSystemOptions())), DiagConsumer(NULL) {
+    : DiagConsumer(NULL), NumThreads(1) {
+  // Every translation unit sees the mapped files, and reuses the successful
+  // 'stat' calls made by the others. Failures are not shared, as tools may
+  // create files while they run.
+  FileSystemOpts.Overlay = new FileOverlay();
+  FileSystemOpts.SharedStats = new SharedStatCache();
+  Files = new FileManager(FileSystemOpts);
+
   ArgsAdjusters.push_back(new ClangStripOutputAdjuster());
   ArgsAdjusters.push_back(new ClangSyntaxOnlyAdjuster());
   for (unsigned I = 0, E = SourcePaths.size(); I != E; ++I) {
@@ -300,8 +327,19 @@ void ClangTool::setDiagnosticConsumer(DiagnosticConsumer *D) {
   DiagConsumer = D;
 }
 
+void ClangTool::setSharePreambles(bool Share) {
+  if (!Share)
+    Preambles.reset();
+  else if (!Preambles)
+    Preambles.reset(new PreambleCache());
+}
+
+void ClangTool::setNumThreads(unsigned NumThreads) {
+  this->NumThreads = NumThreads;
+}
+
 void ClangTool::mapVirtualFile(StringRef FilePath, StringRef Content) {
-  MappedFileContents.push_back(std::make_pair(FilePath, Content));
+  FileSystemOpts.Overlay->addFile(FilePath, Content);
 }
 
 void ClangTool::setArgumentsAdjuster(ArgumentsAdjuster *Adjuster) {
@@ -319,6 +357,16 @@ void ClangTool::clearArgumentsAdjusters() {
   ArgsAdjusters.clear();
 }
 
+std::vector<std::string> ClangTool::getAdjustedCommandLine(
+    unsigned I, const std::string &MainExecutable) const {
+  std::vector<std::string> CommandLine = CompileCommands[I].second.CommandLine;
+  for (unsigned J = 0, E = ArgsAdjusters.size(); J != E; ++J)
+    CommandLine = ArgsAdjusters[J]->Adjust(CommandLine);
+  assert(!CommandLine.empty());
+  CommandLine[0] = MainExecutable;
+  return CommandLine;
+}
+
 int ClangTool::run(ToolAction *Action) {
   // Exists solely for the purpose of lookup of the resource path.
   // This just needs to be some symbol in the binary.
@@ -331,6 +379,13 @@ int ClangTool::run(ToolAction *Action) {
   std::string MainExecutable =
       llvm::sys::fs::getMainExecutable("clang_tool", &StaticSymbol);
 
+  // Files may have changed since the last run.
+  FileSystemOpts.SharedStats->revalidate();
+
+  if (NumThreads > 1 && CompileCommands.size() > 1 &&
+      isParallelExecutionSupported())
+    return runInParallel(Action, MainExecutable);
+
   bool ProcessingFailed = false;
   for (unsigned I = 0; I < CompileCommands.size(); ++I) {
     std::string File = CompileCommands[I].first;
@@ -344,11 +399,8 @@ int ClangTool::run(ToolAction *Action) {
     if (chdir(CompileCommands[I].second.Directory.c_str()))
       llvm::report_fatal_error("Cannot chdir into \"" +
                                CompileCommands[I].second.Directory + "\n!");
-    std::vector<std::string> CommandLine = CompileCommands[I].second.CommandLine;
-    for (unsigned I = 0, E = ArgsAdjusters.size(); I != E; ++I)
-      CommandLine = ArgsAdjusters[I]->Adjust(CommandLine);
-    assert(!CommandLine.empty());
-    CommandLine[0] = MainExecutable;
+    std::vector<std::string> CommandLine =
+        getAdjustedCommandLine(I, MainExecutable);
     // FIXME: We need a callback mechanism for the tool writer to output a
     // customized message for each file.
     DEBUG({
@@ -356,10 +408,7 @@ int ClangTool::run(ToolAction *Action) {
     });
     ToolInvocation Invocation(CommandLine, Action, Files.getPtr());
     Invocation.setDiagnosticConsumer(DiagConsumer);
-    for (int I = 0, E = MappedFileContents.size(); I != E; ++I) {
-      Invocation.mapVirtualFile(MappedFileContents[I].first,
-                                MappedFileContents[I].second);
-    }
+    Invocation.setPreambleCache(Preambles.get());
     if (!Invocation.run()) {
       // FIXME: Diagnostics should be used instead.
       llvm::errs() << "Error while processing " << File << ".\n";
@@ -371,8 +420,124 @@ int ClangTool::run(ToolAction *Action) {
 
 namespace {
 
+/// \brief Serializes the calls into a \c DiagnosticConsumer that is shared by
+/// translation units processed on different threads.
+class LockedDiagnosticConsumer : public DiagnosticConsumer {
+  DiagnosticConsumer &Target;
+  llvm::sys::Mutex &Lock;
+
+public:
+  LockedDiagnosticConsumer(DiagnosticConsumer &Target, llvm::sys::Mutex &Lock)
+      : Target(Target), Lock(Lock) {}
+
+  virtual void BeginSourceFile(const LangOptions &LangOpts,
+                               const Preprocessor *PP) {
+    llvm::sys::ScopedLock L(Lock);
+    Target.BeginSourceFile(LangOpts, PP);
+  }
+
+  virtual void EndSourceFile() {
+    llvm::sys::ScopedLock L(Lock);
+    Target.EndSourceFile();
+  }
+
+  virtual void finish() {
+    llvm::sys::ScopedLock L(Lock);
+    Target.finish();
+  }
+
+  virtual bool IncludeInDiagnosticCounts() const {
+    return Target.IncludeInDiagnosticCounts();
+  }
+
+  virtual void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
+                                const Diagnostic &Info) {
+    DiagnosticConsumer::HandleDiagnostic(DiagLevel, Info);
+    llvm::sys::ScopedLock L(Lock);
+    Target.HandleDiagnostic(DiagLevel, Info);
+  }
+};
+
+}
+
+/// \brief The state shared by the worker threads of a parallel ClangTool::run.
+struct ClangTool::ParallelRun {
+  ClangTool *Tool;
+  ToolAction *Action;
+  /// \brief The adjusted command line of each compile command.
+  std::vector<std::vector<std::string> > CommandLines;
+  /// \brief Guards the output streams, the user's diagnostic consumer and
+  /// ProcessingFailed.
+  llvm::sys::Mutex OutputLock;
+  bool ProcessingFailed;
+};
+
+void ClangTool::runCommandInParallel(void *UserData, unsigned I) {
+  ParallelRun &Run = *static_cast<ParallelRun *>(UserData);
+  ClangTool &Tool = *Run.Tool;
+  const std::string &File = Tool.CompileCommands[I].first;
+
+  // Instead of chdir'ing, which would affect all threads, resolve relative
+  // paths against the command's directory in a FileManager of our own.
+  FileSystemOptions FileSystemOpts = Tool.FileSystemOpts;
+  FileSystemOpts.WorkingDir = Tool.CompileCommands[I].second.Directory;
+  llvm::IntrusiveRefCntPtr<FileManager> Files(new FileManager(FileSystemOpts));
+
+  // Diagnostics are collected per translation unit and written out in one
+  // piece, so that the output of concurrent translation units does not
+  // interleave.
+  std::string DiagnosticText;
+  llvm::raw_string_ostream DiagnosticStream(DiagnosticText);
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+  TextDiagnosticPrinter DiagnosticPrinter(DiagnosticStream, &*DiagOpts);
+  OwningPtr<LockedDiagnosticConsumer> LockedConsumer;
+  if (Tool.DiagConsumer)
+    LockedConsumer.reset(
+        new LockedDiagnosticConsumer(*Tool.DiagConsumer, Run.OutputLock));
+
+  DEBUG({
+    llvm::sys::ScopedLock L(Run.OutputLock);
+    llvm::dbgs() << "Processing: " << File << ".\n";
+  });
+  ToolInvocation Invocation(Run.CommandLines[I], Run.Action, Files.getPtr());
+  Invocation.setPreambleCache(Tool.Preambles.get());
+  if (LockedConsumer)
+    Invocation.setDiagnosticConsumer(LockedConsumer.get());
+  else
+    Invocation.setDiagnosticConsumer(&DiagnosticPrinter);
+  bool Success = Invocation.run();
+
+  llvm::sys::ScopedLock L(Run.OutputLock);
+  llvm::errs() << DiagnosticStream.str();
+  if (!Success) {
+    // FIXME: Diagnostics should be used instead.
+    llvm::errs() << "Error while processing " << File << ".\n";
+    Run.ProcessingFailed = true;
+  }
+}
+
+int ClangTool::runInParallel(ToolAction *Action,
+                             const std::string &MainExecutable) {
+  ParallelRun Run;
+  Run.Tool = this;
+  Run.Action = Action;
+  Run.ProcessingFailed = false;
+  // Arguments adjusters are not required to be thread-safe, so run them all
+  // up front.
+  for (unsigned I = 0, E = CompileCommands.size(); I != E; ++I)
+    Run.CommandLines.push_back(getAdjustedCommandLine(I, MainExecutable));
+
+  clang::runInParallel(CompileCommands.size(), NumThreads,
+                       &ClangTool::runCommandInParallel, &Run);
+  return Run.ProcessingFailed ? 1 : 0;
+}
+
+namespace {
+
 class ASTBuilderAction : public ToolAction {
   std::vector<ASTUnit *> &ASTs;
+  // Guards ASTs when the tool runs on several threads.
+  llvm::sys::Mutex ASTsLock;
 
 public:
   ASTBuilderAction(std::vector<ASTUnit *> &ASTs) : ASTs(ASTs) {}
@@ -387,6 +552,7 @@ public:
     if (!AST)
       return false;
 
+    llvm::sys::ScopedLock L(ASTsLock);
     ASTs.push_back(AST);
     return true;
   }
@@ -0,0 +1,27 @@
+int headerDeref(int *p) {
+  if (p)
+    return 0;
+  return *p;
+}
+
+int headerSum(int n, ...) {
+  return n;
+}
+
+#define RETURN_IF(x, v) if ((x) == (v)) return (v)
+
+int headerBranches(int x) {
+  RETURN_IF(x, 1);
+  RETURN_IF(x, 2);
+  RETURN_IF(x, 3);
+  RETURN_IF(x, 4);
+  RETURN_IF(x, 5);
+  return 0;
+}
+
+int headerLoop(int n) {
+  int s = 0;
+  while (n--)
+    ++s;
+  return s;
+}
@@ -0,0 +1,37 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=dfs -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=bfs -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=bfs-block-dfs-contents -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=unexplored-first -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=unexplored-first-queue -verify %s
+
+// Every strategy explores these small functions completely.
+
+int loopThenDeref(int n) {
+  int *p = 0;
+  for (int i = 0; i < n; ++i)
+    if (i == 3)
+      return i;
+  return *p; // expected-warning{{Dereference of null pointer}}
+}
+
+int nestedBranches(int a, int b) {
+  int x;
+  if (a) {
+    if (b)
+      x = 1;
+  } else {
+    x = 2;
+  }
+  return x; // expected-warning{{Undefined or garbage value returned to caller}}
+}
+
+int callee(int *p) {
+  return *p; // expected-warning{{Dereference of null pointer}}
+}
+
+int caller() {
+  int y = 0;
+  while (y < 5)
+    ++y;
+  return callee(0);
+}
@@ -0,0 +1,20 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,unix.Malloc,debug.Stats -analyzer-output=text -analyzer-max-loop 1000000 -analyzer-config max-nodes=0,graph-trim-interval=1,graph-trim-aggressive=true,graph-memory-limit=1 -verify %s
+
+// Without a step budget, only the graph memory limit stops the analysis of
+// the loop below, long before it is done. The leak found before the loop is
+// anchored to a checker-tagged node, which must survive the aggressive
+// reclamation of the nodes that led up to the limit.
+
+typedef __typeof(sizeof(int)) size_t;
+void *malloc(size_t);
+
+int leakThenLoop(void) { // expected-warning-re{{leakThenLoop -> Total CFGBlocks: [0-9]+ \| Unreachable CFGBlocks: [0-9]+ \| Exhausted Block: no \| Empty WorkList: no \| Graph Memory: [0-9]{4,} KB}}
+                         // expected-note-re@-1{{leakThenLoop -> Total CFGBlocks: [0-9]+ \| Unreachable CFGBlocks: [0-9]+ \| Exhausted Block: no \| Empty WorkList: no \| Graph Memory: [0-9]{4,} KB}}
+  int *p = malloc(sizeof(int)); // expected-note{{Memory is allocated}}
+  *p = 0;
+  int sum = 0; // expected-warning{{Potential leak of memory pointed to by 'p'}}
+               // expected-note@-1{{Potential leak of memory pointed to by 'p'}}
+  for (int i = 0; i < 1000000; ++i)
+    sum += i;
+  return sum;
+}
@@ -0,0 +1,18 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,unix.Malloc -analyzer-output=text -analyzer-config graph-trim-interval=1 -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,unix.Malloc -analyzer-output=text -analyzer-config graph-trim-interval=1,graph-trim-aggressive=true -verify %s
+
+// Leak reports are anchored to checker-tagged nodes, which must survive
+// aggressive reclamation.
+
+typedef __typeof(sizeof(int)) size_t;
+void *malloc(size_t);
+void free(void *);
+
+void leak(int x) {
+  int *p = malloc(sizeof(int)); // expected-note{{Memory is allocated}}
+  if (x) // expected-note{{Assuming 'x' is not equal to 0}}
+         // expected-note@-1{{Taking true branch}}
+    return; // expected-warning{{Potential leak of memory pointed to by 'p'}}
+            // expected-note@-1{{Potential leak of memory pointed to by 'p'}}
+  free(p);
+}
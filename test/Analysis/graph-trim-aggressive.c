@@ -0,0 +1,20 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=text -analyzer-config graph-trim-interval=1 -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=text -analyzer-config graph-trim-interval=1,graph-trim-aggressive=true -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=text -analyzer-config graph-trim-aggressive=true,graph-memory-limit=1024 -verify %s
+
+// Reclaiming more nodes must not change the reports or their paths.
+
+int *getNull(void) {
+  return 0; // expected-note{{Returning null pointer}}
+}
+
+int deref(int *p) {
+  int *q = getNull(); // expected-note{{Calling 'getNull'}}
+                      // expected-note@-1{{Returning from 'getNull'}}
+                      // expected-note@-2{{'q' initialized to a null pointer value}}
+  if (p) // expected-note{{Assuming 'p' is non-null}}
+         // expected-note@-1{{Taking true branch}}
+    return *q; // expected-warning{{Dereference of null pointer (loaded from variable 'q')}}
+              // expected-note@-1{{Dereference of null pointer (loaded from variable 'q')}}
+  return 0;
+}
@@ -0,0 +1,56 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -verify -analyzer-constraints=range %s
+
+void clang_analyzer_eval(int);
+
+// Constraints that split a symbol's range into many disjoint intervals, and
+// paths that reach the same intervals in a different order.
+
+void excludeMany(int x) {
+  if (x == 1 || x == 3 || x == 5 || x == 7)
+    return;
+
+  clang_analyzer_eval(x != 1); // expected-warning{{TRUE}}
+  clang_analyzer_eval(x != 3); // expected-warning{{TRUE}}
+  clang_analyzer_eval(x != 5); // expected-warning{{TRUE}}
+  clang_analyzer_eval(x != 7); // expected-warning{{TRUE}}
+  clang_analyzer_eval(x == 2); // expected-warning{{UNKNOWN}}
+
+  if (x >= 1 && x <= 7) {
+    clang_analyzer_eval(x == 2 || x == 4 || x == 6); // expected-warning{{TRUE}}
+    if (x > 2 && x < 6)
+      clang_analyzer_eval(x == 4); // expected-warning{{TRUE}}
+  }
+}
+
+void sameSetDifferentOrder(int x, int flag) {
+  if (flag) {
+    if (x == 0 || x == 10)
+      return;
+  } else {
+    if (x == 10 || x == 0)
+      return;
+  }
+
+  clang_analyzer_eval(x != 0 && x != 10); // expected-warning{{TRUE}}
+}
+
+void intersectWithWholeSet(unsigned x) {
+  if (x < 100)
+    return;
+
+  // Neither of these constraints removes any value.
+  if (x >= 50 && x != 20)
+    clang_analyzer_eval(x >= 100); // expected-warning{{TRUE}}
+  else
+    clang_analyzer_eval(0); // no-warning
+}
+
+void narrowToEmpty(int x) {
+  if (x != 4)
+    return;
+
+  if (x < 3 || x > 5)
+    clang_analyzer_eval(0); // no-warning
+  else
+    clang_analyzer_eval(x == 4); // expected-warning{{TRUE}}
+}
@@ -0,0 +1,31 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-output=plist -analyzer-result-cache %t/cache -o %t/first.plist %s 2>&1 | FileCheck -check-prefix=ANALYZED %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-output=plist -analyzer-result-cache %t/cache -o %t/second.plist %s 2>&1 | FileCheck -check-prefix=REPLAYED %s
+// RUN: diff %t/first.plist %t/second.plist
+// RUN: FileCheck -input-file=%t/second.plist %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,unix -analyzer-display-progress -analyzer-output=plist -analyzer-result-cache %t/cache -o %t/third.plist %s 2>&1 | FileCheck -check-prefix=ANALYZED %s
+// RUN: for f in %t/cache/*; do echo 'CLANG-ANALYZER-RESULTS 2' > $f; echo 'X 0 x' >> $f; done
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=plist -analyzer-result-cache %t/cache -o %t/fourth.plist %s 2>&1 | FileCheck -check-prefix=CORRUPT %s
+// REQUIRES: shell
+
+// The second analysis replays the reports and warnings of the first one
+// without analyzing, while the third one uses different options. The fourth
+// one finds a corrupt entry.
+
+int deref(int *p) {
+  if (p)
+    return 0;
+  return *p;
+}
+
+// ANALYZED: ANALYZE
+// ANALYZED: warning: Dereference of null pointer
+// REPLAYED-NOT: ANALYZE
+// REPLAYED: result-cache.c:19:10: warning: Dereference of null pointer (loaded from variable 'p')
+// REPLAYED-NEXT: return *p;
+// REPLAYED-NEXT: ^~
+// REPLAYED-NOT: ANALYZE
+// CORRUPT: warning: could not replay the cached analysis results from '{{.*}}cache'
+
+// CHECK: <key>description</key><string>Dereference of null pointer (loaded from variable &apos;p&apos;)</string>
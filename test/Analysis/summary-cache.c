@@ -0,0 +1,49 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-opt-analyze-headers -analyzer-max-loop 2 -analyzer-config max-inlinable-size=8 -analyzer-summary-cache %t %s 2>&1 | FileCheck %s
+// RUN: FileCheck -check-prefix=STORE -input-file=%t/analyzer-summaries %s
+// RUN: FileCheck -check-prefix=NOSTORE -input-file=%t/analyzer-summaries %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-opt-analyze-headers -analyzer-max-loop 2 -analyzer-config max-inlinable-size=8 -analyzer-summary-cache %t %s 2>&1 | FileCheck %s
+
+// The summaries left by the first translation unit must not change the
+// reports of the next one, including those in headers.
+
+#include "Inputs/summary-cache.h"
+
+int divide(int x) {
+  if (x)
+    return 0;
+  return 10 / x;
+}
+
+int sum(void) {
+  return headerSum(1, 2);
+}
+
+int branches(int x) {
+  return headerBranches(x);
+}
+
+int loop(int n) {
+  return headerLoop(n);
+}
+
+static int mainFileSum(int n, ...) {
+  return n;
+}
+
+int callMainFileSum(void) {
+  return mainFileSum(1, 2);
+}
+
+// CHECK-DAG: summary-cache.h:4:{{[0-9]+}}: warning: Dereference of null pointer
+// CHECK-DAG: summary-cache.c:15:{{[0-9]+}}: warning: Division by zero
+
+// Variadic functions and functions too large to inline are never inlined.
+// STORE: CLANG-ANALYZER-SUMMARIES 3
+// STORE-DAG: {{^[0-9a-f]+ 1 headerSum int \(int, \.\.\.\)$}}
+// STORE-DAG: {{^[0-9a-f]+ 1 headerBranches int \(int\)$}}
+
+// The loop only exhausts the block budget of the call above, which says
+// nothing about other calls. Functions of the main file are not shared.
+// NOSTORE-NOT: headerLoop
+// NOSTORE-NOT: mainFileSum
@@ -0,0 +1,19 @@
+// RUN: %clang -### -parallel-jobs=4 -fsyntax-only %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=ACCEPTED %s
+// ACCEPTED-NOT: argument unused during compilation
+// ACCEPTED-NOT: error:
+
+// RUN: not %clang -### -parallel-jobs=many -fsyntax-only %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=INVALID %s
+// INVALID: invalid integral value 'many' in '-parallel-jobs=many'
+
+// Every independent command still runs, and all failures are reported.
+// RUN: %clang -parallel-jobs=2 -fsyntax-only %s %s
+// RUN: not %clang -parallel-jobs=2 -fsyntax-only -DBROKEN %s %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=FAILURES %s
+// FAILURES: error: unknown type name 'broken_t'
+// FAILURES: error: unknown type name 'broken_t'
+
+#ifdef BROKEN
+broken_t x;
+#endif
@@ -0,0 +1,26 @@
+// RUN: echo "int   a1 ;" > %t-1.cpp
+// RUN: echo "int   a2 ;" > %t-2.cpp
+// RUN: echo "int   a3 ;" > %t-3.cpp
+// RUN: echo "int   a4 ;" > %t-4.cpp
+// RUN: clang-format -style=LLVM -j=4 %t-1.cpp %t-2.cpp %t-3.cpp %t-4.cpp \
+// RUN:   | FileCheck -strict-whitespace %s
+// RUN: echo "%t-1.cpp" > %t.list
+// RUN: echo "%t-2.cpp" >> %t.list
+// RUN: clang-format -style=LLVM -j=0 -files=%t.list %t-3.cpp %t-4.cpp \
+// RUN:   | FileCheck -strict-whitespace -check-prefix=LIST %s
+// RUN: clang-format -style=LLVM -j=2 -i -files=%t.list
+// RUN: FileCheck -strict-whitespace -check-prefix=INPLACE -input-file=%t-1.cpp %s
+// RUN: FileCheck -strict-whitespace -check-prefix=INPLACE -input-file=%t-2.cpp %s
+
+// The output is in the order of the files, whichever finishes first.
+// CHECK: {{^int\ a1;}}
+// CHECK-NEXT: {{^int\ a2;}}
+// CHECK-NEXT: {{^int\ a3;}}
+// CHECK-NEXT: {{^int\ a4;}}
+
+// LIST: {{^int\ a3;}}
+// LIST-NEXT: {{^int\ a4;}}
+// LIST-NEXT: {{^int\ a1;}}
+// LIST-NEXT: {{^int\ a2;}}
+
+// INPLACE: {{^int\ a[12];}}
@@ -0,0 +1,23 @@
+// A corpus of lines that make the search for the best line breaks expensive:
+// generated tables, long builder chains and deeply nested calls.  Run lit
+// with --time-tests to track how long clang-format takes on them.
+//
+// RUN: grep -Ev "// *[A-Z-]+:" %s > %t.cpp
+// RUN: clang-format -style=LLVM %t.cpp | FileCheck %s
+// RUN: clang-format -style=Google %t.cpp | FileCheck %s
+// RUN: clang-format -style="{BasedOnStyle: LLVM, MaxAnalyzedStatesPerLine: 100}" %t.cpp | FileCheck %s
+
+// CHECK: Table[] = {
+static const unsigned char Table[] = { 0x00, 0x25, 0x4a, 0x6f, 0x94, 0xb9, 0xde, 0x03, 0x28, 0x4d, 0x72, 0x97, 0xbc, 0xe1, 0x06, 0x2b, 0x50, 0x75, 0x9a, 0xbf, 0xe4, 0x09, 0x2e, 0x53, 0x78, 0x9d, 0xc2, 0xe7, 0x0c, 0x31, 0x56, 0x7b, 0xa0, 0xc5, 0xea, 0x0f, 0x34, 0x59, 0x7e, 0xa3, 0xc8, 0xed, 0x12, 0x37, 0x5c, 0x81, 0xa6, 0xcb, 0xf0, 0x15, 0x3a, 0x5f, 0x84, 0xa9, 0xce, 0xf3, 0x18, 0x3d, 0x62, 0x87, 0xac, 0xd1, 0xf6, 0x1b, 0x40, 0x65, 0x8a, 0xaf, 0xd4, 0xf9, 0x1e, 0x43, 0x68, 0x8d, 0xb2, 0xd7, 0xfc, 0x21, 0x46, 0x6b, 0x90, 0xb5, 0xda, 0xff, 0x24, 0x49, 0x6e, 0x93, 0xb8, 0xdd, 0x02, 0x27, 0x4c, 0x71, 0x96, 0xbb, 0xe0, 0x05, 0x2a, 0x4f, 0x74, 0x99, 0xbe, 0xe3, 0x08, 0x2d, 0x52, 0x77, 0x9c, 0xc1, 0xe6, 0x0b, 0x30, 0x55, 0x7a, 0x9f, 0xc4, 0xe9, 0x0e, 0x33, 0x58, 0x7d, 0xa2, 0xc7, 0xec, 0x11, 0x36, 0x5b, 0x80, 0xa5, 0xca, 0xef, 0x14, 0x39, 0x5e, 0x83, 0xa8, 0xcd, 0xf2, 0x17, 0x3c, 0x61, 0x86, 0xab, 0xd0, 0xf5, 0x1a, 0x3f, 0x64, 0x89, 0xae, 0xd3, 0xf8, 0x1d, 0x42, 0x67, 0x8c, 0xb1, 0xd6, 0xfb, 0x20, 0x45, 0x6a, 0x8f, 0xb4, 0xd9, 0xfe, 0x23, 0x48, 0x6d, 0x92, 0xb7, 0xdc, 0x01, 0x26, 0x4b, 0x70, 0x95, 0xba, 0xdf, 0x04, 0x29, 0x4e, 0x73, 0x98, 0xbd, 0xe2, 0x07, 0x2c, 0x51, 0x76, 0x9b, 0xc0, 0xe5, 0x0a, 0x2f, 0x54, 0x79, 0x9e, 0xc3, 0xe8, 0x0d, 0x32, 0x57, 0x7c, 0xa1, 0xc6, 0xeb, 0x10, 0x35, 0x5a, 0x7f, 0xa4, 0xc9, 0xee, 0x13, 0x38, 0x5d, 0x82, 0xa7, 0xcc, 0xf1, 0x16, 0x3b, 0x60, 0x85, 0xaa, 0xcf, 0xf4, 0x19, 0x3e, 0x63, 0x88, 0xad, 0xd2, 0xf7, 0x1c, 0x41, 0x66, 0x8b, 0xb0, 0xd5, 0xfa, 0x1f, 0x44, 0x69, 0x8e, 0xb3, 0xd8, 0xfd, 0x22, 0x47, 0x6c, 0x91, 0xb6, 0xdb };
+
+// CHECK: Builder
+void build() { Builder.add("key0", value0).add("key1", value1).add("key2", value2).add("key3", value3).add("key4", value4).add("key5", value5).add("key6", value6).add("key7", value7).add("key8", value8).add("key9", value9).add("key10", value10).add("key11", value11).add("key12", value12).add("key13", value13).add("key14", value14).add("key15", value15).add("key16", value16).add("key17", value17).add("key18", value18).add("key19", value19).add("key20", value20).add("key21", value21).add("key22", value22).add("key23", value23).add("key24", value24).add("key25", value25).add("key26", value26).add("key27", value27).add("key28", value28).add("key29", value29).add("key30", value30).add("key31", value31).add("key32", value32).add("key33", value33).add("key34", value34).add("key35", value35).add("key36", value36).add("key37", value37).add("key38", value38).add("key39", value39); }
+
+// CHECK: int Nested =
+int Nested = f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(x, y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y), y);
+
+// CHECK: llvm::errs()
+void print() { llvm::errs() << field0 << field1 << field2 << field3 << field4 << field5 << field6 << field7 << field8 << field9 << field10 << field11 << field12 << field13 << field14 << field15 << field16 << field17 << field18 << field19 << field20 << field21 << field22 << field23 << field24 << field25 << field26 << field27 << field28 << field29 << field30 << field31 << field32 << field33 << field34 << field35 << field36 << field37 << field38 << field39 << field40 << field41 << field42 << field43 << field44 << field45 << field46 << field47 << field48 << field49 << field50 << field51 << field52 << field53 << field54 << field55 << field56 << field57 << field58 << field59; }
+
+// CHECK: int Selected =
+int Selected = c0 ? v0 : c1 ? v1 : c2 ? v2 : c3 ? v3 : c4 ? v4 : c5 ? v5 : c6 ? v6 : c7 ? v7 : c8 ? v8 : c9 ? v9 : c10 ? v10 : c11 ? v11 : c12 ? v12 : c13 ? v13 : c14 ? v14 : c15 ? v15 : c16 ? v16 : c17 ? v17 : c18 ? v18 : c19 ? v19 : c20 ? v20 : c21 ? v21 : c22 ? v22 : c23 ? v23 : c24 ? v24 : c25 ? v25 : c26 ? v26 : c27 ? v27 : c28 ? v28 : c29 ? v29 : 0;
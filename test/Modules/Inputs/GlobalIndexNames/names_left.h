@@ -0,0 +1,5 @@
+#include "names_top.h"
+
+namespace N {
+  int left_only(int);
+}
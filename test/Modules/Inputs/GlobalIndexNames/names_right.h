@@ -0,0 +1,5 @@
+#include "names_top.h"
+
+namespace N {
+  int right_only(int);
+}
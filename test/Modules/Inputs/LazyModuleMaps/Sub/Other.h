@@ -0,0 +1 @@
+int other(void);
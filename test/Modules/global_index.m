@@ -13,7 +13,12 @@
 @import Module;
 
 // CHECK: *** Global Module Index Statistics:
+// CHECK: selector lookups succeeded
 
 int *get_sub() {
   return Module_Sub;
 }
+
+id alloc_module(id x) {
+  return [x alloc];
+}
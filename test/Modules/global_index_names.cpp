@@ -0,0 +1,21 @@
+// RUN: rm -rf %t
+// Build the modules and the global module index.
+// RUN: %clang_cc1 -fmodules -fmodules-cache-path=%t -fdisable-module-hash -I %S/Inputs/GlobalIndexNames %s -verify
+// RUN: ls %t | grep modules.idx
+// Without the index, the name is looked up in every module file.
+// RUN: %clang_cc1 -fmodules -fmodules-cache-path=%t -fdisable-module-hash -fno-modules-global-index -I %S/Inputs/GlobalIndexNames %s -verify -print-stats 2>&1 | FileCheck -check-prefix=NO-INDEX %s
+// With the index, only the module file declaring it is searched.
+// RUN: %clang_cc1 -fmodules -fmodules-cache-path=%t -fdisable-module-hash -I %S/Inputs/GlobalIndexNames %s -verify -print-stats 2>&1 | FileCheck %s
+
+// expected-no-diagnostics
+#include "names_left.h"
+#include "names_right.h"
+
+int test() {
+  return N::right_only(0);
+}
+
+// NO-INDEX-NOT: module files skipped by declaration name lookups
+// CHECK: 2 module files skipped by declaration name lookups
+// CHECK: *** Global Module Index Statistics:
+// CHECK: declaration name lookups succeeded
@@ -0,0 +1,15 @@
+// RUN: rm -rf %t
+// RUN: not %clang_cc1 -fmodules -fmodules-cache-path=%t -I %S/Inputs/LazyModuleMaps %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -fmodules -fmodules-cache-path=%t -flazy-module-maps -I %S/Inputs/LazyModuleMaps %s -verify
+
+// The broken module is only diagnosed when every module is parsed.
+// CHECK: error: header 'missing.h' not found
+
+// expected-no-diagnostics
+
+@import Used;
+#include "Sub/Other.h"
+
+int test() {
+  return used() + other();
+}
@@ -0,0 +1,41 @@
+// Check that the tokens of files modified since the PTH file was generated are
+// lexed from source.
+
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '#include "pth-stale-header.h"' > %t/pth-stale.h
+// RUN: echo 'int cached_decl;' > %t/pth-stale-header.h
+// RUN: touch -t 200001010000 %t/pth-stale-header.h
+// RUN: %clang_cc1 -emit-pth -o %t/pth-stale.pth %t/pth-stale.h
+// RUN: %clang_cc1 -include-pth %t/pth-stale.pth -E -print-stats \
+// RUN:   -o %t/cached.i %s 2>&1 | FileCheck -check-prefix=CACHED-STATS %s
+// RUN: FileCheck -check-prefix=CACHED < %t/cached.i %s
+
+// A header touched without changing keeps its tokens.
+// RUN: touch %t/pth-stale-header.h
+// RUN: %clang_cc1 -include-pth %t/pth-stale.pth -E -print-stats \
+// RUN:   -o %t/touched.i %s 2>&1 | FileCheck -check-prefix=CACHED-STATS %s
+// RUN: FileCheck -check-prefix=CACHED < %t/touched.i %s
+
+// A header modified without changing its size is caught by its hash.
+// RUN: echo 'int edited_decl;' > %t/pth-stale-header.h
+// RUN: %clang_cc1 -include-pth %t/pth-stale.pth -E -print-stats \
+// RUN:   -o %t/stale.i %s 2>&1 | FileCheck -check-prefix=STALE-STATS %s
+// RUN: FileCheck -check-prefix=STALE < %t/stale.i %s
+
+// A header which grew is read in full, not with the size it had when the PTH
+// file was generated.
+// RUN: echo 'int resized_declaration_of_another_size;' > %t/pth-stale-header.h
+// RUN: %clang_cc1 -include-pth %t/pth-stale.pth -E -print-stats \
+// RUN:   -o %t/resized.i %s 2>&1 | FileCheck -check-prefix=STALE-STATS %s
+// RUN: FileCheck -check-prefix=RESIZED < %t/resized.i %s
+
+// CACHED: int cached_decl;
+// CACHED-STATS: 2 files read from the token cache, 0 stale files lexed from source.
+
+// STALE-NOT: cached_decl
+// STALE: int edited_decl;
+// STALE-STATS: 1 files read from the token cache, 1 stale files lexed from source.
+
+// RESIZED-NOT: cached_decl
+// RESIZED: int resized_declaration_of_another_size;
@@ -0,0 +1,80 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/a/sub %t/b/gen %t/c/sub
+// RUN: echo 'int in_c;' > %t/c/lookup.h
+// RUN: echo 'int in_c_sub;' > %t/c/sub/nested.h
+// RUN: touch -t 200001010000 %t/a %t/b
+
+// The first translation unit searches all directories and records where the
+// header is.
+// RUN: %clang_cc1 -header-lookup-cache %t/lookups -I %t/a -I %t/b -I %t/c \
+// RUN:   -E -print-stats %s -o %t/first.i 2>&1 | FileCheck -check-prefix=MISS %s
+// RUN: FileCheck -check-prefix=FIRST < %t/first.i %s
+// RUN: FileCheck -check-prefix=CACHE < %t/lookups %s
+
+// The next one goes straight to the right directory, and leaves the store as
+// it is.  Headers added to subdirectories do not change the modification
+// times of the search directories, so lookups of names with path components
+// are not kept, and neither are lookups which found nothing.
+// RUN: cp %t/lookups %t/lookups.first
+// RUN: echo 'int in_a_sub;' > %t/a/sub/nested.h
+// RUN: echo 'int in_b_gen;' > %t/b/gen/config.h
+// RUN: %clang_cc1 -header-lookup-cache %t/lookups -I %t/a -I %t/b -I %t/c \
+// RUN:   -E -print-stats %s -o %t/second.i 2>&1 | FileCheck -check-prefix=HIT %s
+// RUN: FileCheck -check-prefix=SECOND < %t/second.i %s
+// RUN: cmp %t/lookups %t/lookups.first
+
+// Writing any file to a search directory before the one found, such as an
+// object file to a build directory, only makes the lookup search it again.
+// RUN: echo > %t/b/lookup.o
+// RUN: %clang_cc1 -header-lookup-cache %t/lookups -I %t/a -I %t/b -I %t/c \
+// RUN:   -E -print-stats %s -o %t/third.i 2>&1 | FileCheck -check-prefix=HIT %s
+// RUN: FileCheck -check-prefix=SECOND < %t/third.i %s
+
+// Which finds the header if it was added there.
+// RUN: echo 'int in_a;' > %t/a/lookup.h
+// RUN: %clang_cc1 -header-lookup-cache %t/lookups -I %t/a -I %t/b -I %t/c \
+// RUN:   -E -print-stats %s -o %t/fourth.i 2>&1 | FileCheck -check-prefix=HIT %s
+// RUN: FileCheck -check-prefix=FOURTH < %t/fourth.i %s
+
+// Lookups made with other search directories are kept apart.
+// RUN: %clang_cc1 -header-lookup-cache %t/lookups -I %t/b -I %t/c \
+// RUN:   -E -print-stats %s -o %t/fifth.i 2>&1 | FileCheck -check-prefix=MISS %s
+// RUN: FileCheck -check-prefix=FIFTH < %t/fifth.i %s
+// RUN: %clang_cc1 -header-lookup-cache %t/lookups -I %t/a -I %t/b -I %t/c \
+// RUN:   -E -print-stats %s -o %t/sixth.i 2>&1 | FileCheck -check-prefix=HIT %s
+// RUN: FileCheck -check-prefix=FOURTH < %t/sixth.i %s
+// RUN: FileCheck -check-prefix=SECTIONS < %t/lookups %s
+
+// A store in one of the search directories would change its modification
+// time whenever it is written, so it is not used.
+// RUN: %clang_cc1 -header-lookup-cache %t/c/lookups -I %t/a -I %t/b -I %t/c \
+// RUN:   -E -print-stats %s -o %t/seventh.i 2>&1 \
+// RUN:   | FileCheck -check-prefix=UNUSED %s
+// RUN: test ! -e %t/c/lookups
+
+#include <lookup.h>
+#include <sub/nested.h>
+#if __has_include(<gen/config.h>)
+#include <gen/config.h>
+#endif
+
+// FIRST: int in_c;
+// FIRST: int in_c_sub;
+// FIRST-NOT: in_b_gen
+// SECOND: int in_c;
+// SECOND: int in_a_sub;
+// SECOND: int in_b_gen;
+// FOURTH: int in_a;
+// FIFTH: int in_c;
+// FIFTH: int in_c_sub;
+// CACHE: {{^# CLANG-HEADER-LOOKUPS 3 [0-9a-f]+$}}
+// CACHE-NEXT: {{^2 [0-9]+ 0 lookup.h$}}
+// CACHE-NOT: {{.}}
+// SECTIONS: {{^# CLANG-HEADER-LOOKUPS 3 [0-9a-f]+$}}
+// SECTIONS-NEXT: {{^1 [0-9]+ 0 lookup.h$}}
+// SECTIONS-NEXT: {{^# CLANG-HEADER-LOOKUPS 3 [0-9a-f]+$}}
+// SECTIONS-NEXT: {{^0 [0-9]+ 0 lookup.h$}}
+// SECTIONS-NOT: {{.}}
+// MISS: 0 header lookups found in the header lookup cache, 1 not found.
+// HIT: 1 header lookups found in the header lookup cache, 0 not found.
+// UNUSED: 0 header lookups found in the header lookup cache, 0 not found.
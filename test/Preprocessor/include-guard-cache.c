@@ -0,0 +1,34 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '#ifndef GUARDED_H' > %t/guarded.h
+// RUN: echo '#define GUARDED_H' >> %t/guarded.h
+// RUN: echo 'int guarded_decl;' >> %t/guarded.h
+// RUN: echo '#endif' >> %t/guarded.h
+
+// The first translation unit records the guard.
+// RUN: %clang_cc1 -include-guard-cache %t/guards -I %t -E %s -o %t/first.i
+// RUN: FileCheck -check-prefix=FIRST < %t/first.i %s
+// RUN: FileCheck -check-prefix=CACHE < %t/guards %s
+
+// The next one skips the header without entering it when the guard is
+// already defined, but still lists it among the dependencies.
+// RUN: %clang_cc1 -include-guard-cache %t/guards -I %t -DGUARDED_H -E \
+// RUN:   -dependency-file %t/second.d -MT second.o \
+// RUN:   -print-stats %s -o %t/second.i 2>&1 | FileCheck -check-prefix=SKIP %s
+// RUN: FileCheck -check-prefix=DEPS < %t/second.d %s
+
+// The guard is not used once the header changes.
+// RUN: echo '// A new line' >> %t/guarded.h
+// RUN: %clang_cc1 -include-guard-cache %t/guards -I %t -DGUARDED_H -E \
+// RUN:   -print-stats %s -o %t/third.i 2>&1 | FileCheck -check-prefix=STALE %s
+
+#include <guarded.h>
+
+// FIRST: int guarded_decl;
+// CACHE: CLANG-INCLUDE-GUARDS 1
+// CACHE: GUARDED_H {{.*}}guarded.h
+// DEPS: second.o:
+// DEPS: include-guard-cache.c
+// DEPS: guarded.h
+// SKIP: 1 #includes skipped with guards from the include guard cache.
+// STALE: 0 #includes skipped with guards from the include guard cache.
@@ -0,0 +1,16 @@
+// Verifies that files processed concurrently still resolve paths relatively
+// to the directory specified in the compilation database.
+// RUN: rm -rf %t
+// RUN: mkdir %t %t/a %t/b
+// RUN: echo "[{\"directory\":\"%t/a\",\"command\":\"clang -c test.cpp -I.\",\"file\":\"%t/a/test.cpp\"},{\"directory\":\"%t/b\",\"command\":\"clang -c test.cpp -I.\",\"file\":\"%t/b/test.cpp\"}]" | sed -e 's/\\/\//g' > %t/compile_commands.json
+// RUN: cp "%s" "%t/a/test.cpp"
+// RUN: cp "%s" "%t/b/test.cpp"
+// RUN: touch "%t/a/clang-check-test.h"
+// RUN: touch "%t/b/clang-check-test.h"
+// RUN: not clang-check -j 2 -p "%t" "%t/a/test.cpp" "%t/b/test.cpp" 2>&1|FileCheck %s
+
+#include "clang-check-test.h"
+
+// CHECK: C++ requires
+// CHECK: C++ requires
+invalid;
@@ -190,6 +190,10 @@ int main(int argc, const char **argv) {
   CommonOptionsParser OptionsParser(argc, argv);
   ClangTool Tool(OptionsParser.getCompilations(),
                  OptionsParser.getSourcePathList());
+  // The AST printing modes write straight to stdout and -fixit rewrites shared
+  // headers in place, so only plain checking runs files concurrently.
+  if (!ASTList && !ASTDump && !ASTPrint && !Fixit)
+    Tool.setNumThreads(OptionsParser.getNumThreads());
 
   // Clear adjusters because -fsyntax-only is inserted by the default chain.
   Tool.clearArgumentsAdjusters();
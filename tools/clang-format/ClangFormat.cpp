@@ -16,13 +16,16 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/DiagnosticOptions.h"
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/Parallel.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Format/Format.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringMap.h"
 
 using namespace llvm;
@@ -88,6 +91,16 @@ static cl::opt<unsigned>
                     "clang-format from an editor integration"),
            cl::init(0), cl::cat(ClangFormatCategory));
 
+static cl::opt<std::string>
+FileList("files",
+         cl::desc("Read the names of the files to format from this file,\n"
+                  "one per line, in addition to the <file>s given."),
+         cl::cat(ClangFormatCategory));
+static cl::opt<unsigned>
+NumThreads("j", cl::desc("Number of files to format in parallel, or 0 to\n"
+                         "use one thread per core."),
+           cl::init(1), cl::cat(ClangFormatCategory));
+
 static cl::list<std::string> FileNames(cl::Positional, cl::desc("[<file> ...]"),
                                        cl::cat(ClangFormatCategory));
 
@@ -140,27 +153,29 @@ static bool fillRanges(SourceManager &Sources, FileID ID,
     return false;
   }
 
-  if (Offsets.empty())
-    Offsets.push_back(0);
-  if (Offsets.size() != Lengths.size() &&
-      !(Offsets.size() == 1 && Lengths.empty())) {
+  // Several files may be formatted at once, so leave the option alone.
+  std::vector<unsigned> Starts(Offsets.begin(), Offsets.end());
+  if (Starts.empty())
+    Starts.push_back(0);
+  if (Starts.size() != Lengths.size() &&
+      !(Starts.size() == 1 && Lengths.empty())) {
     llvm::errs()
         << "error: number of -offset and -length arguments must match.\n";
     return true;
   }
-  for (unsigned i = 0, e = Offsets.size(); i != e; ++i) {
-    if (Offsets[i] >= Code->getBufferSize()) {
-      llvm::errs() << "error: offset " << Offsets[i]
+  for (unsigned i = 0, e = Starts.size(); i != e; ++i) {
+    if (Starts[i] >= Code->getBufferSize()) {
+      llvm::errs() << "error: offset " << Starts[i]
                    << " is outside the file\n";
       return true;
     }
     SourceLocation Start =
-        Sources.getLocForStartOfFile(ID).getLocWithOffset(Offsets[i]);
+        Sources.getLocForStartOfFile(ID).getLocWithOffset(Starts[i]);
     SourceLocation End;
     if (i < Lengths.size()) {
-      if (Offsets[i] + Lengths[i] > Code->getBufferSize()) {
+      if (Starts[i] + Lengths[i] > Code->getBufferSize()) {
         llvm::errs() << "error: invalid length " << Lengths[i]
-                     << ", offset + length (" << Offsets[i] + Lengths[i]
+                     << ", offset + length (" << Starts[i] + Lengths[i]
                      << ") is outside the file.\n";
         return true;
       }
@@ -174,7 +189,8 @@ static bool fillRanges(SourceManager &Sources, FileID ID,
 }
 
 // Returns true on error.
-static bool format(StringRef FileName) {
+static bool format(StringRef FileName, StyleFileCache &Cache,
+                   raw_ostream &OS) {
   FileManager Files((FileSystemOptions()));
   DiagnosticsEngine Diagnostics(
       IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs),
@@ -193,38 +209,102 @@ static bool format(StringRef FileName) {
     return true;
 
   FormatStyle FormatStyle =
-      getStyle(Style, (FileName == "-") ? AssumeFilename : FileName);
+      getStyle(Style, (FileName == "-") ? AssumeFilename : FileName, &Cache);
   Lexer Lex(ID, Sources.getBuffer(ID), Sources,
             getFormattingLangOpts(FormatStyle.Standard));
   tooling::Replacements Replaces = reformat(FormatStyle, Lex, Sources, Ranges);
   if (OutputXML) {
-    llvm::outs()
-        << "<?xml version='1.0'?>\n<replacements xml:space='preserve'>\n";
+    OS << "<?xml version='1.0'?>\n<replacements xml:space='preserve'>\n";
     for (tooling::Replacements::const_iterator I = Replaces.begin(),
                                                E = Replaces.end();
          I != E; ++I) {
-      llvm::outs() << "<replacement "
-                   << "offset='" << I->getOffset() << "' "
-                   << "length='" << I->getLength() << "'>"
-                   << I->getReplacementText() << "</replacement>\n";
+      OS << "<replacement "
+         << "offset='" << I->getOffset() << "' "
+         << "length='" << I->getLength() << "'>"
+         << I->getReplacementText() << "</replacement>\n";
     }
-    llvm::outs() << "</replacements>\n";
+    OS << "</replacements>\n";
   } else {
     Rewriter Rewrite(Sources, LangOptions());
     tooling::applyAllReplacements(Replaces, Rewrite);
     if (Inplace) {
+      // Writes a temporary file next to each changed file and renames it over
+      // the original, so that other processes never see a partial result.
       if (Rewrite.overwriteChangedFiles())
         return true;
     } else {
       if (Cursor.getNumOccurrences() != 0)
-        outs() << "{ \"Cursor\": " << tooling::shiftedCodePosition(
-                                          Replaces, Cursor) << " }\n";
-      Rewrite.getEditBuffer(ID).write(outs());
+        OS << "{ \"Cursor\": " << tooling::shiftedCodePosition(
+                                      Replaces, Cursor) << " }\n";
+      Rewrite.getEditBuffer(ID).write(OS);
     }
   }
   return false;
 }
 
+namespace {
+
+/// \brief The output of formatting one of several files, printed in order
+/// once all files are formatted.
+struct FileResult {
+  FileResult() : Error(false) {}
+  std::string Output;
+  bool Error;
+};
+
+/// \brief The state shared by the tasks formatting several files.
+struct FormatFilesTask {
+  ArrayRef<std::string> FileNames;
+  StyleFileCache *Cache;
+  std::vector<FileResult> Results;
+};
+
+} // end anonymous namespace
+
+static void formatFileTask(void *UserData, unsigned Index) {
+  FormatFilesTask &Task = *static_cast<FormatFilesTask *>(UserData);
+  FileResult &Result = Task.Results[Index];
+  llvm::raw_string_ostream OS(Result.Output);
+  Result.Error = format(Task.FileNames[Index], *Task.Cache, OS);
+}
+
+// Formats \p Files on up to \p Threads threads. Returns true on error.
+static bool formatFiles(ArrayRef<std::string> Files, unsigned Threads) {
+  StyleFileCache Cache;
+  FormatFilesTask Task;
+  Task.FileNames = Files;
+  Task.Cache = &Cache;
+  Task.Results.resize(Files.size());
+  if (Threads == 0)
+    Threads = getNumHardwareThreads();
+  runInParallel(Files.size(), Threads, formatFileTask, &Task);
+
+  bool Error = false;
+  for (unsigned i = 0, e = Files.size(); i != e; ++i) {
+    outs() << Task.Results[i].Output;
+    Error |= Task.Results[i].Error;
+  }
+  return Error;
+}
+
+// Appends the file names listed in \p ListFile, one per line, to \p Files.
+// Returns true on error.
+static bool readFileList(StringRef ListFile, std::vector<std::string> &Files) {
+  OwningPtr<MemoryBuffer> List;
+  if (error_code ec = MemoryBuffer::getFileOrSTDIN(ListFile, List)) {
+    llvm::errs() << ListFile << ": " << ec.message() << "\n";
+    return true;
+  }
+  SmallVector<StringRef, 16> Lines;
+  List->getBuffer().split(Lines, "\n", /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (unsigned i = 0, e = Lines.size(); i != e; ++i) {
+    StringRef Line = Lines[i].trim();
+    if (!Line.empty())
+      Files.push_back(Line);
+  }
+  return false;
+}
+
 }  // namespace format
 }  // namespace clang
 
@@ -261,13 +341,18 @@ int main(int argc, const char **argv) {
     return 0;
   }
 
+  std::vector<std::string> Files(FileNames.begin(), FileNames.end());
+  if (!FileList.empty() && clang::format::readFileList(FileList, Files))
+    return 1;
+
   bool Error = false;
-  switch (FileNames.size()) {
+  clang::format::StyleFileCache Cache;
+  switch (Files.size()) {
   case 0:
-    Error = clang::format::format("-");
+    Error = clang::format::format("-", Cache, outs());
     break;
   case 1:
-    Error = clang::format::format(FileNames[0]);
+    Error = clang::format::format(Files[0], Cache, outs());
     break;
   default:
     if (!Offsets.empty() || !Lengths.empty() || !LineRanges.empty()) {
@@ -275,8 +360,7 @@ int main(int argc, const char **argv) {
                       "single file.\n";
       return 1;
     }
-    for (unsigned i = 0; i < FileNames.size(); ++i)
-      Error |= clang::format::format(FileNames[i]);
+    Error = clang::format::formatFiles(Files, NumThreads);
     break;
   }
   return Error ? 1 : 0;
@@ -0,0 +1,254 @@
+//===- lex-bench.cpp - Lexer and source manager benchmarks ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements lex-bench, which measures the throughput of the lexer
+// and of the source manager on generated inputs.  It runs the benchmarks named
+// on the command line, or all of them.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TargetOptions.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/ModuleLoader.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace clang;
+
+static cl::list<std::string>
+BenchmarkNames(cl::Positional, cl::desc("[<benchmark> ...]"));
+
+namespace {
+
+class VoidModuleLoader : public ModuleLoader {
+  virtual ModuleLoadResult loadModule(SourceLocation ImportLoc,
+                                      ModuleIdPath Path,
+                                      Module::NameVisibilityKind Visibility,
+                                      bool IsInclusionDirective) {
+    return ModuleLoadResult();
+  }
+
+  virtual void makeModuleVisible(Module *Mod,
+                                 Module::NameVisibilityKind Visibility,
+                                 SourceLocation ImportLoc,
+                                 bool Complain) { }
+};
+
+/// \brief The source manager and options a benchmark works with.
+class BenchmarkContext {
+public:
+  BenchmarkContext()
+    : FileMgr(FileMgrOpts),
+      DiagID(new DiagnosticIDs()),
+      Diags(DiagID, new DiagnosticOptions, new IgnoringDiagConsumer()),
+      SourceMgr(Diags, FileMgr),
+      TargetOpts(new TargetOptions) {
+    TargetOpts->Triple = "x86_64-apple-darwin11.1.0";
+    Target = TargetInfo::CreateTargetInfo(Diags, &*TargetOpts);
+  }
+
+  FileSystemOptions FileMgrOpts;
+  FileManager FileMgr;
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID;
+  DiagnosticsEngine Diags;
+  SourceManager SourceMgr;
+  LangOptions LangOpts;
+  IntrusiveRefCntPtr<TargetOptions> TargetOpts;
+  IntrusiveRefCntPtr<TargetInfo> Target;
+};
+
+struct Benchmark {
+  const char *Name;
+  const char *Description;
+  void (*Run)(BenchmarkContext &Ctx);
+};
+
+} // end anonymous namespace
+
+static double secondsSince(const TimeRecord &Start) {
+  return TimeRecord::getCurrentTime(false).getWallTime() - Start.getWallTime();
+}
+
+/// \brief Lexes a file made of a snippet of comments, whitespace, identifiers
+/// and string literals with the raw lexer.
+static void runRawLexer(BenchmarkContext &Ctx) {
+  const char Snippet[] =
+      "/* A block comment which spans\n"
+      " * several lines. */\n"
+      "static inline int some_function_name(const char *argument_one,\n"
+      "                                     unsigned long argument_two) {\n"
+      "  // A line comment explaining the next statement in some detail.\n"
+      "  return printf(\"%s: %lu\\n\", argument_one, argument_two);\n"
+      "}\n\n";
+  std::string Source;
+  for (unsigned i = 0; i != 100000; ++i)
+    Source += Snippet;
+
+  MemoryBuffer *Buf = MemoryBuffer::getMemBuffer(Source);
+  FileID FID = Ctx.SourceMgr.createMainFileIDForMemBuffer(Buf);
+  Lexer L(FID, Ctx.SourceMgr.getBuffer(FID), Ctx.SourceMgr, Ctx.LangOpts);
+
+  TimeRecord Start = TimeRecord::getCurrentTime();
+  unsigned NumTokens = 0;
+  Token Tok;
+  do {
+    L.LexFromRawLexer(Tok);
+    ++NumTokens;
+  } while (Tok.isNot(tok::eof));
+  double Seconds = secondsSince(Start);
+
+  outs() << NumTokens << " tokens in " << Source.size() << " bytes lexed in "
+         << format("%.3f", Seconds) << "s: "
+         << format("%.0f", NumTokens / Seconds) << " tokens/s\n";
+}
+
+/// \brief Preprocesses an X-macro table, with token pasting, stringification
+/// and arguments that go through several levels of expansion.
+static void runMacroExpansion(BenchmarkContext &Ctx) {
+  std::string Source =
+      "#define CAT_I(a, b) a ## b\n"
+      "#define CAT(a, b) CAT_I(a, b)\n"
+      "#define STR_I(x) #x\n"
+      "#define STR(x) STR_I(x)\n"
+      "#define ENTRY(name, value, desc) \\\n"
+      "  CAT(name, _id) = (value) + sizeof(STR(desc)),\n"
+      "#define ROW(n) ENTRY(CAT(e, n), n, \"row\" n) \\\n"
+      "  ENTRY(CAT(f, n), CAT(n, 0) * 2, 'x' n)\n"
+      "enum E {\n";
+  for (unsigned i = 0; i != 50000; ++i)
+    Source += "ROW(" + utostr(i) + ")\n";
+  Source += "};\n";
+
+  MemoryBuffer *Buf = MemoryBuffer::getMemBuffer(Source);
+  (void) Ctx.SourceMgr.createMainFileIDForMemBuffer(Buf);
+
+  VoidModuleLoader ModLoader;
+  HeaderSearch HeaderInfo(new HeaderSearchOptions, Ctx.SourceMgr, Ctx.Diags,
+                          Ctx.LangOpts, Ctx.Target.getPtr());
+  Preprocessor PP(new PreprocessorOptions(), Ctx.Diags, Ctx.LangOpts,
+                  Ctx.Target.getPtr(), Ctx.SourceMgr, HeaderInfo, ModLoader,
+                  /*IILookup =*/ 0, /*OwnsHeaderSearch =*/ false,
+                  /*DelayInitialization =*/ false);
+  PP.EnterMainSourceFile();
+
+  TimeRecord Start = TimeRecord::getCurrentTime();
+  unsigned NumTokens = 0;
+  Token Tok;
+  do {
+    PP.Lex(Tok);
+    ++NumTokens;
+  } while (Tok.isNot(tok::eof));
+  double Seconds = secondsSince(Start);
+
+  outs() << NumTokens << " tokens expanded in " << format("%.3f", Seconds)
+         << "s: " << format("%.0f", NumTokens / Seconds) << " tokens/s, "
+         << Ctx.SourceMgr.local_sloc_entry_size() << " SLocEntries\n";
+}
+
+/// \brief Looks up the files of scattered locations among many files and
+/// macro expansions.
+static void runGetFileID(BenchmarkContext &Ctx) {
+  SourceManager &SM = Ctx.SourceMgr;
+  std::vector<FileID> FIDs;
+  std::vector<unsigned> Sizes;
+  for (unsigned i = 0; i != 100000; ++i) {
+    MemoryBuffer *Buf =
+        MemoryBuffer::getMemBufferCopy(std::string(i % 37 + 1, 'x'));
+    FileID FID = SM.createFileIDForMemBuffer(Buf);
+    FIDs.push_back(FID);
+    // Files also contain their end location.
+    Sizes.push_back(Buf->getBufferSize() + 1);
+
+    if (i % 3 == 0) {
+      SourceLocation Start = SM.getLocForStartOfFile(FID);
+      SM.createExpansionLoc(Start, Start, Start, 5);
+    }
+  }
+
+  std::vector<SourceLocation> Locs;
+  unsigned Seed = 1;
+  for (unsigned n = 0; n != 1000000; ++n) {
+    Seed = Seed * 1103515245 + 12345;
+    unsigned i = (Seed >> 8) % FIDs.size();
+    Locs.push_back(SM.getLocForStartOfFile(FIDs[i])
+                       .getLocWithOffset((Seed >> 4) % Sizes[i]));
+  }
+
+  TimeRecord Start = TimeRecord::getCurrentTime();
+  unsigned Checksum = 0;
+  for (unsigned n = 0, e = Locs.size(); n != e; ++n)
+    Checksum += SM.getFileID(Locs[n]).getHashValue();
+  double Seconds = secondsSince(Start);
+
+  outs() << Locs.size() << " lookups among " << FIDs.size() << " files in "
+         << format("%.3f", Seconds) << "s: "
+         << format("%.0f", Locs.size() / Seconds) << " lookups/s"
+         << " (checksum " << Checksum << ")\n";
+}
+
+static const Benchmark Benchmarks[] = {
+  { "raw-lexer", "Raw lexing of comments, identifiers and strings",
+    runRawLexer },
+  { "getfileid", "SourceManager::getFileID of scattered locations",
+    runGetFileID },
+  { "macro-expansion", "Preprocessing of nested function-like macros",
+    runMacroExpansion }
+};
+
+int main(int argc, char **argv) {
+  llvm_shutdown_obj Shutdown;
+  cl::ParseCommandLineOptions(argc, argv, "lexer benchmarks\n");
+
+  for (unsigned i = 0, e = BenchmarkNames.size(); i != e; ++i) {
+    bool Known = false;
+    for (unsigned j = 0; j != array_lengthof(Benchmarks); ++j)
+      Known |= BenchmarkNames[i] == Benchmarks[j].Name;
+    if (!Known) {
+      errs() << "error: unknown benchmark '" << BenchmarkNames[i]
+             << "'; the benchmarks are:\n";
+      for (unsigned j = 0; j != array_lengthof(Benchmarks); ++j)
+        errs() << "  " << Benchmarks[j].Name << " - "
+               << Benchmarks[j].Description << '\n';
+      return 1;
+    }
+  }
+
+  for (unsigned j = 0; j != array_lengthof(Benchmarks); ++j) {
+    if (!BenchmarkNames.empty() &&
+        std::find(BenchmarkNames.begin(), BenchmarkNames.end(),
+                  Benchmarks[j].Name) == BenchmarkNames.end())
+      continue;
+
+    // Every benchmark starts from an empty source manager.
+    BenchmarkContext Ctx;
+    outs() << Benchmarks[j].Name << ": ";
+    Benchmarks[j].Run(Ctx);
+  }
+  return 0;
+}
@@ -4149,6 +4149,52 @@ TEST(MatchFinder, InterceptsEndOfTranslationUnit) {
   EXPECT_TRUE(VerifyCallback.Called);
 }
 
+class CountMatches : public MatchFinder::MatchCallback {
+public:
+  CountMatches() : Count(0) {}
+  virtual void run(const MatchFinder::MatchResult &Result) { ++Count; }
+  unsigned Count;
+};
+
+TEST(MatchFinder, SkipsMatchersRestrictedToOtherKinds) {
+  MatchFinder Finder;
+  CountMatches Records;
+  CountMatches Returns;
+  CountMatches Decls;
+  Finder.addMatcher(recordDecl(hasName("X")).bind("x"), &Records);
+  Finder.addMatcher(returnStmt(), &Returns);
+  Finder.addMatcher(decl(), &Decls);
+  OwningPtr<ASTUnit> AST(tooling::buildASTFromCode(
+      "class X {}; int f() { return 0; } int g() { return 1; }"));
+  ASSERT_TRUE(AST.get());
+  Finder.matchAST(AST->getASTContext());
+  EXPECT_EQ(1u, Records.Count);
+  EXPECT_EQ(2u, Returns.Count);
+  EXPECT_LT(0u, Decls.Count);
+  EXPECT_LT(0u, Finder.getStatistics().SkippedMatcherInvocations);
+
+  Finder.resetStatistics();
+  EXPECT_EQ(0u, Finder.getStatistics().MatcherInvocations);
+  EXPECT_EQ(0u, Finder.getStatistics().SkippedMatcherInvocations);
+}
+
+TEST(MatchFinder, MemoizesRecursiveMatches) {
+  MatchFinder Finder;
+  CountMatches Callback;
+  Finder.addMatcher(
+      compoundStmt(hasAncestor(functionDecl(hasName("f")))), &Callback);
+  OwningPtr<ASTUnit> AST(tooling::buildASTFromCode(
+      "void f() { { { { } } } }"));
+  ASSERT_TRUE(AST.get());
+  Finder.matchAST(AST->getASTContext());
+  EXPECT_EQ(4u, Callback.Count);
+  // The outer blocks were already found to be inside f() when the inner
+  // blocks are visited.
+  EXPECT_LT(0u, Finder.getStatistics().MemoizationHits);
+  EXPECT_LT(0u, Finder.getStatistics().MemoizationMisses);
+  EXPECT_EQ(0u, Finder.getStatistics().MemoizationEvictions);
+}
+
 TEST(EqualsBoundNodeMatcher, QualType) {
   EXPECT_TRUE(matches(
       "int i = 1;", varDecl(hasType(qualType().bind("type")),
@@ -10,6 +10,8 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/FileSystemOptions.h"
 #include "clang/Basic/FileSystemStatCache.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -231,6 +233,107 @@ TEST_F(FileManagerTest, getFileReturnsSameFileEntryForAliasedVirtualFiles) {
   EXPECT_EQ(manager.getFile("abc/foo.cpp"), manager.getFile("abc/bar.cpp"));
 }
 
+// Files in the overlay are found, with their contents, whatever is on disk.
+TEST(FileManagerOverlayTest, getFileFindsFilesInTheOverlay) {
+  FileSystemOptions options;
+  options.Overlay = new FileOverlay();
+  options.Overlay->addFile("/overlay/foo.h", "int foo;\n");
+  FileManager manager(options);
+  manager.addStatCache(new FakeStatCache);
+
+  const FileEntry *file = manager.getFile("/overlay/foo.h");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(9, file->getSize());
+  EXPECT_TRUE(manager.getDirectory("/overlay") != NULL);
+
+  OwningPtr<llvm::MemoryBuffer> buffer(manager.getBufferForFile(file));
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ("int foo;\n", buffer->getBuffer());
+
+  EXPECT_EQ(NULL, manager.getFile("/overlay/bar.h"));
+}
+
+// Relative paths and other spellings of the path of a file in the overlay
+// find the same file.
+TEST(FileManagerOverlayTest, getFileFindsOtherSpellingsOfOverlayFiles) {
+  FileSystemOptions options;
+  options.Overlay = new FileOverlay();
+  options.Overlay->addFile("/overlay/dir/../foo.h", "int foo;\n");
+  options.WorkingDir = "/overlay/dir";
+  FileManager manager(options);
+  manager.addStatCache(new FakeStatCache);
+
+  const FileEntry *file = manager.getFile("/overlay/./foo.h");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(file, manager.getFile("../foo.h"));
+  EXPECT_EQ(file, manager.getFile("/overlay/foo.h"));
+  EXPECT_EQ(9, file->getSize());
+
+  OwningPtr<llvm::MemoryBuffer> buffer(manager.getBufferForFile(file));
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ("int foo;\n", buffer->getBuffer());
+
+  buffer.reset(manager.getBufferForFile("../foo.h"));
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ("int foo;\n", buffer->getBuffer());
+
+  EXPECT_EQ(NULL, manager.getFile("foo.h"));
+}
+
+// File managers sharing a stat cache see what the others have found.
+TEST(FileManagerSharedStatsTest, getFileUsesTheSharedStatCache) {
+  FileSystemOptions options;
+  options.SharedStats = new SharedStatCache(/*CacheFailures=*/true);
+
+  FileManager first(options);
+  FakeStatCache *statCache = new FakeStatCache;
+  statCache->InjectDirectory("/abc", 41);
+  statCache->InjectFile("/abc/foo.cpp", 42);
+  first.addStatCache(statCache);
+  EXPECT_TRUE(first.getFile("/abc/foo.cpp") != NULL);
+  EXPECT_EQ(NULL, first.getFile("/abc/bar.cpp"));
+
+  // The second file manager only knows about the files through the shared
+  // cache.
+  FileManager second(options);
+  second.addStatCache(new FakeStatCache);
+  unsigned hits = options.SharedStats->getNumHits();
+  const FileEntry *file = second.getFile("/abc/foo.cpp");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(42u, file->getUniqueID().getFile());
+  EXPECT_EQ(NULL, second.getFile("/abc/bar.cpp"));
+  // "/abc", "/abc/foo.cpp" and "/abc/bar.cpp".
+  EXPECT_EQ(hits + 3, options.SharedStats->getNumHits());
+
+  // None of these paths exist on disk, so revalidating drops them all.
+  options.SharedStats->revalidate();
+  FileManager third(options);
+  third.addStatCache(new FakeStatCache);
+  hits = options.SharedStats->getNumHits();
+  EXPECT_EQ(NULL, third.getFile("/abc/foo.cpp"));
+  EXPECT_EQ(hits, options.SharedStats->getNumHits());
+}
+
+// By default, a path missing for one file manager may exist for the next.
+TEST(FileManagerSharedStatsTest, getFileDoesNotShareFailuresByDefault) {
+  FileSystemOptions options;
+  options.SharedStats = new SharedStatCache();
+
+  FileManager first(options);
+  FakeStatCache *statCache = new FakeStatCache;
+  statCache->InjectDirectory("/abc", 41);
+  first.addStatCache(statCache);
+  EXPECT_EQ(NULL, first.getFile("/abc/foo.cpp"));
+
+  FileManager second(options);
+  statCache = new FakeStatCache;
+  statCache->InjectFile("/abc/foo.cpp", 42);
+  second.addStatCache(statCache);
+  const FileEntry *file = second.getFile("/abc/foo.cpp");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(42u, file->getUniqueID().getFile());
+}
+
 #endif  // !_WIN32
 
 } // anonymous namespace
@@ -0,0 +1,145 @@
+//===- unittests/Basic/KeyedLineStoreTest.cpp - KeyedLineStore tests ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/KeyedLineStore.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+class KeyedLineStoreTest : public ::testing::Test {
+protected:
+  SmallString<128> Path;
+
+  virtual void SetUp() {
+    int FD;
+    ASSERT_FALSE(sys::fs::createTemporaryFile("keyed-line-store", "txt", FD,
+                                              Path));
+    raw_fd_ostream Out(FD, true);
+    Out << "ignored before the sections\n"
+        << "# HEADER 1\n"
+        << "1 2 a key\n"
+        << "3 short\n"
+        << "4  empty-field\n"
+        << "5 6 \n"
+        << "7 8 other\n"
+        << "# HEADER 2\n"
+        << "9 9 second";
+  }
+
+  virtual void TearDown() {
+    bool Existed;
+    sys::fs::remove(Path.str(), Existed);
+  }
+};
+
+static void keepOld(std::string &Old, StringRef New) {}
+
+TEST_F(KeyedLineStoreTest, SkipsMalformedLines) {
+  KeyedLineStore Store(Path, "HEADER 1", 2);
+  KeyedLineStore::EntryMap Entries;
+  Store.read(Entries);
+
+  EXPECT_EQ(2u, Entries.size());
+  EXPECT_EQ("1 2", Entries["a key"]);
+  EXPECT_EQ("7 8", Entries["other"]);
+}
+
+TEST_F(KeyedLineStoreTest, ReadsOnlyItsSection) {
+  KeyedLineStore Store(Path, "HEADER 2", 2);
+  KeyedLineStore::EntryMap Entries;
+  Store.read(Entries);
+
+  EXPECT_EQ(1u, Entries.size());
+  EXPECT_EQ("9 9", Entries["second"]);
+
+  Store.setHeader("HEADER 3");
+  Entries.clear();
+  Store.read(Entries);
+  EXPECT_TRUE(Entries.empty());
+}
+
+TEST_F(KeyedLineStoreTest, MergesIntoCurrentContents) {
+  KeyedLineStore Store(Path, "HEADER 1", 2);
+  KeyedLineStore::EntryMap Recorded;
+  Recorded["a key"] = "9 9";
+  Recorded["new"] = "0 0";
+  ASSERT_FALSE(Store.update(Recorded, keepOld));
+
+  KeyedLineStore::EntryMap Entries;
+  Store.read(Entries);
+  EXPECT_EQ(3u, Entries.size());
+  EXPECT_EQ("1 2", Entries["a key"]);
+  EXPECT_EQ("7 8", Entries["other"]);
+  EXPECT_EQ("0 0", Entries["new"]);
+
+  ASSERT_FALSE(Store.update(Recorded));
+  Entries.clear();
+  Store.read(Entries);
+  EXPECT_EQ("9 9", Entries["a key"]);
+}
+
+TEST_F(KeyedLineStoreTest, KeepsSectionsOfOtherHeaders) {
+  KeyedLineStore Store(Path, "HEADER 3", 2);
+  KeyedLineStore::EntryMap Recorded;
+  Recorded["third"] = "0 0";
+  ASSERT_FALSE(Store.update(Recorded));
+
+  KeyedLineStore::EntryMap Entries;
+  Store.read(Entries);
+  EXPECT_EQ(1u, Entries.size());
+  EXPECT_EQ("0 0", Entries["third"]);
+
+  Store.setHeader("HEADER 1");
+  Entries.clear();
+  Store.read(Entries);
+  EXPECT_EQ(2u, Entries.size());
+  EXPECT_EQ("1 2", Entries["a key"]);
+
+  Store.setHeader("HEADER 2");
+  Entries.clear();
+  Store.read(Entries);
+  EXPECT_EQ(1u, Entries.size());
+  EXPECT_EQ("9 9", Entries["second"]);
+}
+
+TEST_F(KeyedLineStoreTest, DropsLeastRecentlyUpdatedSections) {
+  KeyedLineStore Store(Path, "", 2, /*MaxSections=*/3);
+  KeyedLineStore::EntryMap Recorded;
+  Recorded["key"] = "0 0";
+  for (unsigned I = 0; I != 2; ++I) {
+    SmallString<16> Header;
+    raw_svector_ostream(Header) << "NEW " << I;
+    Store.setHeader(Header.str());
+    ASSERT_FALSE(Store.update(Recorded));
+  }
+
+  // The sections are ordered from the one updated last, so HEADER 2 goes
+  // first.
+  KeyedLineStore::EntryMap Entries;
+  Store.setHeader("HEADER 2");
+  Store.read(Entries);
+  EXPECT_TRUE(Entries.empty());
+
+  Store.setHeader("HEADER 1");
+  Store.read(Entries);
+  EXPECT_EQ(2u, Entries.size());
+
+  Store.setHeader("NEW 0");
+  Entries.clear();
+  Store.read(Entries);
+  EXPECT_EQ(1u, Entries.size());
+}
+
+} // anonymous namespace
@@ -351,4 +351,58 @@ TEST_F(SourceManagerTest, isBeforeInTranslationUnitWithMacroInInclude) {
 
 #endif
 
+// Creates NumFiles files of various sizes, with a macro expansion after every
+// third one.  Records the FileID and size of each file, and the start of each
+// expansion.
+static void createManyFileIDs(SourceManager &SM, unsigned NumFiles,
+                              std::vector<FileID> &FIDs,
+                              std::vector<unsigned> &Sizes,
+                              std::vector<SourceLocation> &Expansions) {
+  for (unsigned i = 0; i != NumFiles; ++i) {
+    MemoryBuffer *Buf =
+        MemoryBuffer::getMemBufferCopy(std::string(i % 37 + 1, 'x'));
+    FileID FID = SM.createFileIDForMemBuffer(Buf);
+    FIDs.push_back(FID);
+    // Files also contain their end location.
+    Sizes.push_back(Buf->getBufferSize() + 1);
+
+    if (i % 3 == 0) {
+      SourceLocation Start = SM.getLocForStartOfFile(FID);
+      Expansions.push_back(SM.createExpansionLoc(Start, Start, Start, 5));
+    }
+  }
+}
+
+TEST_F(SourceManagerTest, getFileIDOfManyEntries) {
+  std::vector<FileID> FIDs;
+  std::vector<unsigned> Sizes;
+  std::vector<SourceLocation> Expansions;
+  createManyFileIDs(SourceMgr, 300, FIDs, Sizes, Expansions);
+
+  // Visit the locations in a scrambled order, so that lookups are rarely near
+  // the previous one.
+  unsigned Seed = 1;
+  for (unsigned n = 0; n != 20000; ++n) {
+    Seed = Seed * 1103515245 + 12345;
+    unsigned i = (Seed >> 8) % FIDs.size();
+    unsigned Offset = (Seed >> 4) % Sizes[i];
+    SourceLocation Loc =
+        SourceMgr.getLocForStartOfFile(FIDs[i]).getLocWithOffset(Offset);
+    ASSERT_EQ(FIDs[i], SourceMgr.getFileID(Loc));
+
+    // Alternate with a lookup in another file.
+    unsigned j = (i * 7 + 1) % FIDs.size();
+    ASSERT_EQ(FIDs[j], SourceMgr.getFileID(
+                           SourceMgr.getLocForStartOfFile(FIDs[j])));
+  }
+
+  for (unsigned i = 0, e = Expansions.size(); i != e; ++i) {
+    FileID FID = SourceMgr.getFileID(Expansions[i]);
+    EXPECT_TRUE(SourceMgr.getSLocEntry(FID).isExpansion());
+    for (unsigned Offset = 0; Offset != 6; ++Offset)
+      EXPECT_EQ(FID,
+                SourceMgr.getFileID(Expansions[i].getLocWithOffset(Offset)));
+  }
+}
+
 } // anonymous namespace
@@ -194,6 +194,30 @@ TEST_F(FormatTest, FormatsCorrectRegionForLeadingWhitespace) {
                    25, 0, getLLVMStyleWithColumns(12)));
 }
 
+TEST_F(FormatTest, FormatsLinesJoinedWithFormattedRange) {
+  FormatStyle AllowsMergedIf = getLLVMStyle();
+  AllowsMergedIf.AllowShortIfStatementsOnASingleLine = true;
+  std::string Code = "int   a;\n"
+                     "int   b;\n"
+                     "if(a)\n"
+                     "return;\n"
+                     "int   c;\n"
+                     "int   d;";
+  EXPECT_EQ("int   a;\n"
+            "int   b;\n"
+            "if (a) return;\n"
+            "int   c;\n"
+            "int   d;",
+            format(Code, 26, 1, AllowsMergedIf));
+  EXPECT_EQ("int   a;\n"
+            "int   b;\n"
+            "if(a)\n"
+            "return;\n"
+            "int c;\n"
+            "int   d;",
+            format(Code, 34, 0, AllowsMergedIf));
+}
+
 TEST_F(FormatTest, RemovesWhitespaceWhenTriggeredOnEmptyLine) {
   EXPECT_EQ("int  a;\n\n int b;",
             format("int  a;\n  \n\n int b;", 7, 0, getLLVMStyle()));
@@ -2883,6 +2907,26 @@ TEST_F(FormatTest, MemoizationTests) {
   verifyFormat(input, OnePerLine);
 }
 
+TEST_F(FormatTest, CompletesLinesGreedilyWhenOutOfStates) {
+  FormatStyle Style = getLLVMStyleWithColumns(40);
+  Style.MaxAnalyzedStatesPerLine = 1;
+  std::string Code = "int i = function(aaaaaaaaaa, bbbbbbbbbb(cccccccccc, "
+                     "dddddddddd), eeeeeeeeee + ffffffffff);";
+  std::string Result = format(Code, Style);
+  std::string Stripped;
+  for (unsigned i = 0, e = Result.size(); i != e; ++i)
+    if (Result[i] != ' ' && Result[i] != '\n')
+      Stripped += Result[i];
+  EXPECT_EQ("inti=function(aaaaaaaaaa,bbbbbbbbbb(cccccccccc,dddddddddd),"
+            "eeeeeeeeee+ffffffffff);",
+            Stripped);
+  SmallVector<StringRef, 4> Lines;
+  StringRef(Result).split(Lines, "\n");
+  EXPECT_LT(1u, Lines.size());
+  for (unsigned i = 0, e = Lines.size(); i != e; ++i)
+    EXPECT_GE(40u, Lines[i].size()) << Lines[i].str();
+}
+
 TEST_F(FormatTest, BreaksAsHighAsPossible) {
   verifyFormat(
       "void f() {\n"
@@ -6842,6 +6886,8 @@ TEST_F(FormatTest, ParsesConfiguration) {
   CHECK_PARSE("ConstructorInitializerIndentWidth: 1234",
               ConstructorInitializerIndentWidth, 1234u);
   CHECK_PARSE("ColumnLimit: 1234", ColumnLimit, 1234u);
+  CHECK_PARSE("MaxAnalyzedStatesPerLine: 1234", MaxAnalyzedStatesPerLine,
+              1234u);
   CHECK_PARSE("MaxEmptyLinesToKeep: 1234", MaxEmptyLinesToKeep, 1234u);
   CHECK_PARSE("PenaltyBreakBeforeFirstCallParameter: 1234",
               PenaltyBreakBeforeFirstCallParameter, 1234u);
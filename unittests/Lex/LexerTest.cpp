@@ -355,4 +355,70 @@ TEST_F(LexerTest, LexAPI) {
   EXPECT_EQ("N", Lexer::getImmediateMacroName(idLoc4, SourceMgr, LangOpts));
 }
 
+TEST_F(LexerTest, LexLongTokens) {
+  // Tokens, comments and whitespace spanning several 16-byte blocks.
+  std::string Ident = std::string(37, 'a') + "_Zz09";
+  std::string Str = "\"" + std::string(20, 'y') + "\\\"" +
+                    std::string(20, '?') + "\\\n" + std::string(20, 'z') +
+                    "\"";
+  std::string Source =
+      "int " + Ident + " = 1; // " + std::string(37, 'x') + "\n" +
+      std::string(35, ' ') + "\t\t" + "const char *" + Ident + "$ = " + Str +
+      ";\n" +
+      "// A line comment with an escaped \\\n" +
+      "newline" + std::string(40, 'w') + "\n" +
+      "int tail;";
+
+  std::vector<tok::TokenKind> ExpectedTokens;
+  ExpectedTokens.push_back(tok::kw_int);
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::equal);
+  ExpectedTokens.push_back(tok::numeric_constant);
+  ExpectedTokens.push_back(tok::semi);
+  ExpectedTokens.push_back(tok::kw_const);
+  ExpectedTokens.push_back(tok::kw_char);
+  ExpectedTokens.push_back(tok::star);
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::equal);
+  ExpectedTokens.push_back(tok::string_literal);
+  ExpectedTokens.push_back(tok::semi);
+  ExpectedTokens.push_back(tok::kw_int);
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::semi);
+
+  std::vector<Token> toks = CheckLex(Source, ExpectedTokens);
+  ASSERT_EQ(ExpectedTokens.size(), toks.size());
+
+  EXPECT_EQ(Ident.size(), toks[1].getLength());
+  EXPECT_EQ(Ident.size() + 1, toks[8].getLength());
+  EXPECT_EQ(Str.size(), toks[10].getLength());
+  EXPECT_TRUE(toks[5].isAtStartOfLine());
+  EXPECT_TRUE(toks[5].hasLeadingSpace());
+  EXPECT_EQ("tail", toks[13].getIdentifierInfo()->getName());
+}
+
+TEST_F(LexerTest, ExpandMacroArguments) {
+  // Arguments looked up out of order, and stringified string and character
+  // literals.
+  std::string Source =
+      "#define STR(x) #x\n"
+      "#define PICK(a, b, c, d, e, f, g, h, i, j) j i a\n"
+      "PICK(1, 2, 3, 4, 5, 6, 7, 8, 9, 10) STR(\"a\\\\b\" 'c' x)\n";
+
+  std::vector<tok::TokenKind> ExpectedTokens;
+  ExpectedTokens.push_back(tok::numeric_constant);
+  ExpectedTokens.push_back(tok::numeric_constant);
+  ExpectedTokens.push_back(tok::numeric_constant);
+  ExpectedTokens.push_back(tok::string_literal);
+
+  std::vector<Token> toks = CheckLex(Source, ExpectedTokens);
+  ASSERT_EQ(ExpectedTokens.size(), toks.size());
+
+  EXPECT_EQ("10", Lexer::getSpelling(toks[0], SourceMgr, LangOpts));
+  EXPECT_EQ("9", Lexer::getSpelling(toks[1], SourceMgr, LangOpts));
+  EXPECT_EQ("1", Lexer::getSpelling(toks[2], SourceMgr, LangOpts));
+  EXPECT_EQ("\"\\\"a\\\\\\\\b\\\" 'c' x\"",
+            Lexer::getSpelling(toks[3], SourceMgr, LangOpts));
+}
+
 } // anonymous namespace
@@ -14,7 +14,9 @@
 #include "clang/Tooling/FileMatchTrie.h"
 #include "clang/Tooling/JSONCompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 namespace clang {
@@ -38,6 +40,10 @@ TEST(JSONCompilationDatabase, ErrsOnInvalidFormat) {
   expectFailure("[{\"directory\":\"\",\"command\":\"\"}]", "Missing file");
   expectFailure("[{\"directory\":\"\",\"file\":\"\"}]", "Missing command");
   expectFailure("[{\"command\":\"\",\"file\":\"\"}]", "Missing directory");
+  expectFailure("[{\"directory\":\"\",\"command\":\"\",\"file\":\"\"},]",
+                "Trailing comma");
+  expectFailure("[] []", "Trailing garbage");
+  expectFailure("[{\"file\":\"", "Unterminated string");
 }
 
 static std::vector<std::string> getAllFiles(StringRef JSONDatabase,
@@ -291,6 +297,56 @@ TEST(findCompileArgsInJsonDatabase, FindsEntry) {
   EXPECT_EQ("command4", FoundCommand.CommandLine[0]) << ErrorMessage;
 }
 
+TEST(findCompileArgsInJsonDatabase, DecodesJSONEscapes) {
+  std::string ErrorMessage;
+  CompileCommand FoundCommand = findCompileArgsInJsonDatabase(
+    "//net/dir\xc3\xa9/file",
+    "[{\"directory\":\"//net/dir\\u00e9\","
+      "\"command\":\"a\\u0020b\\/c\","
+      "\"file\":\"fil\\u0065\"}]",
+    ErrorMessage);
+  EXPECT_EQ("//net/dir\xc3\xa9", FoundCommand.Directory) << ErrorMessage;
+  ASSERT_EQ(2u, FoundCommand.CommandLine.size()) << ErrorMessage;
+  EXPECT_EQ("a", FoundCommand.CommandLine[0]) << ErrorMessage;
+  EXPECT_EQ("b/c", FoundCommand.CommandLine[1]) << ErrorMessage;
+}
+
+TEST(JSONCompilationDatabase, ReusesIndexFile) {
+  int FD;
+  SmallString<128> DatabasePath;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("compile_commands", "json",
+                                                  FD, DatabasePath));
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "[{\"directory\":\"//net/dir\",\"command\":\"first\","
+          "\"file\":\"file\"},"
+          "{\"directory\":\"//net/other\",\"command\":\"other\","
+          "\"file\":\"file\"},"
+          "{\"directory\":\"//net/dir\",\"command\":\"second\","
+          "\"file\":\"file\"}]";
+  }
+  std::string IndexPath =
+      JSONCompilationDatabase::getIndexFilePath(DatabasePath);
+
+  for (unsigned Load = 0; Load != 2; ++Load) {
+    std::string ErrorMessage;
+    OwningPtr<JSONCompilationDatabase> Database(
+        JSONCompilationDatabase::loadFromFile(DatabasePath, ErrorMessage,
+                                              /*UseIndexFile=*/true));
+    ASSERT_TRUE(Database) << ErrorMessage;
+    EXPECT_TRUE(llvm::sys::fs::exists(IndexPath));
+    EXPECT_EQ(2u, Database->getAllFiles().size());
+    std::vector<CompileCommand> Commands =
+        Database->getCompileCommands("//net/dir/file");
+    ASSERT_EQ(2u, Commands.size());
+    EXPECT_EQ("first", Commands[0].CommandLine[0]);
+    EXPECT_EQ("second", Commands[1].CommandLine[0]);
+  }
+
+  llvm::sys::fs::remove(IndexPath);
+  llvm::sys::fs::remove(DatabasePath.str());
+}
+
 static std::vector<std::string> unescapeJsonCommandLine(StringRef Command) {
   std::string JsonDatabase =
     ("[{\"directory\":\"//net/root\", \"file\":\"test\", \"command\": \"" +
@@ -18,6 +18,9 @@
 #include "clang/Tooling/Tooling.h"
 #include "gtest/gtest.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include <string>
 
 namespace clang {
@@ -157,6 +160,35 @@ TEST(ToolInvocation, TestMapVirtualFile) {
   EXPECT_TRUE(Invocation.run());
 }
 
+TEST(ToolInvocation, SharesPreamblesThroughPreambleCache) {
+  IntrusiveRefCntPtr<clang::FileManager> Files(
+      new clang::FileManager(clang::FileSystemOptions()));
+  PreambleCache Preambles;
+  const char *const Sources[] = { "/dir/a.cc", "/dir/b.cc", "/dir/c.cc" };
+  const char *const Contents[] = {
+    "#include \"h.h\"\nint a = f();\n",
+    "#include \"h.h\"\nint b = f();\n",
+    "#include \"h.h\"\n#include \"h.h\"\nint c = f();\n"
+  };
+  for (unsigned I = 0; I != 3; ++I) {
+    std::vector<std::string> Args;
+    Args.push_back("tool-executable");
+    Args.push_back("-fsyntax-only");
+    Args.push_back(Sources[I]);
+    clang::tooling::ToolInvocation Invocation(Args, new SyntaxOnlyAction,
+                                              Files.getPtr());
+    Invocation.setPreambleCache(&Preambles);
+    for (unsigned J = 0; J != 3; ++J)
+      Invocation.mapVirtualFile(Sources[J], Contents[J]);
+    Invocation.mapVirtualFile("/dir/h.h", "#pragma once\n"
+                                          "inline int f() { return 0; }\n");
+    EXPECT_TRUE(Invocation.run());
+  }
+  // c.cc has a different preamble, so it gets one of its own.
+  EXPECT_EQ(2u, Preambles.getNumMisses());
+  EXPECT_EQ(1u, Preambles.getNumHits());
+}
+
 TEST(ToolInvocation, TestVirtualModulesCompilation) {
   // FIXME: Currently, this only tests that we don't exit with an error if a
   // mapped module.map is found on the include path. In the future, expand this
@@ -301,6 +333,93 @@ TEST(ClangToolTest, BuildASTs) {
   llvm::DeleteContainerPointers(ASTs);
 }
 
+TEST(ClangToolTest, BuildASTsInParallel) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+
+  std::vector<std::string> Sources;
+  Sources.push_back("/a.cc");
+  Sources.push_back("/b.cc");
+  Sources.push_back("/c.cc");
+  ClangTool Tool(Compilations, Sources);
+  Tool.setNumThreads(2);
+
+  Tool.mapVirtualFile("/a.cc", "void a() {}");
+  Tool.mapVirtualFile("/b.cc", "void b() {}");
+  Tool.mapVirtualFile("/c.cc", "void c() {}");
+
+  std::vector<ASTUnit *> ASTs;
+  EXPECT_EQ(0, Tool.buildASTs(ASTs));
+  EXPECT_EQ(3u, ASTs.size());
+
+  llvm::DeleteContainerPointers(ASTs);
+}
+
+/// \brief Compiles each file by its name, relative to its directory.
+class RelativePathCompilationDatabase : public CompilationDatabase {
+public:
+  virtual std::vector<CompileCommand>
+  getCompileCommands(StringRef FilePath) const {
+    std::vector<std::string> CommandLine;
+    CommandLine.push_back("clang-tool");
+    CommandLine.push_back(llvm::sys::path::filename(FilePath));
+    return std::vector<CompileCommand>(
+        1, CompileCommand(llvm::sys::path::parent_path(FilePath),
+                          CommandLine));
+  }
+  virtual std::vector<std::string> getAllFiles() const {
+    return std::vector<std::string>();
+  }
+  virtual std::vector<CompileCommand> getAllCompileCommands() const {
+    return std::vector<CompileCommand>();
+  }
+};
+
+TEST(ClangToolTest, BuildASTsInParallelFromRelativePaths) {
+  std::vector<std::string> Sources;
+  for (unsigned I = 0; I != 2; ++I) {
+    SmallString<128> Path;
+    int FD;
+    ASSERT_FALSE(
+        llvm::sys::fs::createTemporaryFile("relative", "cc", FD, Path));
+    llvm::raw_fd_ostream Out(FD, true);
+    Out << "void f" << I << "() {}\n";
+    Sources.push_back(Path.str());
+  }
+
+  RelativePathCompilationDatabase Compilations;
+  ClangTool Tool(Compilations, Sources);
+  Tool.setNumThreads(2);
+
+  std::vector<ASTUnit *> ASTs;
+  EXPECT_EQ(0, Tool.buildASTs(ASTs));
+  EXPECT_EQ(2u, ASTs.size());
+
+  llvm::DeleteContainerPointers(ASTs);
+  for (unsigned I = 0, E = Sources.size(); I != E; ++I) {
+    bool Existed;
+    llvm::sys::fs::remove(Sources[I], Existed);
+  }
+}
+
+TEST(ClangToolTest, MapsCopiesOfVirtualFiles) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+
+  std::vector<std::string> Sources;
+  Sources.push_back("/a.cc");
+  Sources.push_back("/b.cc");
+  ClangTool Tool(Compilations, Sources);
+  Tool.setNumThreads(2);
+
+  {
+    std::string Header = "int h();";
+    Tool.mapVirtualFile("/h.h", Header);
+  }
+  Tool.mapVirtualFile("/a.cc", "#include \"/h.h\"\nint a = h();");
+  Tool.mapVirtualFile("/b.cc", "#include \"/h.h\"\nint b = h();");
+
+  EXPECT_EQ(0, Tool.run(newFrontendActionFactory<SyntaxOnlyAction>()));
+}
+
 struct TestDiagnosticConsumer : public DiagnosticConsumer {
   TestDiagnosticConsumer() : NumDiagnosticsSeen(0) {}
   virtual void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
@@ -320,6 +439,21 @@ TEST(ClangToolTest, InjectDiagnosticConsumer) {
   EXPECT_EQ(1u, Consumer.NumDiagnosticsSeen);
 }
 
+TEST(ClangToolTest, InjectDiagnosticConsumerInParallel) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  Sources.push_back("/a.cc");
+  Sources.push_back("/b.cc");
+  ClangTool Tool(Compilations, Sources);
+  Tool.setNumThreads(2);
+  Tool.mapVirtualFile("/a.cc", "int x = undeclared;");
+  Tool.mapVirtualFile("/b.cc", "int y = undeclared;");
+  TestDiagnosticConsumer Consumer;
+  Tool.setDiagnosticConsumer(&Consumer);
+  EXPECT_EQ(1, Tool.run(newFrontendActionFactory<SyntaxOnlyAction>()));
+  EXPECT_EQ(2u, Consumer.NumDiagnosticsSeen);
+}
+
 TEST(ClangToolTest, InjectDiagnosticConsumerInBuildASTs) {
   FixedCompilationDatabase Compilations("/", std::vector<std::string>());
   ClangTool Tool(Compilations, std::vector<std::string>(1, "/a.cc"));